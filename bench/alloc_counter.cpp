@@ -0,0 +1,112 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+#include "bench_harness.hpp"
+
+// Counting replacements for the global allocation functions. The standard library's array and
+// nothrow forms forward to these, but a sanitizer runtime supplies its own, so they are replaced
+// here as well to keep every new paired with this file's delete. The aligned forms are replaced
+// too, since std::pmr::new_delete_resource() allocates through them.
+namespace {
+
+std::atomic<std::uint64_t> allocations{0};
+
+void* aligned_memory(const std::size_t size, const std::size_t alignment) {
+#if defined(_WIN32)
+    return _aligned_malloc(size == 0 ? 1 : size, alignment);
+#else
+    // aligned_alloc wants a multiple of the alignment.
+    const std::size_t rounded = (std::max<std::size_t>(size, 1) + alignment - 1) / alignment * alignment;
+    return std::aligned_alloc(alignment, rounded);
+#endif
+}
+
+void free_aligned_memory(void* memory) {
+#if defined(_WIN32)
+    _aligned_free(memory);
+#else
+    std::free(memory);
+#endif
+}
+
+} // namespace
+
+std::uint64_t piano_assist::bench::allocation_count() {
+    return allocations.load(std::memory_order_relaxed);
+}
+
+void* operator new(const std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* memory = std::malloc(size == 0 ? 1 : size)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+void* operator new(const std::size_t size, const std::nothrow_t&) noexcept {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept {
+    std::free(memory);
+}
+
+void* operator new[](const std::size_t size) {
+    return operator new(size);
+}
+
+void* operator new[](const std::size_t size, const std::nothrow_t& tag) noexcept {
+    return operator new(size, tag);
+}
+
+void operator delete[](void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept {
+    std::free(memory);
+}
+
+void* operator new(const std::size_t size, const std::align_val_t alignment) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* memory = aligned_memory(size, static_cast<std::size_t>(alignment))) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory, std::align_val_t) noexcept {
+    free_aligned_memory(memory);
+}
+
+void operator delete(void* memory, std::size_t, std::align_val_t) noexcept {
+    free_aligned_memory(memory);
+}
+
+void* operator new[](const std::size_t size, const std::align_val_t alignment) {
+    return operator new(size, alignment);
+}
+
+void operator delete[](void* memory, std::align_val_t) noexcept {
+    free_aligned_memory(memory);
+}
+
+void operator delete[](void* memory, std::size_t, std::align_val_t) noexcept {
+    free_aligned_memory(memory);
+}
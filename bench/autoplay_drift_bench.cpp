@@ -0,0 +1,84 @@
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "piano_assist/autoplay.hpp"
+#include "piano_assist/compiled_sheet.hpp"
+
+namespace {
+
+using namespace std::chrono_literals;
+
+constexpr int kTempo = 600;
+constexpr std::chrono::microseconds kBudget = 1ms;
+
+piano_assist::CompiledSheet make_sheet_lasting(const std::chrono::seconds duration) {
+    constexpr std::string_view kKeys = "1234567890qwertyuiopasdfghjklzxcvbnm";
+    std::mt19937 rng(0xD21F7);
+    std::uniform_int_distribution<std::size_t> key_pick(0, kKeys.size() - 1);
+    std::uniform_int_distribution<int> sustain_pick(0, 2);
+
+    const long long total_steps = duration.count() * kTempo / 60;
+    std::vector<piano_assist::NoteGroup> groups;
+    long long steps = 0;
+    while (steps < total_steps) {
+        std::string keys(1, kKeys[key_pick(rng)]);
+        const int sustain = sustain_pick(rng);
+        keys.append(static_cast<std::size_t>(sustain), '-');
+        steps += 1 + sustain;
+        groups.push_back(piano_assist::NoteGroup{keys, true});
+    }
+    return piano_assist::compile_sheet(std::move(groups));
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::chrono::seconds duration = 10s;
+    for (int index = 1; index + 1 < argc; ++index) {
+        if (std::string_view(argv[index]) == "--seconds") {
+            duration = std::chrono::seconds(std::strtoll(argv[index + 1], nullptr, 10));
+        }
+    }
+
+    const piano_assist::CompiledSheet sheet = make_sheet_lasting(duration);
+    piano_assist::AutoplayTimeline timeline = piano_assist::build_autoplay_timeline(sheet, '-', kTempo);
+    const std::size_t event_count = timeline.group_count();
+    std::vector<std::chrono::nanoseconds> lateness(event_count + 1);
+
+    piano_assist::DeadlineScheduler scheduler;
+    scheduler.start(std::move(timeline), 0, [&lateness](const std::size_t index, const std::chrono::nanoseconds late) {
+        lateness[index] = late;
+    });
+    while (scheduler.running()) {
+        std::this_thread::sleep_for(50ms);
+    }
+
+    std::vector<std::chrono::nanoseconds> sorted(lateness.begin() + 1, lateness.end());
+    std::sort(sorted.begin(), sorted.end());
+    std::chrono::nanoseconds total{};
+    for (const std::chrono::nanoseconds value : sorted) {
+        total += value;
+    }
+    const auto to_us = [](const std::chrono::nanoseconds value) {
+        return std::chrono::duration<double, std::micro>(value).count();
+    };
+    const std::chrono::nanoseconds worst = sorted.empty() ? 0ns : sorted.back();
+    const std::chrono::nanoseconds p99 = sorted.empty() ? 0ns : sorted[sorted.size() * 99 / 100];
+
+    std::cout << "autoplay.drift: " << duration.count() << " s, " << event_count << " events\n"
+              << "  mean lateness: " << (sorted.empty() ? 0.0 : to_us(total) / static_cast<double>(sorted.size()))
+              << " us\n"
+              << "  p99 lateness:  " << to_us(p99) << " us\n"
+              << "  max lateness:  " << to_us(worst) << " us\n"
+              << "  final drift:   " << to_us(lateness.back()) << " us\n"
+              << "  within 1 ms:   " << (worst < kBudget ? "yes" : "no") << '\n';
+    return 0;
+}
@@ -0,0 +1,292 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace piano_assist::bench {
+
+// Heap allocations made so far by the whole process. Defined in alloc_counter.cpp, which
+// replaces the global operator new; link it into every executable that uses this header.
+[[nodiscard]] std::uint64_t allocation_count();
+
+struct BenchResult {
+    std::string name{};
+    std::size_t iterations{0};
+    // Work units (notes, songs, lookups, ...) handled by one iteration.
+    std::size_t items_per_iteration{0};
+    double mean_ns{0.0};
+    double median_ns{0.0};
+    double min_ns{0.0};
+    // Fewest allocations seen in one iteration; unlike times, these repeat exactly run to run.
+    std::uint64_t allocations{0};
+
+    [[nodiscard]] double items_per_second() const {
+        return median_ns <= 0.0 ? 0.0 : static_cast<double>(items_per_iteration) * 1e9 / median_ns;
+    }
+};
+
+// Repeats a case until it has run for at least min_time, then reports per-iteration times.
+class BenchRunner final {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    BenchRunner(std::chrono::milliseconds min_time, std::size_t max_iterations, std::string filter)
+        : min_time_(min_time), max_iterations_(max_iterations), filter_(std::move(filter)) {}
+
+    [[nodiscard]] bool selected(const std::string_view name) const {
+        return filter_.empty() || name.find(filter_) != std::string_view::npos;
+    }
+
+    // setup() runs before every iteration and is not timed; body() receives its result.
+    template <typename Setup, typename Body>
+    void run(const std::string_view name, const std::size_t items_per_iteration, Setup&& setup, Body&& body) {
+        if (!selected(name)) {
+            return;
+        }
+
+        std::vector<double> samples;
+        std::uint64_t allocations = UINT64_MAX;
+        const Clock::time_point started = Clock::now();
+        while (samples.empty() || (Clock::now() - started < min_time_ && samples.size() < max_iterations_)) {
+            auto state = setup();
+            const std::uint64_t allocations_before = allocation_count();
+            const Clock::time_point begin = Clock::now();
+            body(state);
+            const Clock::time_point end = Clock::now();
+            allocations = std::min(allocations, allocation_count() - allocations_before);
+            samples.push_back(std::chrono::duration<double, std::nano>(end - begin).count());
+        }
+        record(name, items_per_iteration, std::move(samples), allocations);
+    }
+
+    template <typename Body>
+    void run(const std::string_view name, const std::size_t items_per_iteration, Body&& body) {
+        run(name, items_per_iteration, [] { return 0; }, [&body](int) { body(); });
+    }
+
+    [[nodiscard]] const std::vector<BenchResult>& results() const {
+        return results_;
+    }
+
+private:
+    std::chrono::milliseconds min_time_;
+    std::size_t max_iterations_;
+    std::string filter_;
+    std::vector<BenchResult> results_;
+
+    void record(
+        const std::string_view name,
+        const std::size_t items_per_iteration,
+        std::vector<double> samples,
+        const std::uint64_t allocations
+    ) {
+        std::sort(samples.begin(), samples.end());
+        double total = 0.0;
+        for (const double sample : samples) {
+            total += sample;
+        }
+
+        BenchResult result{};
+        result.name = std::string(name);
+        result.iterations = samples.size();
+        result.items_per_iteration = items_per_iteration;
+        result.mean_ns = total / static_cast<double>(samples.size());
+        result.median_ns = samples[samples.size() / 2];
+        result.min_ns = samples.front();
+        result.allocations = allocations;
+        results_.push_back(std::move(result));
+    }
+};
+
+// Feeds a value derived from a benchmarked result somewhere the optimizer can't discard.
+inline void keep(const std::size_t value) {
+    static volatile std::size_t sink = 0;
+    sink = sink + value;
+}
+
+inline void write_text(std::ostream& out, const std::vector<BenchResult>& results) {
+    for (const BenchResult& result : results) {
+        out << result.name << ": " << result.iterations << " iterations, median "
+            << result.median_ns / 1000.0 << " us, min " << result.min_ns / 1000.0 << " us, "
+            << static_cast<std::uint64_t>(result.items_per_second()) << " items/s, " << result.allocations
+            << " allocations\n";
+    }
+}
+
+inline void write_json(std::ostream& out, const std::string_view suite, const std::vector<BenchResult>& results) {
+    std::ostringstream json;
+    json << std::fixed << std::setprecision(1);
+    json << "{\n  \"suite\": \"" << suite << "\",\n  \"results\": [";
+    for (std::size_t index = 0; index < results.size(); ++index) {
+        const BenchResult& result = results[index];
+        json << (index == 0 ? "\n" : ",\n") << "    {\"name\": \"" << result.name << "\", \"iterations\": "
+             << result.iterations << ", \"items_per_iteration\": " << result.items_per_iteration
+             << ", \"mean_ns\": " << result.mean_ns << ", \"median_ns\": " << result.median_ns
+             << ", \"min_ns\": " << result.min_ns << ", \"items_per_second\": " << result.items_per_second()
+             << ", \"allocations\": " << result.allocations << '}';
+    }
+    json << (results.empty() ? "]" : "\n  ]") << "\n}\n";
+    out << json.str();
+}
+
+// A committed write_baseline() file. A case fails when its median exceeds the baseline by more than
+// time_tolerance (1.0 = twice as slow) or its allocations by more than allocation_tolerance (a
+// fraction, rounded down, so small counts stay exact). Listing, sorting and hashing a directory
+// can allocate a few times more or less depending on the order the file system returns entries,
+// which is what the small default allows for. Adding either key to one case's line overrides the
+// file-wide value for that case; write_baseline() keeps such overrides.
+struct BaselineCase {
+    std::string name{};
+    double median_ns{0.0};
+    std::uint64_t allocations{0};
+    std::optional<double> time_tolerance{};
+    std::optional<double> allocation_tolerance{};
+};
+
+struct Baseline {
+    double time_tolerance{1.0};
+    double allocation_tolerance{0.001};
+    std::vector<BaselineCase> cases{};
+};
+
+namespace detail {
+
+// Just enough JSON for the one-object-per-line files written here.
+inline std::optional<double> number_after(const std::string_view text, const std::string_view key) {
+    const std::string quoted = "\"" + std::string(key) + "\":";
+    const std::size_t at = text.find(quoted);
+    if (at == std::string_view::npos) {
+        return std::nullopt;
+    }
+    return std::strtod(std::string(text.substr(at + quoted.size())).c_str(), nullptr);
+}
+
+inline std::string string_after(const std::string_view text, const std::string_view key) {
+    const std::string quoted = "\"" + std::string(key) + "\": \"";
+    const std::size_t at = text.find(quoted);
+    if (at == std::string_view::npos) {
+        return {};
+    }
+    const std::size_t begin = at + quoted.size();
+    return std::string(text.substr(begin, text.find('"', begin) - begin));
+}
+
+} // namespace detail
+
+inline Baseline read_baseline(std::istream& in) {
+    Baseline baseline{};
+    std::string line;
+    bool in_results = false;
+    while (std::getline(in, line)) {
+        if (!in_results) {
+            in_results = line.find("\"results\"") != std::string::npos;
+            baseline.time_tolerance = detail::number_after(line, "time_tolerance").value_or(baseline.time_tolerance);
+            baseline.allocation_tolerance =
+                detail::number_after(line, "allocation_tolerance").value_or(baseline.allocation_tolerance);
+            continue;
+        }
+        const std::string name = detail::string_after(line, "name");
+        if (name.empty()) {
+            continue;
+        }
+        BaselineCase entry{};
+        entry.name = name;
+        entry.median_ns = detail::number_after(line, "median_ns").value_or(0.0);
+        entry.allocations = static_cast<std::uint64_t>(detail::number_after(line, "allocations").value_or(0.0));
+        entry.time_tolerance = detail::number_after(line, "time_tolerance");
+        entry.allocation_tolerance = detail::number_after(line, "allocation_tolerance");
+        baseline.cases.push_back(std::move(entry));
+    }
+    return baseline;
+}
+
+// Records results as a new baseline with previous's tolerances, including per-case overrides.
+inline void write_baseline(
+    std::ostream& out,
+    const std::string_view suite,
+    const std::vector<BenchResult>& results,
+    const Baseline& previous
+) {
+    std::ostringstream json;
+    write_json(json, suite, results);
+    std::istringstream lines(json.str());
+    std::ostringstream baseline;
+    std::string line;
+    for (bool first = true; std::getline(lines, line); first = false) {
+        const std::string name = detail::string_after(line, "name");
+        const auto kept = std::find_if(previous.cases.begin(), previous.cases.end(), [&name](const BaselineCase& entry) {
+            return !name.empty() && entry.name == name;
+        });
+        if (kept != previous.cases.end() && (kept->time_tolerance || kept->allocation_tolerance)) {
+            const std::size_t close = line.rfind('}');
+            std::ostringstream overrides;
+            if (kept->time_tolerance) {
+                overrides << ", \"time_tolerance\": " << *kept->time_tolerance;
+            }
+            if (kept->allocation_tolerance) {
+                overrides << ", \"allocation_tolerance\": " << *kept->allocation_tolerance;
+            }
+            line.insert(close, overrides.str());
+        }
+        baseline << line << '\n';
+        if (first) {
+            baseline << "  \"time_tolerance\": " << previous.time_tolerance << ",\n  \"allocation_tolerance\": "
+                     << previous.allocation_tolerance << ",\n";
+        }
+    }
+    out << baseline.str();
+}
+
+// One message per regression. Baseline cases that did not run count as regressions, so a
+// renamed or filtered-out case can't pass silently; new cases without a baseline are ignored.
+// Medians are only comparable on the machine the baseline was recorded on; pass check_times = false
+// to gate on allocation counts alone, which depend only on the code and the toolchain.
+[[nodiscard]] inline std::vector<std::string> compare_to_baseline(
+    const std::vector<BenchResult>& results,
+    const Baseline& baseline,
+    const bool check_times = true
+) {
+    std::vector<std::string> regressions;
+    for (const BaselineCase& expected : baseline.cases) {
+        const auto found = std::find_if(results.begin(), results.end(), [&expected](const BenchResult& result) {
+            return result.name == expected.name;
+        });
+        if (found == results.end()) {
+            regressions.push_back(expected.name + ": did not run");
+            continue;
+        }
+
+        const double time_tolerance = expected.time_tolerance.value_or(baseline.time_tolerance);
+        const double allocation_tolerance = expected.allocation_tolerance.value_or(baseline.allocation_tolerance);
+        const auto allowed_allocations = expected.allocations +
+            static_cast<std::uint64_t>(static_cast<double>(expected.allocations) * allocation_tolerance);
+        std::ostringstream message;
+        message << std::fixed << std::setprecision(1);
+        if (found->allocations > allowed_allocations) {
+            message << expected.name << ": " << found->allocations << " allocations, baseline " << expected.allocations
+                    << " (at most " << allowed_allocations << " allowed)";
+            regressions.push_back(message.str());
+            message.str({});
+        }
+        if (check_times && found->median_ns > expected.median_ns * (1.0 + time_tolerance)) {
+            message << expected.name << ": median " << found->median_ns / 1000.0 << " us, baseline "
+                    << expected.median_ns / 1000.0 << " us (+" << time_tolerance * 100.0 << "% allowed)";
+            regressions.push_back(message.str());
+        }
+    }
+    return regressions;
+}
+
+} // namespace piano_assist::bench
@@ -0,0 +1,508 @@
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "bench_harness.hpp"
+#include "piano_assist/chord_matcher.hpp"
+#include "piano_assist/compiled_sheet.hpp"
+#include "piano_assist/library_generator.hpp"
+#include "piano_assist/overlay_layout.hpp"
+#include "piano_assist/playback_session.hpp"
+#include "piano_assist/scratch_arena.hpp"
+#include "piano_assist/sheet_preloader.hpp"
+#include "piano_assist/song_parser.hpp"
+#include "piano_assist/song_query.hpp"
+#include "piano_assist/song_repository.hpp"
+#include "piano_assist/tag_store.hpp"
+
+namespace {
+
+using piano_assist::bench::BenchRunner;
+using piano_assist::bench::keep;
+
+constexpr std::string_view kSuiteName = "SheetMaster_bench";
+constexpr std::string_view kKeys = "1234567890qwertyuiopasdfghjklzxcvbnm";
+constexpr std::size_t kSyntheticNoteCount = 50'000;
+constexpr std::size_t kDefaultLibrarySize = 2'000;
+constexpr std::size_t kTagLookupsPerIteration = 256;
+constexpr std::size_t kPlaybackTicksPerIteration = 100'000;
+constexpr std::uint64_t kLibrarySeed = 0x5EED;
+constexpr std::size_t kMigrationLibrarySize = 500;
+
+struct Options {
+    std::filesystem::path sheets{"sheets"};
+    // An existing library, e.g. from SheetMaster_generate_library, used in place of a generated one.
+    std::filesystem::path library{};
+    std::string json_path{};
+    // Compare against this committed baseline and fail on regressions.
+    std::string baseline_path{};
+    // Record this run as a new baseline, keeping baseline_path's tolerances if it exists.
+    std::string write_baseline_path{};
+    // Skip the median check, e.g. on shared CI runners whose timings say nothing about this code.
+    bool allocations_only{false};
+    std::string filter{};
+    std::size_t library_size{kDefaultLibrarySize};
+    std::chrono::milliseconds min_time{300};
+    std::size_t max_iterations{10'000};
+};
+
+struct CorpusSheet {
+    std::filesystem::path path{};
+    piano_assist::SongDocument document{};
+};
+
+Options parse_options(const int argc, char* argv[]) {
+    Options options{};
+    for (int index = 1; index < argc; ++index) {
+        const std::string_view argument = argv[index];
+        const bool has_value = index + 1 < argc;
+        if (argument == "--json" && has_value) {
+            options.json_path = argv[++index];
+        } else if (argument == "--baseline" && has_value) {
+            options.baseline_path = argv[++index];
+        } else if (argument == "--write-baseline" && has_value) {
+            options.write_baseline_path = argv[++index];
+        } else if (argument == "--allocations-only") {
+            options.allocations_only = true;
+        } else if (argument == "--filter" && has_value) {
+            options.filter = argv[++index];
+        } else if (argument == "--sheets" && has_value) {
+            options.sheets = argv[++index];
+        } else if (argument == "--library" && has_value) {
+            options.library = argv[++index];
+        } else if (argument == "--library-size" && has_value) {
+            options.library_size = static_cast<std::size_t>(std::strtoull(argv[++index], nullptr, 10));
+        } else if (argument == "--min-time-ms" && has_value) {
+            options.min_time = std::chrono::milliseconds(std::strtoll(argv[++index], nullptr, 10));
+        } else if (argument == "--quick") {
+            // Smoke run: every case once, small library.
+            options.min_time = std::chrono::milliseconds(0);
+            options.max_iterations = 1;
+            options.library_size = 200;
+        } else {
+            std::cerr << "usage: " << kSuiteName
+                      << " [--json <path|->] [--baseline <file>] [--write-baseline <file>] [--allocations-only]"
+                         " [--filter <text>]"
+                         " [--sheets <folder>] [--library <folder>]"
+                         " [--library-size <n>]"
+                         " [--min-time-ms <n>] [--quick]\n";
+            std::exit(argument == "--help" ? 0 : 2);
+        }
+    }
+    return options;
+}
+
+std::vector<CorpusSheet> load_corpus(const std::filesystem::path& folder) {
+    std::vector<CorpusSheet> corpus;
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(folder, error)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".PADATA") {
+            corpus.push_back(CorpusSheet{entry.path(), piano_assist::read_song_document(entry.path())});
+        }
+    }
+    return corpus;
+}
+
+std::string make_synthetic_text(const std::size_t note_count) {
+    std::mt19937 rng(0x5EED);
+    std::uniform_int_distribution<std::size_t> key_pick(0, kKeys.size() - 1);
+    std::uniform_int_distribution<int> chord_size(1, 4);
+    std::uniform_int_distribution<int> sustain_pick(0, 5);
+    std::uniform_int_distribution<int> line_length(8, 24);
+
+    std::string text;
+    int until_break = line_length(rng);
+    for (std::size_t index = 0; index < note_count; ++index) {
+        const int size = chord_size(rng);
+        if (size > 1) {
+            text.push_back('[');
+        }
+        for (int key = 0; key < size; ++key) {
+            text.push_back(kKeys[key_pick(rng)]);
+        }
+        if (size > 1) {
+            text.push_back(']');
+        }
+        if (sustain_pick(rng) == 0) {
+            text.append(" -");
+        }
+        text.push_back(--until_break == 0 ? '\n' : ' ');
+        if (until_break == 0) {
+            until_break = line_length(rng);
+        }
+    }
+    return text;
+}
+
+piano_assist::LibraryProfile profile_of(const std::vector<CorpusSheet>& corpus) {
+    std::vector<piano_assist::SongDocument> documents;
+    for (const CorpusSheet& sheet : corpus) {
+        documents.push_back(sheet.document);
+    }
+    return piano_assist::profile_from_corpus(documents);
+}
+
+void generate_fresh_library(
+    const std::filesystem::path& folder,
+    const piano_assist::LibraryProfile& profile,
+    const std::size_t song_count
+) {
+    std::filesystem::remove_all(folder);
+    piano_assist::LibraryOptions options{};
+    options.song_count = song_count;
+    options.seed = kLibrarySeed;
+    static_cast<void>(piano_assist::generate_library(folder, profile, options));
+}
+
+// Fake key-state source: per chord, the held mask grows one key per poll and then releases,
+// with a stray key every few chords, like KeyboardInput::sample_key_mask() would report.
+std::vector<piano_assist::KeyMask> make_key_samples(const piano_assist::CompiledSheet& sheet) {
+    std::mt19937 rng(0xC40D);
+    std::uniform_int_distribution<int> stray_pick(0, 7);
+    std::vector<piano_assist::KeyMask> samples;
+    for (const piano_assist::KeyMask target : sheet.masks) {
+        piano_assist::KeyMask held = 0;
+        for (piano_assist::KeyMask remaining = target; remaining != 0; remaining &= remaining - 1) {
+            held |= remaining & (~remaining + 1);
+            if (stray_pick(rng) == 0) {
+                samples.push_back(held | (piano_assist::KeyMask{1} << 45));
+            }
+            samples.push_back(held);
+        }
+        samples.push_back(0);
+    }
+    return samples;
+}
+
+void bench_parser(BenchRunner& runner, const std::vector<CorpusSheet>& corpus, const std::string& synthetic) {
+    std::size_t corpus_notes = 0;
+    for (const CorpusSheet& sheet : corpus) {
+        corpus_notes += piano_assist::parse_sheet(
+            sheet.document.body + " ",
+            sheet.document.open_brace,
+            sheet.document.close_brace,
+            sheet.document.sustain_indicator
+        ).size();
+    }
+    if (!corpus.empty()) {
+        runner.run("parse_sheet.corpus", corpus_notes, [&corpus]() {
+            for (const CorpusSheet& sheet : corpus) {
+                keep(piano_assist::parse_sheet(
+                    sheet.document.body + " ",
+                    sheet.document.open_brace,
+                    sheet.document.close_brace,
+                    sheet.document.sustain_indicator
+                ).size());
+            }
+        });
+    }
+
+    runner.run("parse_sheet.synthetic", kSyntheticNoteCount, [&synthetic]() {
+        keep(piano_assist::parse_sheet(synthetic, '[', ']', '-').size());
+    });
+}
+
+void bench_repository(
+    BenchRunner& runner,
+    const std::filesystem::path& library,
+    const std::vector<piano_assist::Song>& songs,
+    const piano_assist::LibraryProfile& profile
+) {
+    // Legacy files and name-keyed tags, migrated from scratch each iteration.
+    const std::filesystem::path migration_library =
+        std::filesystem::temp_directory_path() / "sheetmaster_bench_migration";
+    runner.run(
+        "list_songs.migrate",
+        kMigrationLibrarySize,
+        [&migration_library, &profile]() {
+            generate_fresh_library(migration_library, profile, kMigrationLibrarySize);
+            return 0;
+        },
+        [&migration_library](int) {
+            const piano_assist::SongRepository repository(migration_library);
+            const std::vector<piano_assist::Song> migrated = repository.list_songs();
+            piano_assist::TagStore(migration_library / "song_tags.PADISCRIM").migrate_song_name_keys_to_ids(migrated);
+            keep(migrated.size());
+        }
+    );
+    std::error_code error;
+    std::filesystem::remove_all(migration_library, error);
+
+    // Cold: a fresh repository per call, as at startup, so the migration scan runs too.
+    runner.run("list_songs.cold", songs.size(), [&library]() {
+        const piano_assist::SongRepository repository(library);
+        keep(repository.list_songs().size());
+    });
+
+    const piano_assist::SongRepository warm(library);
+    keep(warm.list_songs().size());
+    runner.run("list_songs.warm", songs.size(), [&warm]() {
+        keep(warm.list_songs().size());
+    });
+    runner.run("list_songs.filtered", songs.size(), [&warm]() {
+        keep(warm.list_songs("#1").size());
+    });
+
+    runner.run("read_song_document", songs.size(), [&library, &songs]() {
+        for (const piano_assist::Song& song : songs) {
+            keep(piano_assist::read_song_document(library / song.file_name).body.size());
+        }
+    });
+
+    // Everything select_song does for a song the preloader missed, with the window's arena.
+    piano_assist::ScratchArena arena;
+    runner.run("song_load.prepare_sheet", songs.size(), [&warm, &songs, &arena]() {
+        for (const piano_assist::Song& song : songs) {
+            keep(piano_assist::prepare_sheet(warm, song, piano_assist::OverlayChunkingMode::AutoDetect, {}, arena.resource())
+                     ->sheet.size());
+            arena.reset();
+        }
+    });
+}
+
+void bench_tags(BenchRunner& runner, const std::filesystem::path& library, const std::vector<piano_assist::Song>& songs) {
+    if (songs.empty()) {
+        return;
+    }
+
+    const piano_assist::TagStore tags(library / "song_tags.PADISCRIM");
+
+    runner.run("tag_store.tags_for_song", kTagLookupsPerIteration, [&tags, &songs]() {
+        for (std::size_t index = 0; index < kTagLookupsPerIteration; ++index) {
+            keep(tags.tags_for_song(songs[(index * 7919) % songs.size()].id).size());
+        }
+    });
+    runner.run("tag_store.load_all", songs.size(), [&tags]() {
+        keep(tags.load_all().size());
+    });
+    runner.run("tag_store.list_all_tags", songs.size(), [&tags]() {
+        keep(tags.list_all_tags().size());
+    });
+}
+
+// A catalog read and tagged the way the search worker does, then queried a page at a time.
+void bench_query(BenchRunner& runner, const std::filesystem::path& library) {
+    const piano_assist::SongRepository repository(library);
+    const piano_assist::SongTagMap tags = piano_assist::TagStore(library / "song_tags.PADISCRIM").load_all();
+    piano_assist::SongCatalog catalog = repository.load_catalog({}, {});
+    std::string busiest_tag;
+    std::size_t busiest_count = 0;
+    std::unordered_map<std::string, std::size_t> tag_counts;
+    for (piano_assist::SongCatalog::Index index = 0; index < catalog.size(); ++index) {
+        const auto it = tags.find(std::string(catalog.id(index)));
+        if (it == tags.end()) {
+            continue;
+        }
+        catalog.set_tags(index, it->second);
+        for (const std::string& tag : it->second) {
+            const std::size_t count = ++tag_counts[tag];
+            if (count > busiest_count) {
+                busiest_count = count;
+                busiest_tag = tag;
+            }
+        }
+    }
+    const auto shared = std::make_shared<const piano_assist::SongCatalog>(std::move(catalog));
+    const std::size_t song_count = shared->size();
+
+    runner.run("song_query.build_index", song_count, [&shared, &repository]() {
+        keep(piano_assist::SongQueryIndex(shared, repository, {}).catalog()->size());
+    });
+
+    const piano_assist::SongQueryIndex index(shared, repository, {});
+    piano_assist::SongQuery query{};
+    query.limit = piano_assist::kSongPageSize;
+    const std::size_t page_size = std::min(song_count, query.limit);
+    runner.run("song_query.first_page", page_size, [&index, &query]() {
+        keep(index.run(query).songs.size());
+    });
+
+    piano_assist::SongQuery by_length = query;
+    by_length.sort = piano_assist::SongSortKey::Length;
+    // Each order is built on first use; the case times the pages after that.
+    keep(index.run(by_length).songs.size());
+    runner.run("song_query.length_page", page_size, [&index, &by_length]() {
+        keep(index.run(by_length).songs.size());
+    });
+
+    piano_assist::SongQuery by_name = query;
+    by_name.name = "an";
+    runner.run("song_query.name_page", index.run(by_name).songs.size(), [&index, &by_name]() {
+        keep(index.run(by_name).songs.size());
+    });
+
+    if (!busiest_tag.empty()) {
+        piano_assist::SongQuery by_tag = query;
+        by_tag.tag = busiest_tag;
+        runner.run("song_query.tag_page", std::min(busiest_count, query.limit), [&index, &by_tag]() {
+            keep(index.run(by_tag).songs.size());
+        });
+    }
+}
+
+void bench_overlay(BenchRunner& runner, const std::string& synthetic, const piano_assist::CompiledSheet& sheet) {
+    runner.run("overlay.fixed_lines", sheet.size(), [&sheet]() {
+        keep(piano_assist::layout_fixed_lines(sheet.size(), piano_assist::kOverlayChunkSizeNoBreaks).lines.size());
+    });
+    runner.run("overlay.smart_lines", sheet.size(), [&sheet]() {
+        keep(piano_assist::layout_smart_lines(sheet, '-').lines.size());
+    });
+    piano_assist::ScratchArena arena;
+    runner.run("overlay.source_lines", sheet.size(), [&synthetic, &sheet, &arena]() {
+        const auto layout = piano_assist::layout_source_lines(synthetic, '[', ']', '-', sheet.size(), arena.resource());
+        keep(layout.has_value() ? layout->lines.size() : 0);
+        arena.reset();
+    });
+
+    // Roughly the overlay's monospace advance per character.
+    std::vector<double> widths;
+    widths.reserve(sheet.size());
+    for (const piano_assist::NoteGroup& group : sheet.groups) {
+        widths.push_back(12.0 * static_cast<double>(group.keys.size()) + 8.0);
+    }
+    runner.run("overlay.fit_width_lines", sheet.size(), [&sheet, &widths]() {
+        keep(piano_assist::layout_fit_width_lines(sheet, '-', widths, 10.0, 900.0).lines.size());
+    });
+}
+
+void bench_chord_matching(BenchRunner& runner, const piano_assist::CompiledSheet& sheet) {
+    const std::vector<piano_assist::KeyMask> samples = make_key_samples(sheet);
+
+    runner.run("chord_matcher.feed", samples.size(), [&sheet, &samples]() {
+        piano_assist::WindowedChordMatcher matcher;
+        std::size_t cursor = 0;
+        matcher.reset(sheet.masks[cursor]);
+        piano_assist::KeyMask previous = 0;
+        std::chrono::microseconds timestamp{0};
+        for (const piano_assist::KeyMask sample : samples) {
+            timestamp += std::chrono::microseconds(4'000);
+            piano_assist::for_each_key_edge(previous, sample, [&](const std::uint8_t slot, const bool down) {
+                if (matcher.feed(piano_assist::KeyEvent{timestamp, slot, down}) && cursor + 1 < sheet.size()) {
+                    matcher.reset(sheet.masks[++cursor]);
+                }
+            });
+            previous = sample;
+        }
+        keep(cursor);
+    });
+
+    piano_assist::PlaybackSession session;
+    session.load(sheet);
+    runner.run("playback_session.tick", kPlaybackTicksPerIteration, [&session]() {
+        session.seek(0);
+
+        // Simulated player: press the expected chord for two polls, release for one.
+        std::chrono::microseconds timestamp{0};
+        for (std::size_t tick = 0; tick < kPlaybackTicksPerIteration; ++tick) {
+            if (session.completed()) {
+                session.seek(0);
+            }
+            const piano_assist::KeyMask expected = session.sheet().masks[session.cursor()];
+            const piano_assist::KeyMask down = (tick % 3 == 2) ? 0 : expected;
+            session.tick(piano_assist::InputSample{timestamp, down, false});
+            timestamp += std::chrono::microseconds(8'000);
+        }
+        keep(session.cursor());
+    });
+}
+
+int check_baseline(const Options& options, const std::vector<piano_assist::bench::BenchResult>& results) {
+    piano_assist::bench::Baseline baseline{};
+    if (!options.baseline_path.empty()) {
+        std::ifstream in(options.baseline_path);
+        if (!in && options.write_baseline_path.empty()) {
+            std::cerr << "failed to read " << options.baseline_path << '\n';
+            return 1;
+        }
+        baseline = piano_assist::bench::read_baseline(in);
+    }
+
+    if (!options.write_baseline_path.empty()) {
+        std::ofstream out(options.write_baseline_path, std::ios::trunc);
+        piano_assist::bench::write_baseline(out, kSuiteName, results, baseline);
+        if (!out) {
+            std::cerr << "failed to write " << options.write_baseline_path << '\n';
+            return 1;
+        }
+        return 0;
+    }
+    if (options.baseline_path.empty()) {
+        return 0;
+    }
+
+    const std::vector<std::string> regressions = piano_assist::bench::compare_to_baseline(results, baseline, !options.allocations_only);
+    for (const std::string& regression : regressions) {
+        std::cerr << "regression: " << regression << '\n';
+    }
+    std::cerr << baseline.cases.size() << " baseline cases, " << regressions.size() << " regressions\n";
+    return regressions.empty() ? 0 : 1;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const Options options = parse_options(argc, argv);
+    BenchRunner runner(options.min_time, options.max_iterations, options.filter);
+
+    const std::vector<CorpusSheet> corpus = load_corpus(options.sheets);
+    const std::string synthetic = make_synthetic_text(kSyntheticNoteCount);
+    const piano_assist::CompiledSheet synthetic_sheet =
+        piano_assist::compile_sheet(piano_assist::parse_sheet(synthetic, '[', ']', '-'));
+    if (corpus.empty()) {
+        std::cerr << "note: no .PADATA files in " << options.sheets.string() << ", corpus cases skipped\n";
+    }
+
+    bench_parser(runner, corpus, synthetic);
+    bench_overlay(runner, synthetic, synthetic_sheet);
+    bench_chord_matching(runner, synthetic_sheet);
+
+    const bool needs_library = runner.selected("list_songs") || runner.selected("read_song_document") ||
+                               runner.selected("tag_store") || runner.selected("song_query");
+    if (needs_library) {
+        const piano_assist::LibraryProfile profile = profile_of(corpus);
+        const bool generated = options.library.empty();
+        const std::filesystem::path library =
+            generated ? std::filesystem::temp_directory_path() / "sheetmaster_bench_library" : options.library;
+        if (generated) {
+            generate_fresh_library(library, profile, options.library_size);
+        }
+
+        // The first listing migrates any legacy files, so the cases below time steady-state reads.
+        const std::vector<piano_assist::Song> songs = piano_assist::SongRepository(library).list_songs();
+        piano_assist::TagStore(library / "song_tags.PADISCRIM").migrate_song_name_keys_to_ids(songs);
+        bench_repository(runner, library, songs, profile);
+        bench_tags(runner, library, songs);
+        bench_query(runner, library);
+        if (generated) {
+            std::error_code error;
+            std::filesystem::remove_all(library, error);
+        }
+    }
+
+    if (options.json_path == "-") {
+        piano_assist::bench::write_json(std::cout, kSuiteName, runner.results());
+    } else {
+        piano_assist::bench::write_text(std::cout, runner.results());
+    }
+    if (!options.json_path.empty() && options.json_path != "-") {
+        std::ofstream out(options.json_path, std::ios::trunc);
+        piano_assist::bench::write_json(out, kSuiteName, runner.results());
+        if (!out) {
+            std::cerr << "failed to write " << options.json_path << '\n';
+            return 1;
+        }
+    }
+    return check_baseline(options, runner.results());
+}
@@ -0,0 +1,96 @@
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <QGuiApplication>
+#include <QImage>
+#include <QPainter>
+#include <QRegion>
+
+#include "piano_assist/overlay_renderer.hpp"
+
+namespace {
+
+constexpr std::size_t kLineLength = 12;
+
+std::vector<std::vector<piano_assist::NoteGroup>> make_synthetic_lines(const std::size_t line_count) {
+    constexpr std::string_view kKeys = "1234567890qwertyuiopasdfghjklzxcvbnm";
+    std::mt19937 rng(0x5EED);
+    std::uniform_int_distribution<std::size_t> key_pick(0, kKeys.size() - 1);
+    std::uniform_int_distribution<int> chord_size(1, 4);
+
+    std::vector<std::vector<piano_assist::NoteGroup>> lines(line_count);
+    for (std::vector<piano_assist::NoteGroup>& line : lines) {
+        for (std::size_t index = 0; index < kLineLength; ++index) {
+            std::string keys;
+            const int size = chord_size(rng);
+            for (int key = 0; key < size; ++key) {
+                keys.push_back(kKeys[key_pick(rng)]);
+            }
+            line.push_back(piano_assist::NoteGroup{keys, true});
+        }
+    }
+    return lines;
+}
+
+std::int64_t region_area(const QRegion& region) {
+    std::int64_t area = 0;
+    for (const QRect& rect : region) {
+        area += static_cast<std::int64_t>(rect.width()) * rect.height();
+    }
+    return area;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QGuiApplication app(argc, argv);
+
+    const std::size_t advance_count =
+        argc > 1 ? static_cast<std::size_t>(std::strtoull(argv[1], nullptr, 10)) : 20'000;
+    const std::vector<std::vector<piano_assist::NoteGroup>> lines = make_synthetic_lines(64);
+
+    piano_assist::OverlayRenderer renderer;
+    QImage frame(renderer.size(), QImage::Format_ARGB32_Premultiplied);
+    frame.fill(Qt::transparent);
+
+    // Same advance sequence twice: repaint only what changed, then repaint the whole overlay.
+    for (const bool full_repaint : {false, true}) {
+        std::int64_t dirty_pixels = 0;
+        std::size_t line_changes = 0;
+        const auto started = std::chrono::steady_clock::now();
+        for (std::size_t advance = 0; advance < advance_count; ++advance) {
+            const std::size_t line = (advance / kLineLength) % lines.size();
+            const std::size_t next = (line + 1) % lines.size();
+            QRegion dirty = renderer.set_lines(lines[line], lines[next], false);
+            if (!dirty.isEmpty()) {
+                ++line_changes;
+            }
+            dirty |= renderer.set_highlight(advance % kLineLength);
+            if (full_repaint) {
+                dirty = QRegion(frame.rect());
+            }
+
+            dirty_pixels += region_area(dirty);
+            QPainter painter(&frame);
+            renderer.paint(painter, dirty);
+        }
+        const std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - started;
+
+        std::cout << (full_repaint ? "overlay.full_repaint: " : "overlay.dirty_repaint: ") << advance_count
+                  << " advances, " << line_changes << " line changes, "
+                  << elapsed.count() / static_cast<double>(advance_count) << " us/advance, "
+                  << dirty_pixels / static_cast<std::int64_t>(advance_count) << " px/advance\n";
+    }
+    return 0;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "piano_assist/compiled_sheet.hpp"
+
+namespace piano_assist {
+
+inline constexpr int kDefaultAutoplayTempo = 180;
+
+// The scheduler sleeps until this long before each deadline and spins the rest.
+inline constexpr std::chrono::milliseconds kDefaultSpinWindow{2};
+
+// offsets[i] is when group i starts, relative to the first group; offsets.back() is the end of the song.
+struct AutoplayTimeline {
+    std::vector<std::chrono::nanoseconds> offsets{};
+
+    [[nodiscard]] std::size_t group_count() const {
+        return offsets.empty() ? 0 : offsets.size() - 1;
+    }
+};
+
+[[nodiscard]] std::size_t sustain_steps(std::string_view keys, char sustain_indicator);
+[[nodiscard]] AutoplayTimeline build_autoplay_timeline(
+    const CompiledSheet& sheet,
+    char sustain_indicator,
+    int steps_per_minute
+);
+
+// Fires one callback per group boundary against absolute deadlines on a steady clock, so
+// wake-up latency never accumulates into drift. Callbacks run on the scheduler thread.
+class DeadlineScheduler final {
+public:
+    using Callback = std::function<void(std::size_t index, std::chrono::nanoseconds lateness)>;
+
+    explicit DeadlineScheduler(std::chrono::nanoseconds spin_window = kDefaultSpinWindow);
+    ~DeadlineScheduler();
+    DeadlineScheduler(const DeadlineScheduler&) = delete;
+    DeadlineScheduler& operator=(const DeadlineScheduler&) = delete;
+
+    void start(AutoplayTimeline timeline, std::size_t first_index, Callback callback);
+    void stop();
+    [[nodiscard]] bool running() const;
+
+private:
+    std::chrono::nanoseconds spin_window_;
+    std::shared_ptr<std::atomic<bool>> active_;
+    std::jthread worker_;
+};
+
+} // namespace piano_assist
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <stop_token>
+
+namespace piano_assist {
+
+// How late a plain timed wait may wake: Windows rounds sleeps up to its 15.6 ms default tick.
+#ifdef _WIN32
+inline constexpr std::chrono::milliseconds kTimedWaitGranularity{16};
+#else
+inline constexpr std::chrono::milliseconds kTimedWaitGranularity{0};
+#endif
+
+// A sleep on the OS's high-resolution timer, for platforms where a timed wait is coarse.
+class PreciseSleeper {
+public:
+    virtual ~PreciseSleeper() = default;
+
+    // Wakes at wake_at or when stop is requested. False when the wait failed without sleeping.
+    virtual bool sleep_until(std::chrono::steady_clock::time_point wake_at) = 0;
+};
+
+// Null where timed waits are already fine-grained, or when the OS refuses the timer; callers then
+// use a timed wait. Implemented in autoplay_sleep_win32.cpp on Windows.
+[[nodiscard]] std::unique_ptr<PreciseSleeper> make_precise_sleeper(const std::stop_token& stop);
+
+} // namespace piano_assist
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+namespace piano_assist {
+
+// One bit per monitored key: digits (0-9), letters (10-35), punctuation (36-45).
+using KeyMask = std::uint64_t;
+
+inline constexpr std::size_t kMonitoredKeyCount = 46;
+inline constexpr std::chrono::milliseconds kDefaultChordWindow{50};
+
+[[nodiscard]] std::optional<std::size_t> key_slot(char key);
+[[nodiscard]] KeyMask chord_mask(std::string_view keys);
+
+struct KeyEvent {
+    std::chrono::microseconds timestamp{};
+    std::uint8_t slot{0};
+    bool down{false};
+};
+
+template <typename Callback>
+void for_each_key_edge(const KeyMask previous, const KeyMask current, Callback&& callback) {
+    KeyMask changed = previous ^ current;
+    while (changed != 0) {
+        const int slot = std::countr_zero(changed);
+        const KeyMask bit = KeyMask{1} << slot;
+        callback(static_cast<std::uint8_t>(slot), (current & bit) != 0);
+        changed &= changed - 1;
+    }
+}
+
+class WindowedChordMatcher final {
+public:
+    explicit WindowedChordMatcher(
+        std::chrono::microseconds window = kDefaultChordWindow,
+        bool strict_mode = true
+    );
+
+    void set_window(std::chrono::microseconds window);
+    void reset(KeyMask target);
+
+    [[nodiscard]] bool feed(const KeyEvent& event);
+    [[nodiscard]] KeyMask target() const;
+
+private:
+    KeyMask target_{0};
+    KeyMask pressed_{0};
+    std::chrono::microseconds window_start_{};
+    std::chrono::microseconds window_{};
+    bool strict_mode_{true};
+};
+
+} // namespace piano_assist
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include <memory_resource>
+#include <span>
+#include <vector>
+
+#include "piano_assist/chord_matcher.hpp"
+#include "piano_assist/memory_accounting.hpp"
+#include "piano_assist/types.hpp"
+
+namespace piano_assist {
+
+inline constexpr std::size_t kNoNextOccurrence = std::numeric_limits<std::size_t>::max();
+
+// Chord strings are short enough to stay in NoteGroup's small-string buffer, so the three
+// vectors are what a sheet costs.
+struct CompiledSheet {
+    AccountedVector<MemorySubsystem::CompiledSheet, NoteGroup> groups{};
+    AccountedVector<MemorySubsystem::CompiledSheet, KeyMask> masks{};
+    AccountedVector<MemorySubsystem::CompiledSheet, std::size_t> next_same_mask{};
+
+    [[nodiscard]] bool empty() const {
+        return groups.empty();
+    }
+    [[nodiscard]] std::size_t size() const {
+        return groups.size();
+    }
+};
+
+[[nodiscard]] CompiledSheet compile_sheet(std::vector<NoteGroup> groups);
+// Moves the groups out of the span; the occurrence index it builds along the way lives in scratch.
+[[nodiscard]] CompiledSheet compile_sheet(std::span<NoteGroup> groups, std::pmr::memory_resource* scratch);
+
+} // namespace piano_assist
@@ -2,14 +2,17 @@
 
 #include <cstddef>
 #include <optional>
+#include <span>
 #include <string_view>
-#include <vector>
 
 #include <QPoint>
 #include <QWidget>
 
-class QLabel;
+#include "piano_assist/overlay_renderer.hpp"
+#include "piano_assist/types.hpp"
+
 class QMouseEvent;
+class QPaintEvent;
 
 namespace piano_assist {
 
@@ -19,9 +22,9 @@ public:
     ~FloatingOverlayWindow() override = default;
 
     void set_song_progress(
-        const std::vector<std::string>& current_line,
+        std::span<const NoteGroup> current_line,
         std::optional<std::size_t> highlighted_key_index,
-        const std::vector<std::string>& next_line,
+        std::span<const NoteGroup> next_line,
         bool completed,
         bool paused,
         std::string_view song_name,
@@ -29,15 +32,16 @@ public:
         std::size_t progress_total
     );
 
+    [[nodiscard]] const OverlayRenderer& renderer() const;
+
 protected:
+    void paintEvent(QPaintEvent* event) override;
     void mousePressEvent(QMouseEvent* event) override;
     void mouseMoveEvent(QMouseEvent* event) override;
     void mouseReleaseEvent(QMouseEvent* event) override;
 
 private:
-    QLabel* info_label_{nullptr};
-    QLabel* current_label_{nullptr};
-    QLabel* next_label_{nullptr};
+    OverlayRenderer renderer_;
     QPoint drag_offset_{};
     bool dragging_{false};
 };
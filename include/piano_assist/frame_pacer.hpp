@@ -0,0 +1,38 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+
+namespace piano_assist {
+
+inline constexpr std::chrono::nanoseconds kDefaultFrameInterval{16'666'667};
+
+// Coalesces any number of dirty marks into at most one flush per frame interval.
+class FramePacer final {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit FramePacer(std::chrono::nanoseconds frame_interval = kDefaultFrameInterval);
+
+    void set_frame_interval(std::chrono::nanoseconds frame_interval);
+
+    // Returns how long to wait before flushing, or nothing when a flush is already scheduled.
+    [[nodiscard]] std::optional<std::chrono::nanoseconds> mark_dirty(Clock::time_point now);
+    // Called when the scheduled flush fires; returns whether anything needs redrawing.
+    [[nodiscard]] bool begin_flush(Clock::time_point now);
+
+    [[nodiscard]] std::chrono::nanoseconds frame_interval() const;
+    [[nodiscard]] std::uint64_t marks() const;
+    [[nodiscard]] std::uint64_t flushes() const;
+
+private:
+    std::chrono::nanoseconds frame_interval_;
+    std::optional<Clock::time_point> last_flush_{};
+    bool dirty_{false};
+    bool scheduled_{false};
+    std::uint64_t marks_{0};
+    std::uint64_t flushes_{0};
+};
+
+} // namespace piano_assist
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "piano_assist/compiled_sheet.hpp"
+#include "piano_assist/playback_session.hpp"
+
+namespace piano_assist {
+
+enum class TraceRecordKind : std::uint8_t {
+    Poll = 0,
+    KeyDown = 1,
+    KeyUp = 2,
+    PauseDown = 3,
+    PauseUp = 4,
+};
+
+struct TraceRecord {
+    TraceRecordKind kind{TraceRecordKind::Poll};
+    std::chrono::microseconds timestamp{};
+    std::uint8_t slot{0};
+};
+
+struct InputTrace {
+    std::string song_id{};
+    std::vector<TraceRecord> records{};
+};
+
+// Turns live poll samples into key/pause edge records plus one Poll record per sample.
+class InputTraceRecorder final {
+public:
+    void begin(std::string song_id);
+    void record(const InputSample& sample);
+    [[nodiscard]] std::optional<InputTrace> finish();
+    [[nodiscard]] bool active() const;
+
+private:
+    InputTrace trace_{};
+    std::chrono::microseconds origin_{};
+    KeyMask previous_keys_{0};
+    bool previous_pause_{false};
+    bool started_{false};
+    bool active_{false};
+};
+
+struct ReplayResult {
+    std::size_t polls{0};
+    std::size_t advances{0};
+    std::size_t resyncs{0};
+    std::size_t missed_groups{0};
+    std::size_t final_cursor{0};
+    bool completed{false};
+};
+
+void write_input_trace(const std::filesystem::path& path, const InputTrace& trace);
+[[nodiscard]] InputTrace read_input_trace(const std::filesystem::path& path);
+
+[[nodiscard]] ReplayResult replay_input_trace(
+    const InputTrace& trace,
+    CompiledSheet sheet,
+    const PlaybackOptions& options
+);
+
+} // namespace piano_assist
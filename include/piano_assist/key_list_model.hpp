@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+
+#include <QAbstractListModel>
+
+#include "piano_assist/compiled_sheet.hpp"
+
+namespace piano_assist {
+
+// Formats "N. keys" rows on demand from a compiled sheet owned elsewhere, so loading a song
+// costs the same no matter how many note groups it has.
+class KeyListModel final : public QAbstractListModel {
+public:
+    explicit KeyListModel(QObject* parent = nullptr);
+
+    [[nodiscard]] int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    [[nodiscard]] QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+
+    // The sheet must outlive the model or be replaced with nullptr first.
+    void set_sheet(const CompiledSheet* sheet);
+
+private:
+    const CompiledSheet* sheet_{nullptr};
+    std::size_t row_count_{0};
+};
+
+} // namespace piano_assist
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "piano_assist/song_repository.hpp"
+
+namespace piano_assist {
+
+// Empirical distributions sampled by the generator. Each vector holds one entry per
+// observation, so drawing a uniform element reproduces the observed frequencies.
+struct LibraryProfile {
+    std::vector<std::size_t> chord_sizes{};
+    std::vector<std::size_t> line_lengths{};
+    std::vector<std::size_t> line_counts{};
+    std::string keys{};
+    double sustain_rate{0.0};
+    double round_brace_rate{0.0};
+};
+
+struct LibraryOptions {
+    std::size_t song_count{1'000};
+    std::uint64_t seed{1};
+    // Share of songs written as legacy .txt files that need migrating.
+    double legacy_rate{0.1};
+    // Share of songs that reuse an earlier song's display name.
+    double collision_rate{0.05};
+    double tagged_rate{0.6};
+    std::size_t max_tags_per_song{3};
+};
+
+struct GeneratedLibrary {
+    std::size_t modern_files{0};
+    std::size_t legacy_files{0};
+    std::size_t name_collisions{0};
+    std::size_t tagged_songs{0};
+    std::size_t notes{0};
+};
+
+// Measures a sheet corpus such as the bundled sheets/; falls back to built-in numbers
+// close to them when the corpus is empty.
+[[nodiscard]] LibraryProfile profile_from_corpus(const std::vector<SongDocument>& corpus);
+[[nodiscard]] LibraryProfile default_library_profile();
+
+// Writes options.song_count songs and a matching song_tags.PADISCRIM into folder. The same
+// seed and profile always produce byte-identical files. Legacy songs' tags are keyed by
+// display name, as before the id migration.
+GeneratedLibrary generate_library(
+    const std::filesystem::path& folder,
+    const LibraryProfile& profile,
+    const LibraryOptions& options
+);
+
+} // namespace piano_assist
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "piano_assist/song_repository.hpp"
+
+namespace piano_assist {
+
+enum class SheetIssueKind {
+    UnclosedGroup = 0,
+    UnopenedGroup = 1,
+    NestedGroup = 2,
+};
+
+// line and column are 1-based positions in the sheet body.
+struct SheetIssue {
+    SheetIssueKind kind{SheetIssueKind::UnclosedGroup};
+    std::size_t line{0};
+    std::size_t column{0};
+};
+
+[[nodiscard]] std::string_view describe_sheet_issue(SheetIssueKind kind);
+// Bracket problems the parser silently tolerates.
+[[nodiscard]] std::vector<SheetIssue> check_sheet_brackets(std::string_view body, char open_brace, char close_brace);
+
+struct SheetReport {
+    std::filesystem::path path{};
+    // As stored; legacy files have no id or name yet.
+    std::string id{};
+    std::string name{};
+    bool is_modern{false};
+    std::size_t note_groups{0};
+    std::size_t keys{0};
+    // chord_sizes[n] counts note groups with n keys, sustain marks not included.
+    std::vector<std::size_t> chord_sizes{};
+    std::vector<SheetIssue> issues{};
+};
+
+// Reads and parses every song file in folder on up to jobs threads (0 picks one per core)
+// without modifying anything. Reports are in file name order.
+[[nodiscard]] std::vector<SheetReport> scan_library(const std::filesystem::path& folder, std::size_t jobs = 0);
+
+struct DuplicateSongId {
+    std::string id{};
+    std::vector<std::filesystem::path> paths{};
+};
+
+[[nodiscard]] std::vector<DuplicateSongId> find_duplicate_ids(const std::vector<SheetReport>& reports);
+
+struct LibraryStats {
+    std::size_t songs{0};
+    std::size_t legacy_songs{0};
+    std::size_t note_groups{0};
+    std::size_t keys{0};
+    std::size_t songs_with_issues{0};
+    std::vector<std::size_t> chord_sizes{};
+};
+
+[[nodiscard]] LibraryStats summarize_library(const std::vector<SheetReport>& reports);
+
+struct ConvertedLibrary {
+    std::size_t converted{0};
+    std::size_t failed{0};
+};
+
+// Writes a modern .PADATA copy of every song file in input into output, which must differ
+// from input; input is left untouched. Legacy files get ids and names the way migration would.
+ConvertedLibrary convert_library(
+    const std::filesystem::path& input,
+    const std::filesystem::path& output,
+    std::size_t jobs = 0
+);
+
+} // namespace piano_assist
@@ -1,16 +1,29 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <optional>
 #include <vector>
 
+#include <QElapsedTimer>
 #include <QMainWindow>
 #include <QTimer>
 
+#include "piano_assist/autoplay.hpp"
+#include "piano_assist/compiled_sheet.hpp"
+#include "piano_assist/frame_pacer.hpp"
+#include "piano_assist/input_trace.hpp"
 #include "piano_assist/keyboard.hpp"
+#include "piano_assist/overlay_layout.hpp"
+#include "piano_assist/play_history.hpp"
+#include "piano_assist/playback_session.hpp"
+#include "piano_assist/scratch_arena.hpp"
 #include "piano_assist/settings_store.hpp"
+#include "piano_assist/sheet_preloader.hpp"
 #include "piano_assist/song_repository.hpp"
+#include "piano_assist/song_search.hpp"
+#include "piano_assist/startup_profiler.hpp"
 #include "piano_assist/tag_store.hpp"
 #include "piano_assist/types.hpp"
 
@@ -18,12 +31,15 @@ class QCheckBox;
 class QComboBox;
 class QLabel;
 class QLineEdit;
-class QListWidget;
+class QListView;
+class QModelIndex;
 class QPushButton;
-class QTableWidget;
+class QTableView;
 
 namespace piano_assist {
 class FloatingOverlayWindow;
+class KeyListModel;
+class SongTableModel;
 }
 
 namespace piano_assist {
@@ -35,54 +51,92 @@ public:
     explicit MainWindow(QWidget* parent = nullptr);
     ~MainWindow() override;
 
+protected:
+    bool event(QEvent* event) override;
+
 private slots:
+    // Runs the query shown in the search controls against the catalog already read.
     void refresh_song_list();
-    void handle_song_double_click(int row, int column);
+    // Reads the sheet folder again first, after the songs on disk changed.
+    void reload_song_list();
+    void schedule_song_search();
+    void handle_song_double_click(const QModelIndex& index);
+    void handle_song_hovered(const QModelIndex& index);
+    void update_preload_targets();
     void handle_import_songs();
     void handle_manage_songs();
     void handle_settings();
+    void handle_diagnostics();
     void handle_strict_mode_toggle(bool checked);
     void handle_overlay_toggle(bool checked);
+    void handle_autoplay_toggle(bool checked);
     void poll_input();
+    void flush_playback_view();
 
 private:
     SongRepository repository_;
     TagStore tag_store_;
+    PlayHistory play_history_;
     SettingsStore settings_store_;
     AppSettings settings_;
-    KeyboardInput keyboard_;
+    PlaybackSession session_;
+    InputTraceRecorder trace_recorder_;
+    DeadlineScheduler autoplay_scheduler_;
+    std::uint64_t autoplay_generation_{0};
 
     QTimer input_poll_timer_;
+    QTimer search_debounce_timer_;
+    QTimer frame_timer_;
+    FramePacer frame_pacer_;
+    QElapsedTimer startup_timer_;
+    std::optional<qint64> first_row_ms_;
+    bool catalog_loaded_{false};
+    bool first_paint_done_{false};
+    StartupProfiler::Clock::time_point catalog_load_started_{};
+    std::unique_ptr<SongSearchWorker> search_worker_;
+    std::unique_ptr<SheetPreloader> sheet_preloader_;
 
     QLineEdit* search_edit_{nullptr};
     QComboBox* tag_filter_{nullptr};
-    QTableWidget* song_table_{nullptr};
+    QComboBox* sort_combo_{nullptr};
+    QTableView* song_table_{nullptr};
+    SongTableModel* song_table_model_{nullptr};
     QPushButton* import_button_{nullptr};
     QPushButton* manage_button_{nullptr};
     QPushButton* settings_button_{nullptr};
+    QPushButton* diagnostics_button_{nullptr};
     QLabel* current_song_label_{nullptr};
     QLabel* duration_label_{nullptr};
     QCheckBox* strict_mode_checkbox_{nullptr};
     QCheckBox* overlay_checkbox_{nullptr};
-    QListWidget* key_list_{nullptr};
+    QCheckBox* autoplay_checkbox_{nullptr};
+    QListView* key_list_{nullptr};
+    KeyListModel* key_list_model_{nullptr};
     std::unique_ptr<FloatingOverlayWindow> floating_overlay_;
 
-    std::vector<Song> visible_songs_;
     std::optional<Song> current_song_;
-    std::vector<NoteGroup> current_sheet_;
-    std::vector<std::vector<std::string>> overlay_lines_;
-    std::vector<std::size_t> overlay_line_starts_;
-    std::size_t current_index_{0};
-    bool waiting_for_release_{false};
-    bool paused_{false};
-    bool pause_key_latched_{false};
+    std::optional<Song> hovered_song_;
+    OverlayLayout overlay_layout_;
+    OverlayLayoutCache overlay_layout_cache_;
+    // Scratch for loads that miss the preloader; reset as soon as each load is done.
+    ScratchArena song_arena_;
 
     void build_ui();
-    void repopulate_tag_filter();
+    void repopulate_tag_filter(const std::vector<std::string>& tags);
+    void submit_song_query(bool reload, bool stream);
+    void apply_search_result(SongSearchResult result);
+    // song_count is the whole library, not the rows fetched so far.
+    void report_catalog_progress(bool complete, std::size_t song_count);
+    void finish_startup_report();
+    void ensure_floating_overlay();
     void select_song(const Song& song);
-    void rebuild_overlay_lines(const Song& song);
+    void rebuild_overlay_lines(const Song& song, const CompiledSheet& sheet, OverlayLayout text_layout);
+    void request_playback_view_update();
     void update_playback_labels();
     void update_floating_overlay();
+    void stop_autoplay();
+    void restart_trace_recording();
+    void finish_trace_recording();
     [[nodiscard]] std::optional<Song> selected_song_from_table() const;
 };
 
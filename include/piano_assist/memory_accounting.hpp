@@ -0,0 +1,80 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace piano_assist {
+
+enum class MemorySubsystem : std::size_t {
+    Catalog = 0,
+    CompiledSheet,
+    OverlayLayout,
+    Tags,
+};
+
+inline constexpr std::size_t kMemorySubsystemCount = 4;
+
+struct MemoryUsage {
+    MemorySubsystem subsystem{MemorySubsystem::Catalog};
+    std::size_t live_bytes{0};
+    std::size_t peak_bytes{0};
+    std::uint64_t allocations{0};
+    std::uint64_t deallocations{0};
+};
+
+[[nodiscard]] std::string_view memory_subsystem_name(MemorySubsystem subsystem);
+
+// Process-wide counters; safe to call from any thread.
+void record_allocation(MemorySubsystem subsystem, std::size_t bytes, std::size_t blocks = 1);
+void record_deallocation(MemorySubsystem subsystem, std::size_t bytes, std::size_t blocks = 1);
+
+[[nodiscard]] MemoryUsage memory_usage(MemorySubsystem subsystem);
+[[nodiscard]] std::array<MemoryUsage, kMemorySubsystemCount> memory_usage_snapshot();
+// Lowers every peak to the current live size, so the next peak covers only what follows.
+void reset_memory_peaks();
+
+// Stateless, so containers copy and move between each other freely; every block is charged
+// to Subsystem and then served by std::allocator.
+template <typename T, MemorySubsystem Subsystem>
+class AccountedAllocator {
+public:
+    using value_type = T;
+
+    template <typename U>
+    struct rebind {
+        using other = AccountedAllocator<U, Subsystem>;
+    };
+
+    AccountedAllocator() noexcept = default;
+    template <typename U>
+    AccountedAllocator(const AccountedAllocator<U, Subsystem>&) noexcept {}
+
+    [[nodiscard]] T* allocate(const std::size_t count) {
+        T* memory = std::allocator<T>{}.allocate(count);
+        record_allocation(Subsystem, count * sizeof(T));
+        return memory;
+    }
+
+    void deallocate(T* memory, const std::size_t count) noexcept {
+        record_deallocation(Subsystem, count * sizeof(T));
+        std::allocator<T>{}.deallocate(memory, count);
+    }
+
+    template <typename U>
+    bool operator==(const AccountedAllocator<U, Subsystem>&) const noexcept {
+        return true;
+    }
+};
+
+template <MemorySubsystem Subsystem, typename T>
+using AccountedVector = std::vector<T, AccountedAllocator<T, Subsystem>>;
+
+// {"catalog": {"live_bytes": ..., "peak_bytes": ..., "allocations": ..., "deallocations": ...}, ...}
+[[nodiscard]] std::string memory_usage_json();
+
+} // namespace piano_assist
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "piano_assist/compiled_sheet.hpp"
+#include "piano_assist/memory_accounting.hpp"
+#include "piano_assist/types.hpp"
+
+namespace piano_assist {
+
+inline constexpr std::size_t kOverlayChunkSizeNoBreaks = 10;
+inline constexpr std::size_t kOverlaySmartChunkMin = 10;
+inline constexpr std::size_t kOverlaySmartChunkMax = 16;
+
+// [begin, end) into CompiledSheet::groups.
+struct OverlayLineRange {
+    std::size_t begin{0};
+    std::size_t end{0};
+
+    [[nodiscard]] std::size_t size() const {
+        return end - begin;
+    }
+};
+
+struct OverlayLayout {
+    AccountedVector<MemorySubsystem::OverlayLayout, OverlayLineRange> lines{};
+    AccountedVector<MemorySubsystem::OverlayLayout, std::uint32_t> line_of_note{};
+
+    [[nodiscard]] bool empty() const {
+        return lines.empty();
+    }
+};
+
+[[nodiscard]] OverlayLayout layout_from_line_lengths(std::span<const std::size_t> lengths);
+[[nodiscard]] OverlayLayout layout_fixed_lines(std::size_t note_count, std::size_t chunk_size);
+[[nodiscard]] OverlayLayout layout_smart_lines(const CompiledSheet& sheet, char sustain_indicator);
+// Minimum-raggedness breaking: every line but the last costs its squared slack, plus a penalty
+// when it does not end on a sustained note. A token wider than max_width gets a line of its own.
+[[nodiscard]] OverlayLayout layout_fit_width_lines(
+    const CompiledSheet& sheet,
+    char sustain_indicator,
+    std::span<const double> token_widths,
+    double gap,
+    double max_width
+);
+// Follows the line breaks of the original sheet text; nothing if it has none or they disagree with the sheet.
+// The per-line counts are kept in scratch.
+[[nodiscard]] std::optional<OverlayLayout> layout_source_lines(
+    std::string_view raw_text,
+    char open_brace,
+    char close_brace,
+    char sustain_indicator,
+    std::size_t note_count,
+    std::pmr::memory_resource* scratch = std::pmr::get_default_resource()
+);
+
+// Layout for the text-based chunking modes. FitWidth needs font metrics, so it falls back to
+// Smart here and the GUI swaps in the measured layout.
+[[nodiscard]] OverlayLayout layout_for_chunking_mode(
+    OverlayChunkingMode mode,
+    const Song& song,
+    const CompiledSheet& sheet,
+    std::string_view raw_text,
+    std::pmr::memory_resource* scratch = std::pmr::get_default_resource()
+);
+
+struct OverlayLayoutKey {
+    std::string song_id{};
+    std::uint64_t sheet_fingerprint{0};
+    std::string font{};
+    int width{0};
+
+    bool operator==(const OverlayLayoutKey&) const = default;
+};
+
+[[nodiscard]] std::uint64_t sheet_fingerprint(const CompiledSheet& sheet);
+
+// Small most-recently-used cache, so reselecting a song or reopening settings skips the line breaker.
+class OverlayLayoutCache final {
+public:
+    explicit OverlayLayoutCache(std::size_t capacity = 16);
+
+    [[nodiscard]] const OverlayLayout* find(const OverlayLayoutKey& key);
+    void insert(OverlayLayoutKey key, OverlayLayout layout);
+    [[nodiscard]] std::size_t size() const;
+
+private:
+    std::size_t capacity_;
+    std::vector<std::pair<OverlayLayoutKey, OverlayLayout>> entries_;
+};
+
+} // namespace piano_assist
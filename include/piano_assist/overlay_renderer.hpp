@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <QColor>
+#include <QFont>
+#include <QPixmap>
+#include <QRectF>
+#include <QRegion>
+#include <QSize>
+#include <QStaticText>
+#include <QString>
+
+#include "piano_assist/types.hpp"
+
+class QPainter;
+
+namespace piano_assist {
+
+// Text laid out once, with its black outline pre-rendered, so repaints are two blits.
+struct CachedText {
+    QStaticText text{};
+    QFont font{};
+    QSizeF size{};
+    QPixmap outline{};
+};
+
+// Paints the floating overlay without widgets or rich text. Each setter returns the area
+// that changed so the caller can repaint just that.
+class OverlayRenderer final {
+public:
+    explicit OverlayRenderer(QSize size = QSize(940, 144));
+
+    [[nodiscard]] QSize size() const;
+    [[nodiscard]] bool set_device_pixel_ratio(qreal ratio);
+
+    [[nodiscard]] QRegion set_info(const QString& text);
+    [[nodiscard]] QRegion set_lines(
+        std::span<const NoteGroup> current_line,
+        std::span<const NoteGroup> next_line,
+        bool completed
+    );
+    [[nodiscard]] QRegion set_highlight(std::optional<std::size_t> key_index);
+
+    void paint(QPainter& painter, const QRegion& exposed) const;
+
+    // Metrics for width-aware line breaking; widths match the slots layout_line() produces.
+    [[nodiscard]] std::vector<double> measure_tokens(std::span<const NoteGroup> groups) const;
+    [[nodiscard]] double token_gap() const;
+    [[nodiscard]] double line_width() const;
+    [[nodiscard]] QString font_key() const;
+
+private:
+    struct TokenSlot {
+        CachedText normal{};
+        CachedText highlighted{};
+        QRectF bounds{};
+    };
+
+    QSize size_;
+    qreal device_pixel_ratio_{1.0};
+    QFont info_font_;
+    QFont line_font_;
+    QFont highlight_font_;
+    QFont completed_font_;
+    QFont placeholder_font_;
+    QPixmap panel_;
+
+    QString info_;
+    CachedText info_text_{};
+    QRectF info_bounds_{};
+
+    std::vector<std::string> current_keys_;
+    std::vector<std::string> next_keys_;
+    bool completed_{false};
+    std::vector<TokenSlot> current_tokens_;
+    std::vector<TokenSlot> next_tokens_;
+    std::optional<std::size_t> highlight_;
+
+    [[nodiscard]] QRectF current_line_rect() const;
+    [[nodiscard]] QRectF next_line_rect() const;
+    [[nodiscard]] QRectF token_bounds(std::optional<std::size_t> key_index) const;
+    void rebuild_panel();
+    void rebuild_info();
+    void rebuild_lines();
+    [[nodiscard]] std::vector<TokenSlot> layout_line(
+        const std::vector<QString>& tokens,
+        const QFont& font,
+        const QFont* highlight_font,
+        const QRectF& area
+    ) const;
+};
+
+} // namespace piano_assist
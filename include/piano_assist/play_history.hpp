@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace piano_assist {
+
+// Song id to when it was last played, in seconds since the epoch.
+using PlayTimes = std::unordered_map<std::string, std::int64_t>;
+
+// When each song was last played. Like the tag store, every call reads or rewrites the whole
+// file under a process-wide lock.
+class PlayHistory final {
+public:
+    explicit PlayHistory(std::filesystem::path storage_file);
+
+    void record_play(std::string_view song_id, std::int64_t played_at) const;
+    void remove_song(std::string_view song_id) const;
+    [[nodiscard]] PlayTimes load_all() const;
+
+    // Bumped by every write in this process, so a cached PlayTimes can tell it is stale.
+    [[nodiscard]] static std::uint64_t revision();
+
+private:
+    std::filesystem::path storage_file_;
+};
+
+} // namespace piano_assist
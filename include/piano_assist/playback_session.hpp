@@ -0,0 +1,86 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+#include "piano_assist/chord_matcher.hpp"
+#include "piano_assist/compiled_sheet.hpp"
+#include "piano_assist/resync_matcher.hpp"
+
+namespace piano_assist {
+
+struct InputSample {
+    std::chrono::microseconds timestamp{};
+    KeyMask keys_down{0};
+    bool pause_key_down{false};
+};
+
+enum class CursorEventKind {
+    Loaded,
+    Cleared,
+    Advanced,
+    Resynced,
+    Seeked,
+    PauseChanged,
+};
+
+struct CursorEvent {
+    CursorEventKind kind{CursorEventKind::Advanced};
+    std::size_t previous_index{0};
+    std::size_t index{0};
+    bool paused{false};
+};
+
+struct PlaybackOptions {
+    bool strict_mode{true};
+    std::chrono::microseconds chord_window{kDefaultChordWindow};
+    std::size_t resync_lookahead{kDefaultResyncLookahead};
+};
+
+// Headless playback state machine: consumes key-state samples and reports cursor moves.
+class PlaybackSession final {
+public:
+    using Listener = std::function<void(const CursorEvent&)>;
+
+    explicit PlaybackSession(const PlaybackOptions& options = {});
+    PlaybackSession(const PlaybackSession&) = delete;
+    PlaybackSession& operator=(const PlaybackSession&) = delete;
+
+    void set_options(const PlaybackOptions& options);
+    void subscribe(Listener listener);
+
+    void load(CompiledSheet sheet);
+    void clear();
+    void seek(std::size_t index);
+    void tick(const InputSample& sample);
+
+    [[nodiscard]] const CompiledSheet& sheet() const;
+    [[nodiscard]] const PlaybackOptions& options() const;
+    [[nodiscard]] std::size_t cursor() const;
+    [[nodiscard]] bool loaded() const;
+    [[nodiscard]] bool paused() const;
+    [[nodiscard]] bool completed() const;
+
+private:
+    PlaybackOptions options_;
+    CompiledSheet sheet_;
+    WindowedChordMatcher chord_matcher_;
+    ResyncMatcher resync_matcher_;
+    std::vector<Listener> listeners_;
+    std::size_t cursor_{0};
+    KeyMask previous_key_mask_{0};
+    KeyMask attempt_mask_{0};
+    bool loaded_{false};
+    bool waiting_for_release_{false};
+    bool paused_{false};
+    bool pause_key_latched_{false};
+
+    [[nodiscard]] bool match_strict(const InputSample& sample);
+    void move_cursor(CursorEventKind kind, std::size_t index);
+    void reset_input_state();
+    void emit(const CursorEvent& event) const;
+};
+
+} // namespace piano_assist
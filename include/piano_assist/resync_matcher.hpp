@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <unordered_map>
+
+#include "piano_assist/compiled_sheet.hpp"
+
+namespace piano_assist {
+
+inline constexpr std::size_t kDefaultResyncLookahead = 8;
+inline constexpr std::size_t kDefaultResyncConfirmations = 2;
+
+struct ResyncJump {
+    std::size_t skipped_begin{0};
+    std::size_t skipped_end{0};
+    std::size_t resume_at{0};
+};
+
+// Finds where the player has continued when they leave the expected note behind.
+// Chord masks in the window (cursor, cursor + lookahead] are indexed by their first
+// occurrence, so observe() is a single hash lookup regardless of the lookahead size.
+class ResyncMatcher final {
+public:
+    explicit ResyncMatcher(
+        std::size_t lookahead = kDefaultResyncLookahead,
+        std::size_t confirmations = kDefaultResyncConfirmations
+    );
+
+    void load(const CompiledSheet* sheet);
+    void set_lookahead(std::size_t lookahead);
+    void seek(std::size_t cursor);
+
+    [[nodiscard]] std::optional<ResyncJump> observe(KeyMask played);
+    [[nodiscard]] bool has_candidate() const;
+
+private:
+    const CompiledSheet* sheet_{nullptr};
+    std::size_t lookahead_{0};
+    std::size_t confirmations_{1};
+    std::size_t cursor_{0};
+    std::size_t window_end_{0};
+    std::unordered_map<KeyMask, std::size_t> first_in_window_;
+    std::optional<std::size_t> candidate_start_;
+    std::size_t candidate_next_{0};
+
+    void rebuild_window();
+    void push_back_position(std::size_t index);
+    void pop_front_position(std::size_t index);
+};
+
+} // namespace piano_assist
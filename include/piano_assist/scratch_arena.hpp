@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+
+namespace piano_assist {
+
+inline constexpr std::size_t kScratchArenaInitialBytes = 64 * 1024;
+
+// Monotonic arena for data that lives no longer than one song load or one library scan:
+// line buffers, trimmed keys, parse results that get compiled, per-line layout scratch.
+// reset() gives everything back at once; the first block is kept, so a warm arena serves
+// a typical song without touching the global heap. Not thread-safe; use one per thread.
+class ScratchArena final {
+public:
+    explicit ScratchArena(std::size_t initial_bytes = kScratchArenaInitialBytes);
+    ScratchArena(const ScratchArena&) = delete;
+    ScratchArena& operator=(const ScratchArena&) = delete;
+
+    [[nodiscard]] std::pmr::memory_resource* resource() {
+        return &arena_;
+    }
+    void reset() {
+        arena_.release();
+    }
+
+private:
+    std::unique_ptr<std::byte[]> initial_block_;
+    std::pmr::monotonic_buffer_resource arena_;
+};
+
+} // namespace piano_assist
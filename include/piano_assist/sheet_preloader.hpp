@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "piano_assist/compiled_sheet.hpp"
+#include "piano_assist/overlay_layout.hpp"
+#include "piano_assist/song_repository.hpp"
+#include "piano_assist/types.hpp"
+
+namespace piano_assist {
+
+inline constexpr std::size_t kDefaultPreloadWorkers = 2;
+inline constexpr std::size_t kDefaultPreloadCapacity = 8;
+
+struct PreparedSheet {
+    Song song{};
+    OverlayChunkingMode chunking_mode{OverlayChunkingMode::AutoDetect};
+    CompiledSheet sheet{};
+    OverlayLayout overlay_layout{};
+};
+
+// Reads the song file once and builds everything select_song needs. Returns nothing if
+// should_stop() reports true between steps. The file text and the parse live in scratch and
+// nothing in the result points into it, so callers reset their arena once the call returns.
+[[nodiscard]] std::optional<PreparedSheet> prepare_sheet(
+    const SongRepository& repository,
+    const Song& song,
+    OverlayChunkingMode chunking_mode,
+    const std::function<bool()>& should_stop = {},
+    std::pmr::memory_resource* scratch = std::pmr::get_default_resource()
+);
+
+// Speculatively prepares the songs the user is likely to open next on a bounded pool of
+// worker threads. Retargeting cancels work for songs that are no longer wanted; finished
+// sheets stay in a small most-recently-used cache until taken.
+class SheetPreloader final {
+public:
+    explicit SheetPreloader(
+        SongRepository repository,
+        std::size_t worker_count = kDefaultPreloadWorkers,
+        std::size_t capacity = kDefaultPreloadCapacity
+    );
+    ~SheetPreloader();
+    SheetPreloader(const SheetPreloader&) = delete;
+    SheetPreloader& operator=(const SheetPreloader&) = delete;
+
+    void set_targets(const std::vector<Song>& songs, OverlayChunkingMode chunking_mode);
+    // Waits for a sheet that is already being prepared; nothing if it was never requested.
+    [[nodiscard]] std::optional<PreparedSheet> take(const Song& song, OverlayChunkingMode chunking_mode);
+    void invalidate(std::string_view song_id);
+    void stop();
+
+    [[nodiscard]] std::size_t cached_count() const;
+
+private:
+    enum class EntryState {
+        Queued,
+        Running,
+        Ready,
+    };
+
+    struct Entry {
+        Song song{};
+        OverlayChunkingMode chunking_mode{OverlayChunkingMode::AutoDetect};
+        EntryState state{EntryState::Queued};
+        std::atomic<bool> cancelled{false};
+        std::optional<PreparedSheet> result{};
+        std::uint64_t last_used{0};
+    };
+
+    SongRepository repository_;
+    std::size_t capacity_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable_any work_available_;
+    std::condition_variable_any work_finished_;
+    std::deque<std::shared_ptr<Entry>> queue_;
+    std::unordered_map<std::string, std::shared_ptr<Entry>> entries_;
+    std::uint64_t use_counter_{0};
+    std::vector<std::jthread> workers_;
+
+    void run(std::stop_token stop);
+    void cancel_locked(const std::shared_ptr<Entry>& entry);
+    void evict_locked();
+};
+
+} // namespace piano_assist
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "piano_assist/memory_accounting.hpp"
+#include "piano_assist/types.hpp"
+
+namespace piano_assist {
+
+using StringHandle = std::uint32_t;
+inline constexpr StringHandle kNoString = std::numeric_limits<StringHandle>::max();
+
+// Append-only character storage addressed by 32-bit handles. Each string is its length as a
+// 7-bit varint followed by its bytes, and a handle is where that starts. add() always stores a
+// new copy; intern() hands back the earlier handle when the same text was interned before,
+// which suits tags and other values shared by many songs.
+class StringPool final {
+public:
+    [[nodiscard]] StringHandle add(std::string_view value);
+    // Stores value with ASCII capitals folded, the way collation keys compare.
+    [[nodiscard]] StringHandle add_lowercase(std::string_view value);
+    [[nodiscard]] StringHandle intern(std::string_view value);
+    // The handle of an interned string, or kNoString.
+    [[nodiscard]] StringHandle find(std::string_view value) const;
+    // Valid until the next add() or intern().
+    [[nodiscard]] std::string_view view(StringHandle handle) const;
+
+    [[nodiscard]] std::size_t size() const {
+        return count_;
+    }
+    [[nodiscard]] std::size_t memory_bytes() const;
+    void shrink_to_fit();
+
+private:
+    AccountedVector<MemorySubsystem::Catalog, char> characters_;
+    std::size_t count_{0};
+    // Open addressing over interned handles; kNoString marks a free slot.
+    AccountedVector<MemorySubsystem::Catalog, StringHandle> interned_;
+    std::size_t interned_count_{0};
+
+    [[nodiscard]] std::size_t slot_of(std::string_view value) const;
+    void grow_interned();
+};
+
+inline constexpr std::uint8_t kRoundGrouping = 1U << 0U;
+inline constexpr std::uint8_t kPipeSustain = 1U << 1U;
+// The file is "<id>.PADATA", as imported songs are named.
+inline constexpr std::uint8_t kFileNamedById = 1U << 2U;
+// The file is "<name>.PADATA", as hand-copied and migrated legacy songs usually are.
+inline constexpr std::uint8_t kFileNamedByName = 1U << 3U;
+
+// One song in 24 bytes; every string lives in the catalog's pool.
+struct CatalogRecord {
+    StringHandle id{kNoString};
+    StringHandle name{kNoString};
+    // The case-folded name, shared with name when it has no capitals.
+    StringHandle collation_key{kNoString};
+    // kNoString when a kFileNamedBy* bit says how to rebuild it.
+    StringHandle file_name{kNoString};
+    std::uint32_t first_tag{0};
+    std::uint16_t tag_count{0};
+    // The k* bits above; clear grouping and sustain bits mean "[]" and '-'.
+    std::uint8_t config{0};
+};
+
+// Catalog indices in display order.
+using CatalogRows = AccountedVector<MemorySubsystem::Catalog, std::uint32_t>;
+
+// The song list as compact records. Songs are only materialized when a caller needs a Song,
+// and filtered or sorted lists are index vectors over an immutable catalog.
+class SongCatalog final {
+public:
+    using Index = std::uint32_t;
+
+    Index add(
+        std::string_view id,
+        std::string_view name,
+        std::string_view file_name,
+        char open_brace,
+        char close_brace,
+        char sustain_indicator,
+        std::uint32_t sheet_bytes = 0
+    );
+    Index add(const Song& song);
+    // Meant to be called once per song; a second call leaves the earlier tags unreachable.
+    void set_tags(Index index, std::span<const std::string> tags);
+
+    [[nodiscard]] std::size_t size() const {
+        return records_.size();
+    }
+    [[nodiscard]] bool empty() const {
+        return records_.empty();
+    }
+
+    [[nodiscard]] std::string_view id(Index index) const;
+    [[nodiscard]] std::string_view name(Index index) const;
+    [[nodiscard]] std::string_view collation_key(Index index) const;
+    [[nodiscard]] std::string file_name(Index index) const;
+    [[nodiscard]] char open_brace(Index index) const;
+    [[nodiscard]] char close_brace(Index index) const;
+    [[nodiscard]] char sustain_indicator(Index index) const;
+    [[nodiscard]] std::size_t tag_count(Index index) const;
+    [[nodiscard]] std::string_view tag(Index index, std::size_t position) const;
+    [[nodiscard]] bool has_tag(Index index, std::string_view tag) const;
+    [[nodiscard]] std::span<const StringHandle> tag_handles(Index index) const;
+    // The handle every song tagged tag shares, or kNoString when no song has it.
+    [[nodiscard]] StringHandle find_tag(std::string_view tag) const;
+    // Size of the sheet text as stored, which tracks the song's length without reading it.
+    [[nodiscard]] std::uint32_t sheet_bytes(Index index) const;
+    [[nodiscard]] Song song(Index index) const;
+
+    // Name, file, grouping, sustain and tags all match; ids are not compared.
+    [[nodiscard]] bool same_contents(Index index, const SongCatalog& other, Index other_index) const;
+
+    // Catalog order: case-folded name, then id.
+    void sort(CatalogRows& rows) const;
+    [[nodiscard]] CatalogRows sorted_rows() const;
+
+    [[nodiscard]] std::size_t memory_bytes() const;
+    // Drops the growth slack once loading is done.
+    void shrink_to_fit();
+
+private:
+    // A file name as two pieces, so rebuilt names compare without being built.
+    using FileNameParts = std::pair<std::string_view, std::string_view>;
+
+    StringPool strings_;
+    AccountedVector<MemorySubsystem::Catalog, CatalogRecord> records_;
+    AccountedVector<MemorySubsystem::Tags, StringHandle> tags_;
+    // Kept beside the records so they stay at 24 bytes.
+    AccountedVector<MemorySubsystem::Catalog, std::uint32_t> sheet_bytes_;
+
+    [[nodiscard]] FileNameParts file_name_parts(Index index) const;
+};
+
+// A list of songs to show: rows index into catalog, which every copy of the view shares.
+struct SongListView {
+    std::shared_ptr<const SongCatalog> catalog{};
+    CatalogRows rows{};
+
+    [[nodiscard]] std::size_t size() const {
+        return rows.size();
+    }
+    [[nodiscard]] bool empty() const {
+        return rows.empty();
+    }
+};
+
+} // namespace piano_assist
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "piano_assist/song_catalog.hpp"
+
+namespace piano_assist {
+
+struct RowRange {
+    std::size_t first{0};
+    std::size_t count{0};
+};
+
+// Applying removed (back to front, old indices), then inserted (front to back, new indices)
+// turns `before` into `after`; changed lists rows whose contents differ, in new indices.
+// reset is set when surviving rows were reordered and the caller should rebuild instead.
+struct SongListDiff {
+    bool reset{false};
+    std::vector<RowRange> removed{};
+    std::vector<RowRange> inserted{};
+    std::vector<RowRange> changed{};
+
+    [[nodiscard]] bool empty() const {
+        return !reset && removed.empty() && inserted.empty() && changed.empty();
+    }
+};
+
+// The views may index different catalogs; rows are matched by song id.
+[[nodiscard]] SongListDiff diff_song_lists(const SongListView& before, const SongListView& after);
+
+} // namespace piano_assist
@@ -1,6 +1,8 @@
 #pragma once
 
-#include <string>
+#include <cstddef>
+#include <memory_resource>
+#include <string_view>
 #include <vector>
 
 #include "piano_assist/types.hpp"
@@ -8,7 +10,25 @@
 namespace piano_assist {
 
 std::vector<NoteGroup> parse_sheet(
-    const std::string& raw,
+    std::string_view raw,
+    char open_brace,
+    char close_brace,
+    char sustain_indicator
+);
+
+// The same groups in a vector drawn from scratch, for parses that only feed compile_sheet
+// or a line count.
+std::pmr::vector<NoteGroup> parse_sheet(
+    std::string_view raw,
+    char open_brace,
+    char close_brace,
+    char sustain_indicator,
+    std::pmr::memory_resource* scratch
+);
+
+// How many groups parse_sheet would return, without building them.
+[[nodiscard]] std::size_t count_note_groups(
+    std::string_view raw,
     char open_brace,
     char close_brace,
     char sustain_indicator
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "piano_assist/play_history.hpp"
+#include "piano_assist/song_catalog.hpp"
+#include "piano_assist/song_repository.hpp"
+
+namespace piano_assist {
+
+enum class SongSortKey {
+    Name,
+    // Most recently played first; songs never played follow in name order.
+    RecentlyPlayed,
+    // Shortest sheet first.
+    Length,
+};
+
+inline constexpr std::size_t kNoLimit = std::numeric_limits<std::size_t>::max();
+// Rows the song table fetches at a time; a little more than a tall window shows at once.
+inline constexpr std::size_t kSongPageSize = 200;
+
+// The sort key of the last song on a page. Unlike an offset it still lands in the right place
+// when songs were added or removed before the next page is fetched.
+struct SongCursor {
+    std::int64_t number{0};
+    std::string key{};
+    std::string id{};
+};
+
+struct SongQuery {
+    // Case-insensitive part of the name.
+    std::string name{};
+    // A tag the song must carry.
+    std::string tag{};
+    // Exact text the sheet must contain. Sheets are read from disk, so this is checked last.
+    std::string content{};
+    SongSortKey sort{SongSortKey::Name};
+    bool descending{false};
+    // Resume after this song; offset then counts from there.
+    std::optional<SongCursor> after{};
+    std::size_t offset{0};
+    std::size_t limit{kNoLimit};
+};
+
+struct SongPage {
+    SongListView songs{};
+    // Set when more songs may match; pass it as SongQuery::after for the next page.
+    std::optional<SongCursor> next{};
+    // Songs the predicates were tried on, which is what a page costs.
+    std::size_t examined{0};
+};
+
+// Answers SongQuery against one catalog. A tag predicate walks only that tag's songs, and
+// each sort order is built the first time it is asked for, so a page costs about as many
+// songs as it had to look at rather than the size of the library. Safe to share between
+// threads once built.
+class SongQueryIndex final {
+public:
+    SongQueryIndex(std::shared_ptr<const SongCatalog> catalog, SongRepository repository, const PlayTimes& played);
+
+    // Stops early and returns an empty page once should_stop() reports true.
+    [[nodiscard]] SongPage run(const SongQuery& query, const std::function<bool()>& should_stop = {}) const;
+    // Whether the song is in the catalog and passes query's predicates, wherever it would sort.
+    [[nodiscard]] bool matches(const SongQuery& query, std::string_view song_id) const;
+
+    [[nodiscard]] const std::shared_ptr<const SongCatalog>& catalog() const {
+        return catalog_;
+    }
+    // Seconds since the epoch, or 0 for a song never played.
+    [[nodiscard]] std::int64_t played_at(SongCatalog::Index index) const;
+
+private:
+    struct SortKey;
+    struct Order {
+        std::once_flag built;
+        CatalogRows rows;
+    };
+    using Orders = std::array<Order, 3>;
+    struct Postings {
+        // In catalog index order.
+        CatalogRows rows;
+        mutable Orders orders;
+    };
+
+    std::shared_ptr<const SongCatalog> catalog_;
+    SongRepository repository_;
+    // Left empty when nothing in the catalog was played.
+    AccountedVector<MemorySubsystem::Catalog, std::int64_t> played_at_;
+    // Catalog indices ordered by song id.
+    CatalogRows by_id_;
+    // Every song carrying a tag, with that tag's own orders.
+    std::unordered_map<StringHandle, Postings> by_tag_;
+    mutable Orders orders_;
+
+    [[nodiscard]] SortKey key_of(SongSortKey sort, SongCatalog::Index index) const;
+    // songs in sort order, built the first time orders is asked for it; every song when songs is null.
+    [[nodiscard]] const CatalogRows& order(Orders& orders, SongSortKey sort, const CatalogRows* songs) const;
+    [[nodiscard]] std::optional<SongCatalog::Index> find(std::string_view song_id) const;
+};
+
+} // namespace piano_assist
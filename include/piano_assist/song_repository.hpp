@@ -1,22 +1,66 @@
 #pragma once
 
 #include <filesystem>
+#include <cstddef>
+#include <functional>
+#include <memory_resource>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <string_view>
 #include <vector>
 
+#include "piano_assist/song_catalog.hpp"
 #include "piano_assist/types.hpp"
 
 namespace piano_assist {
 
+// One song file as stored: modern files carry metadata, legacy ones only the grouping line.
+struct SongDocument {
+    std::string id{};
+    std::string display_name{};
+    char open_brace{'['};
+    char close_brace{']'};
+    char sustain_indicator{'-'};
+    std::string body{};
+    // Bytes of sheet text in the file, known even when the body itself was not read.
+    std::size_t body_bytes{0};
+    bool is_modern{false};
+};
+
+[[nodiscard]] SongDocument read_song_document(const std::filesystem::path& path);
+// Same, with the file and line buffers drawn from scratch.
+[[nodiscard]] SongDocument read_song_document(const std::filesystem::path& path, std::pmr::memory_resource* scratch);
+// Always writes the modern format; throws std::runtime_error if the file can't be opened.
+void write_song_document(const std::filesystem::path& path, const SongDocument& document);
+
+// Receives every song read so far, in directory order.
+using SongBatchCallback = std::function<void(const SongCatalog& songs_so_far)>;
+
 class SongRepository final {
 public:
     explicit SongRepository(std::filesystem::path sheet_folder);
 
     void ensure_storage() const;
     [[nodiscard]] std::vector<Song> list_songs(std::string_view filter = {}) const;
+    // Returns an empty list as soon as should_stop() reports true.
+    [[nodiscard]] std::vector<Song> list_songs(
+        std::string_view filter,
+        const std::function<bool()>& should_stop
+    ) const;
+    // The same songs as compact records, in directory order; sorted_rows() gives catalog order.
+    // Calls on_batch once first_batch songs have been read and again each time the count
+    // doubles, so a caller can show a growing prefix of a large catalog.
+    [[nodiscard]] SongCatalog load_catalog(
+        std::string_view filter,
+        const std::function<bool()>& should_stop,
+        std::size_t first_batch = 0,
+        const SongBatchCallback& on_batch = {}
+    ) const;
     [[nodiscard]] std::vector<NoteGroup> load_sheet(const Song& song) const;
     [[nodiscard]] std::string load_raw_sheet_text(const Song& song) const;
+    // The sheet text in scratch, for a load that only parses it.
+    [[nodiscard]] std::pmr::string load_raw_sheet_text(const Song& song, std::pmr::memory_resource* scratch) const;
 
     [[nodiscard]] std::string import_song(
         std::string_view requested_name,
@@ -29,14 +73,19 @@ public:
     void delete_song(const Song& song) const;
     void update_song_contents(const Song& song, std::string_view raw_sheet_data) const;
 
+    // Catalog order: case-insensitive name, then id.
+    static void sort_songs(std::vector<Song>& songs);
+
 private:
     std::filesystem::path sheet_folder_;
-    mutable bool migration_checked_{false};
+    // Shared by copies, so worker threads holding a copy never migrate the folder twice.
+    std::shared_ptr<std::once_flag> migration_once_;
 
     [[nodiscard]] static std::string to_lower(std::string_view value);
     [[nodiscard]] static std::string normalize_display_name(std::string_view name);
     [[nodiscard]] std::filesystem::path make_unique_path(std::string_view base_id) const;
     void migrate_legacy_files_if_needed() const;
+    void migrate_legacy_files() const;
 };
 
 } // namespace piano_assist
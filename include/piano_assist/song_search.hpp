@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "piano_assist/play_history.hpp"
+#include "piano_assist/song_query.hpp"
+#include "piano_assist/song_repository.hpp"
+#include "piano_assist/tag_store.hpp"
+
+namespace piano_assist {
+
+inline constexpr std::size_t kSearchFirstBatch = 64;
+
+struct SongSearchQuery {
+    SongQuery query{};
+    // Read the sheet folder again; otherwise the last catalog is queried as it is.
+    bool reload{true};
+    // Deliver sorted partial results while the catalog is still being read.
+    bool stream{false};
+};
+
+struct SongSearchResult {
+    std::uint64_t generation{0};
+    SongSearchQuery query{};
+    // What page was read from, for fetching the pages after it.
+    std::shared_ptr<const SongQueryIndex> index{};
+    SongPage page{};
+    std::vector<std::string> all_tags{};
+    bool complete{true};
+};
+
+// Runs catalog queries on a single background thread, which also prepares the sheet folder
+// before the first query. Submitting a query supersedes any query still scanning, which
+// notices the newer generation and abandons its work.
+class SongSearchWorker final {
+public:
+    // Called on the worker thread for each partial result of a streamed query and once for
+    // every query that ran to completion.
+    using Completion = std::function<void(SongSearchResult result)>;
+
+    SongSearchWorker(SongRepository repository, TagStore tag_store, PlayHistory play_history, Completion completion);
+    ~SongSearchWorker();
+    SongSearchWorker(const SongSearchWorker&) = delete;
+    SongSearchWorker& operator=(const SongSearchWorker&) = delete;
+
+    std::uint64_t submit(SongSearchQuery query);
+    void stop();
+
+    [[nodiscard]] std::uint64_t generation() const;
+
+private:
+    SongRepository repository_;
+    TagStore tag_store_;
+    PlayHistory play_history_;
+    Completion completion_;
+
+    // Only touched on the worker thread.
+    std::shared_ptr<const SongQueryIndex> index_;
+    std::vector<std::string> all_tags_;
+    std::uint64_t play_revision_{0};
+
+    std::mutex mutex_;
+    std::condition_variable_any wake_;
+    std::optional<SongSearchQuery> pending_;
+    std::atomic<std::uint64_t> generation_{0};
+    std::jthread worker_;
+
+    void run(std::stop_token stop);
+    [[nodiscard]] std::optional<SongSearchResult> execute(
+        const SongSearchQuery& query,
+        std::uint64_t generation,
+        const std::stop_token& stop
+    );
+};
+
+[[nodiscard]] std::vector<std::string> collect_tags(const SongTagMap& tags);
+
+} // namespace piano_assist
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <string_view>
+
+#include <QAbstractTableModel>
+
+#include "piano_assist/song_catalog.hpp"
+#include "piano_assist/song_list_diff.hpp"
+#include "piano_assist/song_query.hpp"
+#include "piano_assist/types.hpp"
+
+namespace piano_assist {
+
+class SongTableModel final : public QAbstractTableModel {
+public:
+    enum Column {
+        NameColumn = 0,
+        TagsColumn = 1,
+        ColumnCount = 2,
+    };
+
+    explicit SongTableModel(QObject* parent = nullptr);
+
+    [[nodiscard]] int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    [[nodiscard]] int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    [[nodiscard]] QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    [[nodiscard]] QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+    // Shows the first page of query and keeps index, so scrolling to the end fetches the next.
+    // Reports only the rows that actually changed, so views keep their selection and scroll position.
+    void set_page(std::shared_ptr<const SongQueryIndex> index, SongQuery query, SongPage page);
+
+    [[nodiscard]] bool canFetchMore(const QModelIndex& parent) const override;
+    void fetchMore(const QModelIndex& parent) override;
+
+    // A copy, since rows are catalog records rather than stored Songs.
+    [[nodiscard]] std::optional<Song> song_at(int row) const;
+    [[nodiscard]] std::optional<int> row_of(std::string_view song_id) const;
+    // Whether the song is among the query's results, including pages not fetched yet.
+    [[nodiscard]] bool contains(std::string_view song_id) const;
+
+private:
+    SongListView songs_;
+    std::shared_ptr<const SongQueryIndex> index_;
+    SongQuery query_;
+    std::optional<SongCursor> next_;
+    // Row numbers ordered by song id, for row_of().
+    CatalogRows rows_by_id_;
+
+    void set_rows(SongListView songs);
+    void rebuild_row_index();
+};
+
+} // namespace piano_assist
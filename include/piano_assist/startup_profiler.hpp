@@ -0,0 +1,81 @@
+#pragma once
+
+#include <chrono>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace piano_assist {
+
+inline constexpr std::string_view kStartupReportEnvironmentVariable = "SHEETMASTER_STARTUP_REPORT";
+inline constexpr std::string_view kStartupReportFlag = "--startup-report";
+
+struct StartupPhase {
+    std::string name{};
+    std::chrono::microseconds start{};
+    std::chrono::microseconds duration{};
+    bool ui_thread{true};
+};
+
+struct StartupMark {
+    std::string name{};
+    std::chrono::microseconds at{};
+};
+
+// Times the first occurrence of each named startup phase, from any thread. Recording is a
+// no-op until enable() is called, so the hooks can stay in code that also runs later.
+class StartupProfiler final {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit StartupProfiler(Clock::time_point origin = Clock::now());
+
+    // Later calls on the calling thread are reported as the UI thread.
+    void enable(std::filesystem::path report_path);
+    [[nodiscard]] bool enabled() const;
+
+    void record(std::string_view name, Clock::time_point start, Clock::time_point end);
+    void mark(std::string_view name, Clock::time_point at = Clock::now());
+
+    [[nodiscard]] std::vector<StartupPhase> phases() const;
+    [[nodiscard]] std::vector<StartupMark> marks() const;
+    [[nodiscard]] std::string to_json() const;
+    // Writes the report once; later calls do nothing.
+    bool write_report();
+
+private:
+    Clock::time_point origin_;
+    mutable std::mutex mutex_;
+    bool enabled_{false};
+    bool written_{false};
+    std::filesystem::path report_path_;
+    std::thread::id ui_thread_;
+    std::vector<StartupPhase> phases_;
+    std::vector<StartupMark> marks_;
+};
+
+// Times the enclosing scope as a startup phase.
+class ScopedStartupPhase final {
+public:
+    explicit ScopedStartupPhase(std::string_view name);
+    ~ScopedStartupPhase();
+    ScopedStartupPhase(const ScopedStartupPhase&) = delete;
+    ScopedStartupPhase& operator=(const ScopedStartupPhase&) = delete;
+
+private:
+    std::string_view name_;
+    StartupProfiler::Clock::time_point start_;
+};
+
+// The process-wide profiler the application's startup hooks report to.
+[[nodiscard]] StartupProfiler& startup_profiler();
+
+// The report path from --startup-report=<path>, --startup-report <path> or the
+// SHEETMASTER_STARTUP_REPORT environment variable, in that order of precedence.
+[[nodiscard]] std::optional<std::filesystem::path> startup_report_path(int argc, const char* const* argv);
+
+} // namespace piano_assist
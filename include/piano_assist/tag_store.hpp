@@ -3,22 +3,31 @@
 #include <filesystem>
 #include <string>
 #include <string_view>
+#include <unordered_map>
 #include <vector>
 
+#include "piano_assist/song_catalog.hpp"
 #include "piano_assist/types.hpp"
 
 namespace piano_assist {
 
+using SongTagMap = std::unordered_map<std::string, std::vector<std::string>>;
+
+// Every call reads or rewrites the whole file; a process-wide lock keeps concurrent callers consistent.
 class TagStore final {
 public:
     explicit TagStore(std::filesystem::path storage_file);
 
     void migrate_song_name_keys_to_ids(const std::vector<Song>& songs) const;
+    void migrate_song_name_keys_to_ids(const SongCatalog& catalog) const;
 
     [[nodiscard]] std::vector<std::string> tags_for_song(std::string_view song_name) const;
     [[nodiscard]] std::vector<std::string> list_all_tags() const;
+    [[nodiscard]] SongTagMap load_all() const;
 
     void set_tags_for_song(std::string_view song_name, const std::vector<std::string>& tags) const;
+    // Rewrites the whole file in one pass; for bulk writers such as the library generator.
+    void replace_all(const SongTagMap& tags) const;
     void remove_song(std::string_view song_name) const;
     void rename_song(std::string_view old_song_name, std::string_view new_song_name) const;
 
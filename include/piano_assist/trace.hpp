@@ -0,0 +1,103 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace piano_assist {
+
+inline constexpr std::string_view kTraceEnvironmentVariable = "SHEETMASTER_TRACE";
+inline constexpr std::string_view kTraceFlag = "--trace";
+inline constexpr std::size_t kTraceEventsPerThread = std::size_t{1} << 17;
+
+struct TraceEvent {
+    // Always a string literal, so recording never copies or allocates.
+    const char* name{nullptr};
+    std::chrono::nanoseconds start{};
+    std::chrono::nanoseconds duration{};
+};
+
+class TraceBuffer;
+
+// Collects complete-duration spans into one fixed-size buffer per thread and writes them in
+// Chrome's trace_event JSON, which Perfetto and chrome://tracing open directly. A thread takes
+// the lock only to register its buffer; recording is a store and a release of the buffer's
+// size, so to_json() can read every buffer while threads keep recording. Spans past a thread's
+// capacity are counted and dropped.
+class Tracer final {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit Tracer(std::size_t events_per_thread = kTraceEventsPerThread);
+    ~Tracer();
+    Tracer(const Tracer&) = delete;
+    Tracer& operator=(const Tracer&) = delete;
+
+    void enable(std::filesystem::path output_path);
+    [[nodiscard]] bool enabled() const {
+        return enabled_.load(std::memory_order_relaxed);
+    }
+
+    void record(const char* name, Clock::time_point start, Clock::time_point end);
+    // Labels the calling thread's track; a no-op while tracing is off.
+    void set_thread_name(std::string_view name);
+
+    [[nodiscard]] std::size_t event_count() const;
+    [[nodiscard]] std::size_t dropped_count() const;
+    [[nodiscard]] std::string to_json() const;
+    // Writes everything recorded so far to the path given to enable().
+    bool write() const;
+
+private:
+    std::atomic<bool> enabled_{false};
+    const std::uint64_t serial_;
+    const std::size_t events_per_thread_;
+    Clock::time_point origin_;
+    mutable std::mutex mutex_;
+    std::filesystem::path output_path_;
+    std::vector<std::unique_ptr<TraceBuffer>> buffers_;
+
+    [[nodiscard]] TraceBuffer& buffer_for_this_thread();
+};
+
+// Records the enclosing scope as one span if tracing was on when it was entered.
+class TraceSpan final {
+public:
+    explicit TraceSpan(const char* name, Tracer& tracer);
+    explicit TraceSpan(const char* name);
+    ~TraceSpan();
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    const char* name_;
+    Tracer* tracer_;
+    Tracer::Clock::time_point start_{};
+};
+
+// The process-wide tracer the SHEETMASTER_TRACE_SCOPE spans report to.
+[[nodiscard]] Tracer& tracer();
+
+// The output path from --trace=<path>, --trace <path> or the SHEETMASTER_TRACE environment
+// variable, in that order of precedence.
+[[nodiscard]] std::optional<std::filesystem::path> trace_output_path(int argc, const char* const* argv);
+
+} // namespace piano_assist
+
+// Spans exist only in builds configured with ENABLE_TRACING; otherwise they compile to nothing.
+#if defined(SHEETMASTER_TRACING)
+#define SHEETMASTER_TRACE_CONCAT_INNER(left, right) left##right
+#define SHEETMASTER_TRACE_CONCAT(left, right) SHEETMASTER_TRACE_CONCAT_INNER(left, right)
+#define SHEETMASTER_TRACE_SCOPE(name) \
+    const ::piano_assist::TraceSpan SHEETMASTER_TRACE_CONCAT(trace_span_, __LINE__)(name)
+#else
+#define SHEETMASTER_TRACE_SCOPE(name) static_cast<void>(0)
+#endif
@@ -7,6 +7,7 @@ namespace piano_assist {
 enum class OverlayChunkingMode {
     AutoDetect = 0,
     Smart = 1,
+    FitWidth = 2,
 };
 
 struct NoteGroup {
@@ -26,6 +27,10 @@ struct Song {
 struct AppSettings {
     bool strict_mode{true};
     int input_poll_interval_ms{8};
+    int chord_window_ms{50};
+    int resync_lookahead{8};
+    bool record_input_traces{false};
+    int autoplay_tempo{180};
     OverlayChunkingMode overlay_chunking_mode{OverlayChunkingMode::AutoDetect};
 };
 
@@ -0,0 +1,152 @@
+#include "piano_assist/autoplay.hpp"
+#include "piano_assist/autoplay_sleep.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stop_token>
+#include <utility>
+
+namespace piano_assist {
+namespace {
+
+constexpr std::int64_t kNanosecondsPerMinute = 60'000'000'000;
+
+bool is_sustain_marker(const char value, const char sustain_indicator) {
+    return value == sustain_indicator || value == '-' || value == '|';
+}
+
+// Sleeps on the high-resolution timer where there is one and a timed wait otherwise.
+class DeadlineSleeper final {
+public:
+    explicit DeadlineSleeper(const std::stop_token& stop) : stop_(stop), precise_(make_precise_sleeper(stop)) {}
+
+    // A coarse timed wait can wake late by its granularity, so the spin has to cover that too.
+    [[nodiscard]] std::chrono::nanoseconds spin_window(const std::chrono::nanoseconds requested) const {
+        return precise_ != nullptr ? requested : std::max<std::chrono::nanoseconds>(requested, kTimedWaitGranularity);
+    }
+
+    void sleep_until(const std::chrono::steady_clock::time_point wake_at) {
+        if (precise_ != nullptr && precise_->sleep_until(wake_at)) {
+            return;
+        }
+        std::unique_lock lock(mutex_);
+        wake_.wait_until(lock, stop_, wake_at, [] {
+            return false;
+        });
+    }
+
+private:
+    std::stop_token stop_;
+    std::unique_ptr<PreciseSleeper> precise_;
+    std::mutex mutex_;
+    std::condition_variable_any wake_;
+};
+
+void wait_until_deadline(
+    const std::chrono::steady_clock::time_point deadline,
+    const std::chrono::nanoseconds spin_window,
+    const std::stop_token& stop,
+    DeadlineSleeper& sleeper
+) {
+    sleeper.sleep_until(deadline - spin_window);
+
+    while (!stop.stop_requested() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::yield();
+    }
+}
+
+} // namespace
+
+#ifndef _WIN32
+std::unique_ptr<PreciseSleeper> make_precise_sleeper(const std::stop_token& /*stop*/) {
+    return nullptr;
+}
+#endif
+
+std::size_t sustain_steps(const std::string_view keys, const char sustain_indicator) {
+    std::size_t steps = 0;
+    for (auto it = keys.rbegin(); it != keys.rend() && is_sustain_marker(*it, sustain_indicator); ++it) {
+        ++steps;
+    }
+    return steps;
+}
+
+AutoplayTimeline build_autoplay_timeline(
+    const CompiledSheet& sheet,
+    const char sustain_indicator,
+    const int steps_per_minute
+) {
+    const std::int64_t tempo = std::max(steps_per_minute, 1);
+    AutoplayTimeline timeline{};
+    timeline.offsets.reserve(sheet.size() + 1);
+
+    // Offsets come from the integer step count, so rounding never accumulates across groups.
+    std::int64_t steps = 0;
+    timeline.offsets.emplace_back(0);
+    for (const NoteGroup& group : sheet.groups) {
+        steps += 1 + static_cast<std::int64_t>(sustain_steps(group.keys, sustain_indicator));
+        timeline.offsets.emplace_back(steps * kNanosecondsPerMinute / tempo);
+    }
+    return timeline;
+}
+
+DeadlineScheduler::DeadlineScheduler(const std::chrono::nanoseconds spin_window) : spin_window_(spin_window) {}
+
+DeadlineScheduler::~DeadlineScheduler() {
+    stop();
+}
+
+void DeadlineScheduler::start(AutoplayTimeline timeline, const std::size_t first_index, Callback callback) {
+    stop();
+    if (first_index >= timeline.group_count()) {
+        return;
+    }
+
+    active_ = std::make_shared<std::atomic<bool>>(true);
+    worker_ = std::jthread([timeline = std::move(timeline),
+                            first_index,
+                            callback = std::move(callback),
+                            spin_window = spin_window_,
+                            active = active_](const std::stop_token stop) {
+        const auto clear_active = [&active]() {
+            active->store(false);
+        };
+        DeadlineSleeper sleeper(stop);
+        const auto effective_spin_window = sleeper.spin_window(spin_window);
+        const auto origin = std::chrono::steady_clock::now() - timeline.offsets[first_index];
+        for (std::size_t index = first_index + 1; index < timeline.offsets.size(); ++index) {
+            const auto deadline = origin + timeline.offsets[index];
+            wait_until_deadline(deadline, effective_spin_window, stop, sleeper);
+            if (stop.stop_requested()) {
+                clear_active();
+                return;
+            }
+            callback(index, std::chrono::steady_clock::now() - deadline);
+        }
+        clear_active();
+    });
+}
+
+void DeadlineScheduler::stop() {
+    if (active_ != nullptr) {
+        active_->store(false);
+    }
+    if (worker_.joinable()) {
+        worker_.request_stop();
+        if (worker_.get_id() != std::this_thread::get_id()) {
+            worker_.join();
+        } else {
+            worker_.detach();
+        }
+    }
+}
+
+bool DeadlineScheduler::running() const {
+    return active_ != nullptr && active_->load();
+}
+
+} // namespace piano_assist
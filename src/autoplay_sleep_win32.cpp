@@ -0,0 +1,77 @@
+#include "piano_assist/autoplay_sleep.hpp"
+
+#include <algorithm>
+#include <array>
+#include <utility>
+
+#include <windows.h>
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+namespace piano_assist {
+namespace {
+
+struct HandleCloser {
+    void operator()(const HANDLE handle) const noexcept {
+        CloseHandle(handle);
+    }
+};
+using UniqueHandle = std::unique_ptr<void, HandleCloser>;
+
+struct SignalEvent {
+    HANDLE event;
+
+    void operator()() const noexcept {
+        SetEvent(event);
+    }
+};
+
+// A high-resolution waitable timer (Windows 10 1803 and later) wakes within about a millisecond
+// without raising the timer tick for the whole system.
+class WaitableTimerSleeper final : public PreciseSleeper {
+public:
+    WaitableTimerSleeper(UniqueHandle timer, UniqueHandle stop_event, const std::stop_token& stop)
+        : timer_(std::move(timer)),
+          stop_event_(std::move(stop_event)),
+          on_stop_(stop, SignalEvent{stop_event_.get()}) {}
+
+    bool sleep_until(const std::chrono::steady_clock::time_point wake_at) override {
+        const auto remaining = wake_at - std::chrono::steady_clock::now();
+        if (remaining <= std::chrono::nanoseconds::zero()) {
+            return true;
+        }
+
+        // A negative due time is relative, in 100 ns units.
+        LARGE_INTEGER due{};
+        due.QuadPart = -std::max<LONGLONG>(remaining.count() / 100, 1);
+        if (!SetWaitableTimer(timer_.get(), &due, 0, nullptr, nullptr, FALSE)) {
+            return false;
+        }
+        const std::array<HANDLE, 2> handles{timer_.get(), stop_event_.get()};
+        return WaitForMultipleObjects(static_cast<DWORD>(handles.size()), handles.data(), FALSE, INFINITE) !=
+               WAIT_FAILED;
+    }
+
+private:
+    UniqueHandle timer_;
+    UniqueHandle stop_event_;
+    // Declared last so it is unregistered before the event it signals is closed.
+    std::stop_callback<SignalEvent> on_stop_;
+};
+
+} // namespace
+
+std::unique_ptr<PreciseSleeper> make_precise_sleeper(const std::stop_token& stop) {
+    UniqueHandle timer(
+        CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS)
+    );
+    UniqueHandle stop_event(CreateEventW(nullptr, TRUE, FALSE, nullptr));
+    if (timer == nullptr || stop_event == nullptr) {
+        return nullptr;
+    }
+    return std::make_unique<WaitableTimerSleeper>(std::move(timer), std::move(stop_event), stop);
+}
+
+} // namespace piano_assist
@@ -0,0 +1,104 @@
+#include "piano_assist/chord_matcher.hpp"
+
+#include <cctype>
+
+namespace piano_assist {
+namespace {
+
+constexpr std::size_t kDigitSlotBase = 0;
+constexpr std::size_t kLetterSlotBase = 10;
+constexpr std::size_t kPunctuationSlotBase = 36;
+
+// Shifted characters resolve to the physical key that produces them on a US layout.
+constexpr std::string_view kShiftedDigits = ")!@#$%^&*(";
+constexpr std::string_view kPunctuation = "-=[]\\;',./";
+constexpr std::string_view kShiftedPunctuation = "_+{}|:\"<>?";
+
+} // namespace
+
+std::optional<std::size_t> key_slot(const char key) {
+    if (key >= '0' && key <= '9') {
+        return kDigitSlotBase + static_cast<std::size_t>(key - '0');
+    }
+    if (key >= 'a' && key <= 'z') {
+        return kLetterSlotBase + static_cast<std::size_t>(key - 'a');
+    }
+    if (key >= 'A' && key <= 'Z') {
+        return kLetterSlotBase + static_cast<std::size_t>(key - 'A');
+    }
+
+    if (const std::size_t index = kShiftedDigits.find(key); index != std::string_view::npos) {
+        return kDigitSlotBase + index;
+    }
+    if (const std::size_t index = kPunctuation.find(key); index != std::string_view::npos) {
+        return kPunctuationSlotBase + index;
+    }
+    if (const std::size_t index = kShiftedPunctuation.find(key); index != std::string_view::npos) {
+        return kPunctuationSlotBase + index;
+    }
+    return std::nullopt;
+}
+
+KeyMask chord_mask(const std::string_view keys) {
+    KeyMask mask = 0;
+    for (const char raw_key : keys) {
+        if (raw_key == '-' || raw_key == '|' || std::isspace(static_cast<unsigned char>(raw_key))) {
+            continue;
+        }
+
+        const std::optional<std::size_t> slot = key_slot(raw_key);
+        if (!slot.has_value()) {
+            return 0;
+        }
+        mask |= KeyMask{1} << *slot;
+    }
+    return mask;
+}
+
+WindowedChordMatcher::WindowedChordMatcher(const std::chrono::microseconds window, const bool strict_mode)
+    : window_(window), strict_mode_(strict_mode) {}
+
+void WindowedChordMatcher::set_window(const std::chrono::microseconds window) {
+    window_ = window;
+}
+
+void WindowedChordMatcher::reset(const KeyMask target) {
+    target_ = target;
+    pressed_ = 0;
+    window_start_ = {};
+}
+
+bool WindowedChordMatcher::feed(const KeyEvent& event) {
+    if (!event.down || target_ == 0 || event.slot >= kMonitoredKeyCount) {
+        return false;
+    }
+
+    const KeyMask bit = KeyMask{1} << event.slot;
+    if ((target_ & bit) == 0) {
+        if (strict_mode_) {
+            pressed_ = 0;
+        }
+        return false;
+    }
+
+    if (pressed_ != 0 && event.timestamp - window_start_ > window_) {
+        pressed_ = 0;
+    }
+    if (pressed_ == 0) {
+        window_start_ = event.timestamp;
+    }
+
+    pressed_ |= bit;
+    if (pressed_ != target_) {
+        return false;
+    }
+
+    pressed_ = 0;
+    return true;
+}
+
+KeyMask WindowedChordMatcher::target() const {
+    return target_;
+}
+
+} // namespace piano_assist
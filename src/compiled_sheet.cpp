@@ -0,0 +1,38 @@
+#include "piano_assist/compiled_sheet.hpp"
+
+#include <iterator>
+#include <unordered_map>
+#include <utility>
+
+namespace piano_assist {
+
+CompiledSheet compile_sheet(std::vector<NoteGroup> groups) {
+    return compile_sheet(std::span<NoteGroup>(groups), std::pmr::get_default_resource());
+}
+
+CompiledSheet compile_sheet(const std::span<NoteGroup> groups, std::pmr::memory_resource* scratch) {
+    CompiledSheet sheet{};
+    sheet.groups.assign(std::make_move_iterator(groups.begin()), std::make_move_iterator(groups.end()));
+    sheet.masks.reserve(sheet.groups.size());
+    for (const NoteGroup& group : sheet.groups) {
+        sheet.masks.push_back(chord_mask(group.keys));
+    }
+
+    sheet.next_same_mask.assign(sheet.masks.size(), kNoNextOccurrence);
+    std::pmr::unordered_map<KeyMask, std::size_t> last_seen(scratch);
+    last_seen.reserve(sheet.masks.size());
+    for (std::size_t index = sheet.masks.size(); index-- > 0;) {
+        const KeyMask mask = sheet.masks[index];
+        if (mask == 0) {
+            continue;
+        }
+        const auto [it, inserted] = last_seen.try_emplace(mask, index);
+        if (!inserted) {
+            sheet.next_same_mask[index] = it->second;
+            it->second = index;
+        }
+    }
+    return sheet;
+}
+
+} // namespace piano_assist
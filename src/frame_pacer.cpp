@@ -0,0 +1,53 @@
+#include "piano_assist/frame_pacer.hpp"
+
+#include <algorithm>
+
+namespace piano_assist {
+
+FramePacer::FramePacer(const std::chrono::nanoseconds frame_interval)
+    : frame_interval_(std::max(frame_interval, std::chrono::nanoseconds{0})) {}
+
+void FramePacer::set_frame_interval(const std::chrono::nanoseconds frame_interval) {
+    frame_interval_ = std::max(frame_interval, std::chrono::nanoseconds{0});
+}
+
+std::optional<std::chrono::nanoseconds> FramePacer::mark_dirty(const Clock::time_point now) {
+    ++marks_;
+    dirty_ = true;
+    if (scheduled_) {
+        return std::nullopt;
+    }
+
+    scheduled_ = true;
+    if (!last_flush_.has_value()) {
+        return std::chrono::nanoseconds{0};
+    }
+    const std::chrono::nanoseconds elapsed = now - *last_flush_;
+    return std::max(frame_interval_ - elapsed, std::chrono::nanoseconds{0});
+}
+
+bool FramePacer::begin_flush(const Clock::time_point now) {
+    scheduled_ = false;
+    if (!dirty_) {
+        return false;
+    }
+
+    dirty_ = false;
+    last_flush_ = now;
+    ++flushes_;
+    return true;
+}
+
+std::chrono::nanoseconds FramePacer::frame_interval() const {
+    return frame_interval_;
+}
+
+std::uint64_t FramePacer::marks() const {
+    return marks_;
+}
+
+std::uint64_t FramePacer::flushes() const {
+    return flushes_;
+}
+
+} // namespace piano_assist
@@ -0,0 +1,226 @@
+#include "piano_assist/input_trace.hpp"
+
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+namespace piano_assist {
+namespace {
+
+// Layout: magic, varint song id length, song id bytes, then records until end of file.
+// Each record is a tag byte followed by the varint microsecond delta from the previous
+// record. Key records pack the slot into the tag: 0x80 | (down << 6) | slot.
+constexpr std::string_view kTraceMagic = "PATRACE1";
+constexpr std::uint8_t kKeyRecordFlag = 0x80;
+constexpr std::uint8_t kKeyDownFlag = 0x40;
+constexpr std::uint8_t kKeySlotMask = 0x3F;
+
+void append_varint(std::string& out, std::uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7U;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+std::uint64_t read_varint(const std::string& data, std::size_t& offset) {
+    std::uint64_t value = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+        if (offset >= data.size()) {
+            throw std::runtime_error("Truncated input trace.");
+        }
+        const auto byte = static_cast<std::uint8_t>(data[offset++]);
+        value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return value;
+        }
+    }
+    throw std::runtime_error("Malformed varint in input trace.");
+}
+
+std::uint8_t record_tag(const TraceRecord& record) {
+    switch (record.kind) {
+    case TraceRecordKind::KeyDown:
+        return static_cast<std::uint8_t>(kKeyRecordFlag | kKeyDownFlag | (record.slot & kKeySlotMask));
+    case TraceRecordKind::KeyUp:
+        return static_cast<std::uint8_t>(kKeyRecordFlag | (record.slot & kKeySlotMask));
+    default:
+        return static_cast<std::uint8_t>(record.kind);
+    }
+}
+
+TraceRecord record_from_tag(const std::uint8_t tag) {
+    TraceRecord record{};
+    if ((tag & kKeyRecordFlag) != 0) {
+        record.kind = (tag & kKeyDownFlag) != 0 ? TraceRecordKind::KeyDown : TraceRecordKind::KeyUp;
+        record.slot = static_cast<std::uint8_t>(tag & kKeySlotMask);
+        if (record.slot >= kMonitoredKeyCount) {
+            throw std::runtime_error("Input trace references an unknown key.");
+        }
+        return record;
+    }
+    if (tag > static_cast<std::uint8_t>(TraceRecordKind::PauseUp)) {
+        throw std::runtime_error("Unknown input trace record.");
+    }
+    record.kind = static_cast<TraceRecordKind>(tag);
+    return record;
+}
+
+} // namespace
+
+void InputTraceRecorder::begin(std::string song_id) {
+    trace_ = InputTrace{std::move(song_id), {}};
+    origin_ = {};
+    previous_keys_ = 0;
+    previous_pause_ = false;
+    started_ = false;
+    active_ = true;
+}
+
+void InputTraceRecorder::record(const InputSample& sample) {
+    if (!active_) {
+        return;
+    }
+    if (!started_) {
+        origin_ = sample.timestamp;
+        started_ = true;
+    }
+
+    const std::chrono::microseconds timestamp = sample.timestamp - origin_;
+    for_each_key_edge(previous_keys_, sample.keys_down, [&](const std::uint8_t slot, const bool down) {
+        trace_.records.push_back(
+            TraceRecord{down ? TraceRecordKind::KeyDown : TraceRecordKind::KeyUp, timestamp, slot}
+        );
+    });
+    if (sample.pause_key_down != previous_pause_) {
+        trace_.records.push_back(TraceRecord{
+            sample.pause_key_down ? TraceRecordKind::PauseDown : TraceRecordKind::PauseUp,
+            timestamp,
+            0,
+        });
+    }
+    trace_.records.push_back(TraceRecord{TraceRecordKind::Poll, timestamp, 0});
+
+    previous_keys_ = sample.keys_down;
+    previous_pause_ = sample.pause_key_down;
+}
+
+std::optional<InputTrace> InputTraceRecorder::finish() {
+    if (!active_) {
+        return std::nullopt;
+    }
+    active_ = false;
+    if (trace_.records.empty()) {
+        return std::nullopt;
+    }
+    return std::exchange(trace_, InputTrace{});
+}
+
+bool InputTraceRecorder::active() const {
+    return active_;
+}
+
+void write_input_trace(const std::filesystem::path& path, const InputTrace& trace) {
+    std::string data(kTraceMagic);
+    append_varint(data, trace.song_id.size());
+    data.append(trace.song_id);
+
+    std::chrono::microseconds previous{};
+    for (const TraceRecord& record : trace.records) {
+        if (record.timestamp < previous) {
+            throw std::runtime_error("Input trace timestamps must not decrease.");
+        }
+        data.push_back(static_cast<char>(record_tag(record)));
+        append_varint(data, static_cast<std::uint64_t>((record.timestamp - previous).count()));
+        previous = record.timestamp;
+    }
+
+    std::error_code error;
+    if (path.has_parent_path()) {
+        std::filesystem::create_directories(path.parent_path(), error);
+    }
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("Unable to write input trace.");
+    }
+    out.write(data.data(), static_cast<std::streamsize>(data.size()));
+}
+
+InputTrace read_input_trace(const std::filesystem::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("Unable to read input trace.");
+    }
+    const std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if (data.compare(0, kTraceMagic.size(), kTraceMagic) != 0) {
+        throw std::runtime_error("Not an input trace file.");
+    }
+
+    InputTrace trace{};
+    std::size_t offset = kTraceMagic.size();
+    const std::uint64_t id_length = read_varint(data, offset);
+    if (id_length > data.size() - offset) {
+        throw std::runtime_error("Truncated input trace.");
+    }
+    trace.song_id = data.substr(offset, static_cast<std::size_t>(id_length));
+    offset += static_cast<std::size_t>(id_length);
+
+    std::chrono::microseconds timestamp{};
+    while (offset < data.size()) {
+        TraceRecord record = record_from_tag(static_cast<std::uint8_t>(data[offset++]));
+        timestamp += std::chrono::microseconds(static_cast<std::int64_t>(read_varint(data, offset)));
+        record.timestamp = timestamp;
+        trace.records.push_back(record);
+    }
+    return trace;
+}
+
+ReplayResult replay_input_trace(const InputTrace& trace, CompiledSheet sheet, const PlaybackOptions& options) {
+    ReplayResult result{};
+    PlaybackSession session(options);
+    session.subscribe([&result](const CursorEvent& event) {
+        if (event.kind == CursorEventKind::Advanced) {
+            ++result.advances;
+        } else if (event.kind == CursorEventKind::Resynced) {
+            ++result.resyncs;
+        }
+    });
+    session.load(std::move(sheet));
+
+    KeyMask keys_down = 0;
+    bool pause_down = false;
+    for (const TraceRecord& record : trace.records) {
+        switch (record.kind) {
+        case TraceRecordKind::KeyDown:
+            keys_down |= KeyMask{1} << record.slot;
+            break;
+        case TraceRecordKind::KeyUp:
+            keys_down &= ~(KeyMask{1} << record.slot);
+            break;
+        case TraceRecordKind::PauseDown:
+            pause_down = true;
+            break;
+        case TraceRecordKind::PauseUp:
+            pause_down = false;
+            break;
+        case TraceRecordKind::Poll:
+            session.tick(InputSample{record.timestamp, keys_down, pause_down});
+            ++result.polls;
+            break;
+        }
+    }
+
+    for (const NoteGroup& group : session.sheet().groups) {
+        if (!group.was_correct) {
+            ++result.missed_groups;
+        }
+    }
+    result.final_cursor = session.cursor();
+    result.completed = session.completed();
+    return result;
+}
+
+} // namespace piano_assist
@@ -0,0 +1,43 @@
+#include "piano_assist/key_list_model.hpp"
+
+#include <limits>
+
+#include <QString>
+
+namespace piano_assist {
+namespace {
+
+int to_qt_int(const std::size_t value) {
+    if (value > static_cast<std::size_t>(std::numeric_limits<int>::max())) {
+        return std::numeric_limits<int>::max();
+    }
+    return static_cast<int>(value);
+}
+
+} // namespace
+
+KeyListModel::KeyListModel(QObject* parent) : QAbstractListModel(parent) {}
+
+int KeyListModel::rowCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : to_qt_int(row_count_);
+}
+
+QVariant KeyListModel::data(const QModelIndex& index, const int role) const {
+    if (sheet_ == nullptr || !index.isValid() || role != Qt::DisplayRole || index.row() >= rowCount()) {
+        return {};
+    }
+
+    const std::size_t row = static_cast<std::size_t>(index.row());
+    return QString("%1. %2")
+        .arg(to_qt_int(row + 1))
+        .arg(QString::fromStdString(sheet_->groups[row].keys));
+}
+
+void KeyListModel::set_sheet(const CompiledSheet* sheet) {
+    beginResetModel();
+    sheet_ = sheet;
+    row_count_ = sheet == nullptr ? 0 : sheet->size();
+    endResetModel();
+}
+
+} // namespace piano_assist
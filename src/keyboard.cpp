@@ -1,21 +1,18 @@
 #include "piano_assist/keyboard.hpp"
 
 #include <array>
-#include <cctype>
 #include <cstddef>
-#include <unordered_set>
+
+#include "piano_assist/chord_matcher.hpp"
 
 #include <windows.h>
 
 namespace piano_assist {
 namespace {
 
-char normalize_key(const char value) {
-    return static_cast<char>(std::toupper(static_cast<unsigned char>(value)));
-}
-
-std::array<int, 46> monitored_vk_codes() {
-    std::array<int, 46> codes{};
+// Ordered to match the slot layout of KeyMask (see chord_matcher.hpp).
+std::array<int, kMonitoredKeyCount> monitored_vk_codes() {
+    std::array<int, kMonitoredKeyCount> codes{};
     int index = 0;
     for (int vk = 0x30; vk <= 0x39; ++vk) {
         codes[static_cast<std::size_t>(index++)] = vk;
@@ -44,59 +41,22 @@ std::array<int, 46> monitored_vk_codes() {
     return codes;
 }
 
-const std::array<int, 46>& get_monitored_vk_codes() {
-    static const std::array<int, 46> codes = monitored_vk_codes();
+const std::array<int, kMonitoredKeyCount>& get_monitored_vk_codes() {
+    static const std::array<int, kMonitoredKeyCount> codes = monitored_vk_codes();
     return codes;
 }
 
 } // namespace
 
-KeyboardInput::KeyboardInput(const bool strict_mode) : strict_mode_(strict_mode) {}
-
-void KeyboardInput::set_strict_mode(const bool strict_mode) {
-    strict_mode_ = strict_mode;
-}
-
-bool KeyboardInput::check_chord(const std::string_view keys) const {
-    std::unordered_set<int> required_vk_codes;
-    required_vk_codes.reserve(keys.size());
-
-    for (const char raw_key : keys) {
-        if (raw_key == '-' || raw_key == '|' || std::isspace(static_cast<unsigned char>(raw_key))) {
-            continue;
-        }
-
-        const char normalized = normalize_key(raw_key);
-        const SHORT vk = VkKeyScanA(normalized);
-        if (vk == -1) {
-            return false;
+KeyMask KeyboardInput::sample_key_mask() {
+    const std::array<int, kMonitoredKeyCount>& codes = get_monitored_vk_codes();
+    KeyMask mask = 0;
+    for (std::size_t slot = 0; slot < codes.size(); ++slot) {
+        if (GetAsyncKeyState(codes[slot]) & 0x8000) {
+            mask |= KeyMask{1} << slot;
         }
-        const int vk_code = vk & 0xFF;
-        required_vk_codes.insert(vk_code);
-        if ((GetAsyncKeyState(vk_code) & 0x8000) == 0) {
-            return false;
-        }
-    }
-
-    if (required_vk_codes.empty()) {
-        return false;
     }
-
-    if (!strict_mode_) {
-        return true;
-    }
-
-    for (const int vk : get_monitored_vk_codes()) {
-        if ((GetAsyncKeyState(vk) & 0x8000) == 0) {
-            continue;
-        }
-
-        if (required_vk_codes.find(vk) == required_vk_codes.end()) {
-            return false;
-        }
-    }
-
-    return true;
+    return mask;
 }
 
 bool KeyboardInput::is_any_monitored_key_down() {
@@ -108,6 +68,10 @@ bool KeyboardInput::is_any_monitored_key_down() {
     return false;
 }
 
+bool KeyboardInput::is_pause_key_down() {
+    return (GetAsyncKeyState(VK_RETURN) & 0x8000) != 0;
+}
+
 void KeyboardInput::wait_for_any_release() {
     bool any_pressed = true;
     while (any_pressed) {
@@ -0,0 +1,295 @@
+#include "piano_assist/library_generator.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <fstream>
+#include <random>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+#include "piano_assist/tag_store.hpp"
+
+namespace piano_assist {
+namespace {
+
+constexpr std::array<std::string_view, 24> kNameFirstWords{
+    "Moonlight", "Autumn", "Silent", "Golden", "River", "Winter", "Paper", "Summer",
+    "Crystal", "Midnight", "Falling", "Distant", "Lonely", "Morning", "Velvet", "Electric",
+    "Secret", "Endless", "Broken", "Northern", "Little", "Last", "Blue", "Wild",
+};
+constexpr std::array<std::string_view, 24> kNameSecondWords{
+    "Sonata", "Waltz", "Rain", "Lullaby", "Garden", "Dream", "Letter", "Serenade",
+    "Memories", "Heart", "Song", "Road", "Nocturne", "Light", "Sky", "Promise",
+    "Etude", "Theme", "Ocean", "Dance", "Prelude", "Melody", "Wish", "Story",
+};
+// Grouping and sustain characters are never emitted as keys, whatever the song's grouping.
+constexpr std::string_view kReservedCharacters = "[]()-|";
+constexpr std::array<std::string_view, 16> kTagPalette{
+    "Classical", "Pop", "Anime", "Film", "Game", "Jazz", "Easy", "Intermediate",
+    "Hard", "Favourite", "Practice", "Christmas", "Wedding", "OPM", "Ballad", "Rock",
+};
+
+// std distributions differ between standard libraries; these keep output identical everywhere.
+std::size_t pick_index(std::mt19937_64& rng, const std::size_t count) {
+    return count == 0 ? 0 : static_cast<std::size_t>(rng() % count);
+}
+
+double pick_unit(std::mt19937_64& rng) {
+    return static_cast<double>(rng() >> 11U) * 0x1.0p-53;
+}
+
+template <typename Values>
+auto pick(std::mt19937_64& rng, const Values& values) {
+    return values[pick_index(rng, values.size())];
+}
+
+std::string lower(std::string value) {
+    std::transform(value.begin(), value.end(), value.begin(), [](const unsigned char c) {
+        return static_cast<char>(std::tolower(c));
+    });
+    return value;
+}
+
+std::string id_for(const std::string& name, std::mt19937_64& rng) {
+    std::string slug;
+    for (const char c : lower(name)) {
+        if (std::isalnum(static_cast<unsigned char>(c)) != 0) {
+            slug.push_back(c);
+        } else if (!slug.empty() && slug.back() != '_') {
+            slug.push_back('_');
+        }
+    }
+    while (!slug.empty() && slug.back() == '_') {
+        slug.pop_back();
+    }
+
+    std::ostringstream id;
+    id << slug << '_' << std::hex << rng();
+    return id.str();
+}
+
+// Reserves a file stem that no earlier file with the same extension uses, compared case-insensitively.
+std::string unique_stem(const std::string& name, std::set<std::string>& taken) {
+    std::string stem = name;
+    for (int suffix = 2; !taken.insert(lower(stem)).second; ++suffix) {
+        stem = name + " (" + std::to_string(suffix) + ")";
+    }
+    return stem;
+}
+
+std::string make_body(
+    const LibraryProfile& profile,
+    const char open_brace,
+    const char close_brace,
+    const char sustain_indicator,
+    std::mt19937_64& rng,
+    std::size_t& notes
+) {
+    std::string body;
+    const std::size_t line_count = std::max<std::size_t>(pick(rng, profile.line_counts), 1);
+    for (std::size_t line = 0; line < line_count; ++line) {
+        if (line > 0) {
+            body.push_back('\n');
+        }
+        const std::size_t length = std::max<std::size_t>(pick(rng, profile.line_lengths), 1);
+        for (std::size_t token = 0; token < length; ++token) {
+            if (token > 0) {
+                body.push_back(' ');
+            }
+            const std::size_t chord_size = std::max<std::size_t>(pick(rng, profile.chord_sizes), 1);
+            if (chord_size > 1) {
+                body.push_back(open_brace);
+            }
+            for (std::size_t key = 0; key < chord_size; ++key) {
+                body.push_back(pick(rng, profile.keys));
+            }
+            if (chord_size > 1) {
+                body.push_back(close_brace);
+            }
+            if (pick_unit(rng) < profile.sustain_rate) {
+                body.push_back(sustain_indicator);
+            }
+            ++notes;
+        }
+    }
+    return body;
+}
+
+std::vector<std::string> make_tags(const LibraryOptions& options, std::mt19937_64& rng) {
+    std::vector<std::string> tags;
+    const std::size_t count = 1 + pick_index(rng, std::max<std::size_t>(options.max_tags_per_song, 1));
+    for (std::size_t index = 0; index < count; ++index) {
+        // Squaring skews picks toward the front of the palette, like real tag usage.
+        const double skewed = pick_unit(rng) * pick_unit(rng);
+        const std::string tag(kTagPalette[static_cast<std::size_t>(skewed * static_cast<double>(kTagPalette.size()))]);
+        if (std::find(tags.begin(), tags.end(), tag) == tags.end()) {
+            tags.push_back(tag);
+        }
+    }
+    return tags;
+}
+
+} // namespace
+
+LibraryProfile default_library_profile() {
+    LibraryProfile profile{};
+    profile.chord_sizes = {1, 1, 1, 1, 1, 1, 1, 2, 2, 3};
+    profile.line_lengths = {4, 5, 6, 6, 7, 8, 8, 9, 10, 12};
+    profile.line_counts = {20, 30, 40, 45, 50, 60, 80};
+    profile.keys = "1234567890qwertyuiopasdfghjklzxcvbnmQWETYIOPSDGHJLZCVB!@$%^*";
+    profile.sustain_rate = 0.05;
+    profile.round_brace_rate = 0.2;
+    return profile;
+}
+
+LibraryProfile profile_from_corpus(const std::vector<SongDocument>& corpus) {
+    LibraryProfile profile{};
+    std::size_t notes = 0;
+    std::size_t sustains = 0;
+    std::size_t round_braces = 0;
+
+    for (const SongDocument& document : corpus) {
+        if (document.open_brace == '(') {
+            ++round_braces;
+        }
+
+        std::istringstream lines(document.body);
+        std::string line;
+        std::size_t line_count = 0;
+        while (std::getline(lines, line)) {
+            std::size_t line_notes = 0;
+            for (std::size_t index = 0; index < line.size(); ++index) {
+                const char c = line[index];
+                if (std::isspace(static_cast<unsigned char>(c)) != 0) {
+                    continue;
+                }
+                if (c == document.sustain_indicator) {
+                    ++sustains;
+                    continue;
+                }
+                if (c == document.open_brace) {
+                    const std::size_t close = line.find(document.close_brace, index + 1);
+                    const std::size_t end = close == std::string::npos ? line.size() : close;
+                    std::size_t size = 0;
+                    for (std::size_t key = index + 1; key < end; ++key) {
+                        if (std::isspace(static_cast<unsigned char>(line[key])) == 0 &&
+                            kReservedCharacters.find(line[key]) == std::string_view::npos) {
+                            profile.keys.push_back(line[key]);
+                            ++size;
+                        }
+                    }
+                    if (size > 0) {
+                        profile.chord_sizes.push_back(size);
+                        ++line_notes;
+                    }
+                    index = end;
+                    continue;
+                }
+                if (kReservedCharacters.find(c) != std::string_view::npos) {
+                    continue;
+                }
+                profile.keys.push_back(c);
+                profile.chord_sizes.push_back(1);
+                ++line_notes;
+            }
+            if (line_notes > 0) {
+                profile.line_lengths.push_back(line_notes);
+                ++line_count;
+                notes += line_notes;
+            }
+        }
+        if (line_count > 0) {
+            profile.line_counts.push_back(line_count);
+        }
+    }
+
+    if (notes == 0) {
+        return default_library_profile();
+    }
+    profile.sustain_rate = static_cast<double>(sustains) / static_cast<double>(notes);
+    profile.round_brace_rate = static_cast<double>(round_braces) / static_cast<double>(corpus.size());
+    return profile;
+}
+
+GeneratedLibrary generate_library(
+    const std::filesystem::path& folder,
+    const LibraryProfile& profile,
+    const LibraryOptions& options
+) {
+    if (profile.keys.empty() || profile.chord_sizes.empty() || profile.line_lengths.empty() || profile.line_counts.empty()) {
+        throw std::invalid_argument("Library profile has no samples.");
+    }
+    std::filesystem::create_directories(folder);
+
+    std::mt19937_64 rng(options.seed);
+    GeneratedLibrary generated{};
+    std::vector<std::string> names;
+    std::set<std::string> unique_names;
+    std::set<std::string> modern_stems;
+    std::set<std::string> legacy_stems;
+    SongTagMap tags;
+
+    for (std::size_t index = 0; index < options.song_count; ++index) {
+        std::string name;
+        if (!names.empty() && pick_unit(rng) < options.collision_rate) {
+            name = pick(rng, names);
+            ++generated.name_collisions;
+        } else {
+            name = std::string(pick(rng, kNameFirstWords)) + " " + std::string(pick(rng, kNameSecondWords));
+            for (std::size_t number = 2; !unique_names.insert(lower(name)).second; ++number) {
+                name = std::string(pick(rng, kNameFirstWords)) + " " + std::string(pick(rng, kNameSecondWords)) +
+                       " No. " + std::to_string(number);
+            }
+            names.push_back(name);
+        }
+
+        const bool round = pick_unit(rng) < profile.round_brace_rate;
+        const char open_brace = round ? '(' : '[';
+        const char close_brace = round ? ')' : ']';
+        const bool legacy = pick_unit(rng) < options.legacy_rate;
+        const bool tagged = pick_unit(rng) < options.tagged_rate;
+
+        if (legacy) {
+            // Legacy files have no metadata; most still open with their grouping line.
+            const bool grouping_line = round || pick_unit(rng) < 0.7;
+            const std::string body = make_body(profile, open_brace, close_brace, '-', rng, generated.notes);
+            std::ofstream out(folder / (unique_stem(name, legacy_stems) + ".txt"), std::ios::binary | std::ios::trunc);
+            if (grouping_line) {
+                out << open_brace << close_brace << '\n';
+            }
+            out << body << '\n';
+            if (!out) {
+                throw std::runtime_error("Unable to write song file.");
+            }
+            ++generated.legacy_files;
+            if (tagged) {
+                tags[name] = make_tags(options, rng);
+                ++generated.tagged_songs;
+            }
+            continue;
+        }
+
+        SongDocument document{};
+        document.id = id_for(name, rng);
+        document.display_name = name;
+        document.open_brace = open_brace;
+        document.close_brace = close_brace;
+        document.sustain_indicator = '-';
+        document.body = make_body(profile, open_brace, close_brace, '-', rng, generated.notes);
+        write_song_document(folder / (unique_stem(name, modern_stems) + ".PADATA"), document);
+        ++generated.modern_files;
+        if (tagged) {
+            tags[document.id] = make_tags(options, rng);
+            ++generated.tagged_songs;
+        }
+    }
+
+    TagStore(folder / "song_tags.PADISCRIM").replace_all(tags);
+    return generated;
+}
+
+} // namespace piano_assist
@@ -0,0 +1,252 @@
+#include "piano_assist/library_tools.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <exception>
+#include <map>
+#include <memory_resource>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+#include "piano_assist/scratch_arena.hpp"
+#include "piano_assist/song_parser.hpp"
+#include "piano_assist/trace.hpp"
+
+namespace piano_assist {
+namespace {
+
+constexpr std::string_view kSongDataExtension = ".PADATA";
+constexpr std::string_view kSongDataExtensionLower = ".padata";
+constexpr std::string_view kLegacySongDataExtensionLower = ".txt";
+
+std::string lower(std::string value) {
+    std::transform(value.begin(), value.end(), value.begin(), [](const unsigned char c) {
+        return static_cast<char>(std::tolower(c));
+    });
+    return value;
+}
+
+bool is_legacy_file(const std::filesystem::path& path) {
+    return lower(path.extension().string()) == kLegacySongDataExtensionLower;
+}
+
+std::vector<std::filesystem::path> song_files(const std::filesystem::path& folder) {
+    std::vector<std::filesystem::path> paths;
+    std::error_code error;
+    for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(folder, error)) {
+        if (!entry.is_regular_file()) {
+            continue;
+        }
+        const std::string extension = lower(entry.path().extension().string());
+        if (extension == kSongDataExtensionLower || extension == kLegacySongDataExtensionLower) {
+            paths.push_back(entry.path());
+        }
+    }
+    std::sort(paths.begin(), paths.end());
+    return paths;
+}
+
+// Runs work(index, scratch) for every index below count, spread over up to jobs threads.
+// Each thread has its own arena, reset after every item.
+template <typename Work>
+void parallel_for(const std::size_t count, const std::size_t jobs, Work&& work) {
+    const std::size_t wanted = jobs == 0 ? std::max<unsigned>(std::thread::hardware_concurrency(), 1U) : jobs;
+    const std::size_t thread_count = std::min(wanted, count);
+    std::atomic<std::size_t> next{0};
+    const auto drain = [&next, count, &work]() {
+        ScratchArena arena;
+        for (std::size_t index = next++; index < count; index = next++) {
+            work(index, arena.resource());
+            arena.reset();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (std::size_t thread = 1; thread < thread_count; ++thread) {
+        threads.emplace_back([&drain]() {
+            tracer().set_thread_name("library_worker");
+            drain();
+        });
+    }
+    drain();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+SheetReport report_for(const std::filesystem::path& path, std::pmr::memory_resource* scratch) {
+    SheetReport report{};
+    report.path = path;
+    const SongDocument document = read_song_document(path, scratch);
+    report.id = document.id;
+    report.name = document.display_name;
+    report.is_modern = document.is_modern;
+    report.issues = check_sheet_brackets(document.body, document.open_brace, document.close_brace);
+
+    const std::pmr::vector<NoteGroup> groups =
+        parse_sheet(document.body, document.open_brace, document.close_brace, document.sustain_indicator, scratch);
+    report.note_groups = groups.size();
+    for (const NoteGroup& group : groups) {
+        const std::size_t size = static_cast<std::size_t>(std::count_if(group.keys.begin(), group.keys.end(), [&](const char c) {
+            return c != document.sustain_indicator && c != '-' && c != '|';
+        }));
+        if (report.chord_sizes.size() <= size) {
+            report.chord_sizes.resize(size + 1, 0);
+        }
+        ++report.chord_sizes[size];
+        report.keys += size;
+    }
+    return report;
+}
+
+} // namespace
+
+std::string_view describe_sheet_issue(const SheetIssueKind kind) {
+    switch (kind) {
+    case SheetIssueKind::UnclosedGroup:
+        return "unclosed group";
+    case SheetIssueKind::UnopenedGroup:
+        return "closing bracket without an open group";
+    case SheetIssueKind::NestedGroup:
+        return "group opened inside another group";
+    }
+    return "unknown issue";
+}
+
+std::vector<SheetIssue> check_sheet_brackets(const std::string_view body, const char open_brace, const char close_brace) {
+    std::vector<SheetIssue> issues;
+    std::size_t line = 1;
+    std::size_t column = 0;
+    bool open = false;
+    SheetIssue open_at{};
+
+    for (const char c : body) {
+        ++column;
+        if (c == '\n') {
+            ++line;
+            column = 0;
+            continue;
+        }
+        if (c == open_brace) {
+            if (open) {
+                issues.push_back(SheetIssue{SheetIssueKind::NestedGroup, line, column});
+            }
+            open = true;
+            open_at = SheetIssue{SheetIssueKind::UnclosedGroup, line, column};
+        } else if (c == close_brace) {
+            if (!open) {
+                issues.push_back(SheetIssue{SheetIssueKind::UnopenedGroup, line, column});
+            }
+            open = false;
+        }
+    }
+
+    if (open) {
+        issues.push_back(open_at);
+    }
+    return issues;
+}
+
+std::vector<SheetReport> scan_library(const std::filesystem::path& folder, const std::size_t jobs) {
+    SHEETMASTER_TRACE_SCOPE("scan_library");
+    const std::vector<std::filesystem::path> paths = song_files(folder);
+    std::vector<SheetReport> reports(paths.size());
+    parallel_for(paths.size(), jobs, [&paths, &reports](const std::size_t index, std::pmr::memory_resource* scratch) {
+        reports[index] = report_for(paths[index], scratch);
+    });
+    return reports;
+}
+
+std::vector<DuplicateSongId> find_duplicate_ids(const std::vector<SheetReport>& reports) {
+    // Legacy files get their ids from unique file names during migration, so only stored ids can clash.
+    std::map<std::string, std::vector<std::filesystem::path>> paths_by_id;
+    for (const SheetReport& report : reports) {
+        if (report.is_modern && !report.id.empty()) {
+            paths_by_id[report.id].push_back(report.path);
+        }
+    }
+
+    std::vector<DuplicateSongId> duplicates;
+    for (auto& [id, paths] : paths_by_id) {
+        if (paths.size() > 1) {
+            duplicates.push_back(DuplicateSongId{id, std::move(paths)});
+        }
+    }
+    return duplicates;
+}
+
+LibraryStats summarize_library(const std::vector<SheetReport>& reports) {
+    LibraryStats stats{};
+    for (const SheetReport& report : reports) {
+        ++stats.songs;
+        if (!report.is_modern) {
+            ++stats.legacy_songs;
+        }
+        if (!report.issues.empty()) {
+            ++stats.songs_with_issues;
+        }
+        stats.note_groups += report.note_groups;
+        stats.keys += report.keys;
+        if (stats.chord_sizes.size() < report.chord_sizes.size()) {
+            stats.chord_sizes.resize(report.chord_sizes.size(), 0);
+        }
+        for (std::size_t size = 0; size < report.chord_sizes.size(); ++size) {
+            stats.chord_sizes[size] += report.chord_sizes[size];
+        }
+    }
+    return stats;
+}
+
+ConvertedLibrary convert_library(
+    const std::filesystem::path& input,
+    const std::filesystem::path& output,
+    const std::size_t jobs
+) {
+    SHEETMASTER_TRACE_SCOPE("convert_library");
+    std::error_code error;
+    if (std::filesystem::equivalent(input, output, error)) {
+        throw std::invalid_argument("Output folder must differ from the input folder.");
+    }
+    std::filesystem::create_directories(output);
+
+    // Targets are picked up front, in file name order, so the result never depends on thread timing.
+    // Modern files keep their names; legacy ones take the next free "<stem> (n)" like migration does.
+    const std::vector<std::filesystem::path> paths = song_files(input);
+    std::vector<std::filesystem::path> targets(paths.size());
+    std::set<std::string> taken;
+    for (std::size_t index = 0; index < paths.size(); ++index) {
+        if (!is_legacy_file(paths[index])) {
+            targets[index] = output / (paths[index].stem().string() + std::string(kSongDataExtension));
+            taken.insert(lower(targets[index].filename().string()));
+        }
+    }
+    for (std::size_t index = 0; index < paths.size(); ++index) {
+        if (!is_legacy_file(paths[index])) {
+            continue;
+        }
+        const std::string stem = paths[index].stem().string();
+        std::string file_name = stem + std::string(kSongDataExtension);
+        for (int suffix = 2; !taken.insert(lower(file_name)).second; ++suffix) {
+            file_name = stem + " (" + std::to_string(suffix) + ")" + std::string(kSongDataExtension);
+        }
+        targets[index] = output / file_name;
+    }
+
+    std::atomic<std::size_t> converted{0};
+    std::atomic<std::size_t> failed{0};
+    parallel_for(paths.size(), jobs, [&](const std::size_t index, std::pmr::memory_resource* scratch) {
+        try {
+            // An empty id or name is filled from the target file name, exactly as migration does.
+            write_song_document(targets[index], read_song_document(paths[index], scratch));
+            ++converted;
+        } catch (const std::exception&) {
+            ++failed;
+        }
+    });
+    return ConvertedLibrary{converted.load(), failed.load()};
+}
+
+} // namespace piano_assist
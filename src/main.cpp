@@ -1,7 +1,11 @@
+#include <optional>
+
 #include <QApplication>
 #include <QIcon>
 
 #include "piano_assist/main_window.hpp"
+#include "piano_assist/startup_profiler.hpp"
+#include "piano_assist/trace.hpp"
 
 #ifndef APP_VERSION
 #define APP_VERSION "0.0.0"
@@ -9,6 +13,19 @@
 
 int main(int argc, char *argv[])
 {
+    // First use fixes the profiler's origin, so this must stay ahead of QApplication.
+    piano_assist::StartupProfiler& profiler = piano_assist::startup_profiler();
+    if (const std::optional report_path = piano_assist::startup_report_path(argc, argv))
+    {
+        profiler.enable(*report_path);
+    }
+    if (const std::optional trace_path = piano_assist::trace_output_path(argc, argv))
+    {
+        piano_assist::tracer().enable(*trace_path);
+        piano_assist::tracer().set_thread_name("ui");
+    }
+
+    const auto app_started = piano_assist::StartupProfiler::Clock::now();
     QApplication app(argc, argv);
     QApplication::setApplicationName(QStringLiteral("SheetMaster"));
     QApplication::setApplicationDisplayName(QStringLiteral("SheetMaster"));
@@ -20,12 +37,18 @@ int main(int argc, char *argv[])
     {
         app.setWindowIcon(app_icon);
     }
+    profiler.record("qapplication_init", app_started, piano_assist::StartupProfiler::Clock::now());
 
+    const auto window_started = piano_assist::StartupProfiler::Clock::now();
     piano_assist::MainWindow window;
     if (!app_icon.isNull())
     {
         window.setWindowIcon(app_icon);
     }
+    profiler.record("main_window_construction", window_started, piano_assist::StartupProfiler::Clock::now());
+
     window.show();
-    return app.exec();
+    const int exit_code = app.exec();
+    piano_assist::tracer().write();
+    return exit_code;
 }
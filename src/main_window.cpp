@@ -1,53 +1,74 @@
 #include "piano_assist/main_window.hpp"
 
 #include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
 #include <exception>
+#include <filesystem>
 #include <limits>
 #include <memory>
-#include <sstream>
+#include <span>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "piano_assist/floating_overlay_window.hpp"
-#include "piano_assist/song_parser.hpp"
+#include "piano_assist/key_list_model.hpp"
+#include "piano_assist/memory_accounting.hpp"
+#include "piano_assist/song_list_diff.hpp"
+#include "piano_assist/song_table_model.hpp"
+#include "piano_assist/trace.hpp"
 
 #include <QAbstractItemView>
 #include <QCheckBox>
 #include <QComboBox>
+#include <QDateTime>
 #include <QDialog>
 #include <QDialogButtonBox>
+#include <QEvent>
 #include <QFormLayout>
+#include <QGuiApplication>
 #include <QFont>
+#include <QGridLayout>
 #include <QGroupBox>
 #include <QHBoxLayout>
 #include <QHeaderView>
+#include <QItemSelectionModel>
 #include <QLabel>
 #include <QLineEdit>
-#include <QListWidget>
+#include <QListView>
 #include <QMessageBox>
+#include <QStatusBar>
 #include <QPlainTextEdit>
 #include <QPushButton>
+#include <QScreen>
 #include <QSignalBlocker>
 #include <QSpinBox>
-#include <QTableWidget>
-#include <QTableWidgetItem>
+#include <QTableView>
 #include <QStringList>
 #include <QVBoxLayout>
 #include <QWidget>
 
-#ifndef NOMINMAX
-#define NOMINMAX
-#endif
-#include <windows.h>
-
 namespace piano_assist {
 namespace {
 
 constexpr std::string_view kDefaultTag = "Virtual Piano";
-constexpr std::size_t kOverlayChunkSizeNoBreaks = 10;
-constexpr std::size_t kOverlaySmartChunkMin = 10;
-constexpr std::size_t kOverlaySmartChunkMax = 16;
+constexpr std::string_view kTraceFolder = "traces";
+constexpr std::string_view kTraceExtension = ".PATRACE";
+constexpr int kSearchDebounceMs = 150;
+constexpr int kStartupStatusTimeoutMs = 8000;
+constexpr int kDiagnosticsRefreshMs = 1000;
+
+QString format_bytes(const std::size_t bytes) {
+    if (bytes >= 1024 * 1024) {
+        return QString::number(static_cast<double>(bytes) / (1024.0 * 1024.0), 'f', 2) + " MiB";
+    }
+    if (bytes >= 1024) {
+        return QString::number(static_cast<double>(bytes) / 1024.0, 'f', 1) + " KiB";
+    }
+    return QString::number(bytes) + " B";
+}
 
 int to_qt_int(const std::size_t value) {
     if (value > static_cast<std::size_t>(std::numeric_limits<int>::max())) {
@@ -118,11 +139,37 @@ char sustain_from_token(const QString& token) {
 }
 
 int chunking_mode_to_combo_index(const OverlayChunkingMode mode) {
-    return mode == OverlayChunkingMode::Smart ? 1 : 0;
+    return static_cast<int>(mode);
 }
 
 OverlayChunkingMode chunking_mode_from_combo_index(const int index) {
-    return index == 1 ? OverlayChunkingMode::Smart : OverlayChunkingMode::AutoDetect;
+    switch (index) {
+        case 1:
+            return OverlayChunkingMode::Smart;
+        case 2:
+            return OverlayChunkingMode::FitWidth;
+        default:
+            return OverlayChunkingMode::AutoDetect;
+    }
+}
+
+PlaybackOptions playback_options_from(const AppSettings& settings) {
+    PlaybackOptions options{};
+    options.strict_mode = settings.strict_mode;
+    options.chord_window = std::chrono::milliseconds(settings.chord_window_ms);
+    options.resync_lookahead = static_cast<std::size_t>(std::max(settings.resync_lookahead, 0));
+    return options;
+}
+
+std::chrono::nanoseconds frame_interval_for(const QScreen* screen) {
+    const double refresh_rate = screen == nullptr ? 60.0 : std::clamp(screen->refreshRate(), 30.0, 240.0);
+    return std::chrono::nanoseconds{static_cast<std::int64_t>(1'000'000'000.0 / refresh_rate)};
+}
+
+std::chrono::microseconds monotonic_now() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()
+    );
 }
 
 } // namespace
@@ -131,32 +178,83 @@ MainWindow::MainWindow(QWidget* parent)
     : QMainWindow(parent),
       repository_("sheets"),
       tag_store_("sheets/song_tags.PADISCRIM"),
+      play_history_("sheets/play_history.PADISCRIM"),
       settings_store_("settings.PACFG"),
       settings_(settings_store_.load()),
-      keyboard_(settings_.strict_mode) {
-    repository_.ensure_storage();
+      session_(playback_options_from(settings_)) {
+    startup_timer_.start();
     input_poll_timer_.setInterval(settings_.input_poll_interval_ms);
+    frame_timer_.setSingleShot(true);
+    frame_timer_.setTimerType(Qt::PreciseTimer);
+    frame_pacer_.set_frame_interval(frame_interval_for(QGuiApplication::primaryScreen()));
+    search_debounce_timer_.setSingleShot(true);
+    search_debounce_timer_.setInterval(kSearchDebounceMs);
+    sheet_preloader_ = std::make_unique<SheetPreloader>(repository_);
+    search_worker_ = std::make_unique<SongSearchWorker>(
+        repository_,
+        tag_store_,
+        play_history_,
+        [this](SongSearchResult result) {
+            const auto shared = std::make_shared<SongSearchResult>(std::move(result));
+            QMetaObject::invokeMethod(this, [this, shared]() {
+                apply_search_result(std::move(*shared));
+            }, Qt::QueuedConnection);
+        }
+    );
+    session_.subscribe([this](const CursorEvent& event) {
+        if (event.kind == CursorEventKind::PauseChanged && event.paused) {
+            stop_autoplay();
+        }
+        request_playback_view_update();
+    });
 
-    build_ui();
-    floating_overlay_ = std::make_unique<FloatingOverlayWindow>();
-    floating_overlay_->setAttribute(Qt::WA_QuitOnClose, false);
-    floating_overlay_->show();
+    {
+        const ScopedStartupPhase phase("build_ui");
+        build_ui();
+    }
 
-    refresh_song_list();
+    // The sheet folder is prepared and read on the search worker; rows stream in as they are read.
+    catalog_load_started_ = StartupProfiler::Clock::now();
+    submit_song_query(true, true);
 
     strict_mode_checkbox_->setChecked(settings_.strict_mode);
-    handle_overlay_toggle(overlay_checkbox_ != nullptr && overlay_checkbox_->isChecked());
+    // Created after the main window's first paint rather than before it.
+    QTimer::singleShot(0, this, [this]() {
+        handle_overlay_toggle(overlay_checkbox_ != nullptr && overlay_checkbox_->isChecked());
+    });
 
     connect(&input_poll_timer_, &QTimer::timeout, this, &MainWindow::poll_input);
+    connect(&frame_timer_, &QTimer::timeout, this, &MainWindow::flush_playback_view);
     input_poll_timer_.start();
 }
 
 MainWindow::~MainWindow() {
+    search_worker_->stop();
+    sheet_preloader_->stop();
+    stop_autoplay();
+    finish_trace_recording();
     if (floating_overlay_ != nullptr) {
         floating_overlay_->close();
     }
 }
 
+bool MainWindow::event(QEvent* event) {
+    const bool handled = QMainWindow::event(event);
+    // Top-level widgets paint their whole backing store while handling UpdateRequest.
+    if (!first_paint_done_ && event->type() == QEvent::UpdateRequest) {
+        first_paint_done_ = true;
+        startup_profiler().mark("first_paint");
+        finish_startup_report();
+    }
+    return handled;
+}
+
+void MainWindow::finish_startup_report() {
+    if (first_paint_done_ && catalog_loaded_) {
+        startup_profiler().write_report();
+    }
+}
+
 void MainWindow::build_ui() {
     setWindowTitle("SheetMaster");
     resize(1040, 760);
@@ -184,26 +282,36 @@ void MainWindow::build_ui() {
     tag_filter_ = new QComboBox(central);
     tag_filter_->setMinimumWidth(220);
 
+    auto* sort_label = new QLabel("Sort:", central);
+    sort_combo_ = new QComboBox(central);
+    sort_combo_->addItem("Name", static_cast<int>(SongSortKey::Name));
+    sort_combo_->addItem("Recently Played", static_cast<int>(SongSortKey::RecentlyPlayed));
+    sort_combo_->addItem("Length", static_cast<int>(SongSortKey::Length));
+
     filter_row->addWidget(search_label);
     filter_row->addWidget(search_edit_, 1);
     filter_row->addWidget(tag_label);
     filter_row->addWidget(tag_filter_);
+    filter_row->addWidget(sort_label);
+    filter_row->addWidget(sort_combo_);
     root_layout->addLayout(filter_row);
 
     auto* content_row = new QHBoxLayout();
     content_row->setSpacing(12);
 
-    song_table_ = new QTableWidget(central);
-    song_table_->setColumnCount(2);
-    song_table_->setHorizontalHeaderLabels({"Song", "Tags"});
+    song_table_model_ = new SongTableModel(this);
+    song_table_ = new QTableView(central);
+    song_table_->setModel(song_table_model_);
     song_table_->horizontalHeader()->setStretchLastSection(true);
     song_table_->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
     song_table_->verticalHeader()->setVisible(false);
+    song_table_->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
     song_table_->setSelectionBehavior(QAbstractItemView::SelectRows);
     song_table_->setSelectionMode(QAbstractItemView::SingleSelection);
     song_table_->setEditTriggers(QAbstractItemView::NoEditTriggers);
     song_table_->setAlternatingRowColors(true);
     song_table_->setMinimumHeight(280);
+    song_table_->setMouseTracking(true);
 
     auto* action_column = new QVBoxLayout();
     action_column->setSpacing(8);
@@ -211,9 +319,11 @@ void MainWindow::build_ui() {
     import_button_ = new QPushButton("Import Songs", central);
     manage_button_ = new QPushButton("Manage Songs", central);
     settings_button_ = new QPushButton("Settings", central);
+    diagnostics_button_ = new QPushButton("Diagnostics", central);
     action_column->addWidget(import_button_);
     action_column->addWidget(manage_button_);
     action_column->addWidget(settings_button_);
+    action_column->addWidget(diagnostics_button_);
     action_column->addStretch(1);
 
     content_row->addWidget(song_table_, 1);
@@ -227,37 +337,51 @@ void MainWindow::build_ui() {
     strict_mode_checkbox_ = new QCheckBox("Strict Mode", info_group);
     overlay_checkbox_ = new QCheckBox("Show Floating Overlay", info_group);
     overlay_checkbox_->setChecked(true);
+    autoplay_checkbox_ = new QCheckBox("Auto-Play Demo", info_group);
     info_layout->addWidget(current_song_label_);
     info_layout->addWidget(duration_label_);
     info_layout->addWidget(strict_mode_checkbox_);
     info_layout->addWidget(overlay_checkbox_);
+    info_layout->addWidget(autoplay_checkbox_);
     root_layout->addWidget(info_group);
 
     auto* key_list_label = new QLabel("Auto Scroller Keys", central);
-    key_list_ = new QListWidget(central);
+    key_list_model_ = new KeyListModel(this);
+    key_list_ = new QListView(central);
+    key_list_->setModel(key_list_model_);
+    key_list_->setUniformItemSizes(true);
+    key_list_->setEditTriggers(QAbstractItemView::NoEditTriggers);
     key_list_->setMinimumHeight(220);
     root_layout->addWidget(key_list_label);
     root_layout->addWidget(key_list_, 1);
 
     setCentralWidget(central);
 
-    connect(search_edit_, &QLineEdit::textChanged, this, &MainWindow::refresh_song_list);
+    connect(search_edit_, &QLineEdit::textChanged, this, &MainWindow::schedule_song_search);
+    connect(&search_debounce_timer_, &QTimer::timeout, this, &MainWindow::refresh_song_list);
     connect(tag_filter_, &QComboBox::currentTextChanged, this, &MainWindow::refresh_song_list);
-    connect(song_table_, &QTableWidget::cellDoubleClicked, this, &MainWindow::handle_song_double_click);
+    connect(sort_combo_, &QComboBox::currentIndexChanged, this, &MainWindow::refresh_song_list);
+    connect(song_table_, &QTableView::doubleClicked, this, &MainWindow::handle_song_double_click);
+    connect(song_table_, &QTableView::entered, this, &MainWindow::handle_song_hovered);
+    connect(
+        song_table_->selectionModel(),
+        &QItemSelectionModel::currentRowChanged,
+        this,
+        &MainWindow::update_preload_targets
+    );
     connect(import_button_, &QPushButton::clicked, this, &MainWindow::handle_import_songs);
     connect(manage_button_, &QPushButton::clicked, this, &MainWindow::handle_manage_songs);
     connect(settings_button_, &QPushButton::clicked, this, &MainWindow::handle_settings);
+    connect(diagnostics_button_, &QPushButton::clicked, this, &MainWindow::handle_diagnostics);
     connect(strict_mode_checkbox_, &QCheckBox::toggled, this, &MainWindow::handle_strict_mode_toggle);
     connect(overlay_checkbox_, &QCheckBox::toggled, this, &MainWindow::handle_overlay_toggle);
+    connect(autoplay_checkbox_, &QCheckBox::toggled, this, &MainWindow::handle_autoplay_toggle);
 }
 
-void MainWindow::repopulate_tag_filter() {
+void MainWindow::repopulate_tag_filter(const std::vector<std::string>& tags) {
     const QString previous = tag_filter_->currentText();
     const QSignalBlocker blocker(tag_filter_);
 
-    std::vector<std::string> tags = tag_store_.list_all_tags();
-    std::sort(tags.begin(), tags.end());
-
     tag_filter_->clear();
     tag_filter_->addItem("All Tags");
     for (const std::string& tag : tags) {
@@ -271,193 +395,204 @@ void MainWindow::repopulate_tag_filter() {
     tag_filter_->setCurrentIndex(index);
 }
 
+void MainWindow::schedule_song_search() {
+    search_debounce_timer_.start();
+}
+
 void MainWindow::refresh_song_list() {
-    const std::string search = search_edit_->text().trimmed().toStdString();
+    SHEETMASTER_TRACE_SCOPE("MainWindow::refresh_song_list");
+    submit_song_query(false, false);
+}
 
-    const std::vector<Song> songs = repository_.list_songs(search);
-    tag_store_.migrate_song_name_keys_to_ids(songs);
-    repopulate_tag_filter();
+void MainWindow::reload_song_list() {
+    SHEETMASTER_TRACE_SCOPE("MainWindow::reload_song_list");
+    submit_song_query(true, false);
+}
 
-    const std::string selected_tag = [&]() {
-        const QString selected = tag_filter_->currentText().trimmed();
-        if (selected.isEmpty() || selected == "All Tags") {
-            return std::string{};
-        }
-        return selected.toStdString();
-    }();
+void MainWindow::submit_song_query(const bool reload, const bool stream) {
+    search_debounce_timer_.stop();
 
-    visible_songs_.clear();
-    song_table_->clearContents();
-    song_table_->setRowCount(0);
+    SongSearchQuery request{};
+    request.reload = reload;
+    request.stream = stream;
+    request.query.name = search_edit_->text().trimmed().toStdString();
+    const QString selected = tag_filter_->currentText().trimmed();
+    if (!selected.isEmpty() && selected != "All Tags") {
+        request.query.tag = selected.toStdString();
+    }
+    request.query.sort = static_cast<SongSortKey>(sort_combo_->currentData().toInt());
+    // As many rows as are already fetched, so a refresh doesn't pull the list out from under the scroll position.
+    request.query.limit = std::max(kSongPageSize, static_cast<std::size_t>(song_table_model_->rowCount()));
+    search_worker_->submit(std::move(request));
+}
 
-    for (const Song& song : songs) {
-        const std::vector<std::string> tags = tag_store_.tags_for_song(song.id);
-        if (!selected_tag.empty() && !contains_tag(tags, selected_tag)) {
-            continue;
-        }
+void MainWindow::apply_search_result(SongSearchResult result) {
+    SHEETMASTER_TRACE_SCOPE("MainWindow::apply_search_result");
+    if (result.generation != search_worker_->generation()) {
+        return;
+    }
 
-        const int row = song_table_->rowCount();
-        song_table_->insertRow(row);
-        song_table_->setItem(row, 0, new QTableWidgetItem(QString::fromStdString(song.name)));
-        song_table_->setItem(row, 1, new QTableWidgetItem(join_tags(tags)));
-        visible_songs_.push_back(song);
+    if (!result.complete) {
+        song_table_model_->set_page(std::move(result.index), std::move(result.query.query), std::move(result.page));
+        report_catalog_progress(false, 0);
+        return;
     }
 
+    repopulate_tag_filter(result.all_tags);
+    if (!result.query.query.tag.empty() && !contains_tag(result.all_tags, result.query.query.tag)) {
+        // The filtered tag no longer exists and the combo fell back to "All Tags".
+        refresh_song_list();
+        return;
+    }
+
+    const std::size_t song_count = result.index->catalog()->size();
+    song_table_model_->set_page(std::move(result.index), std::move(result.query.query), std::move(result.page));
+    report_catalog_progress(true, song_count);
+
     if (current_song_.has_value()) {
-        bool found = false;
-        for (int row = 0; row < song_table_->rowCount(); ++row) {
-            if (static_cast<std::size_t>(row) < visible_songs_.size() &&
-                visible_songs_[static_cast<std::size_t>(row)].id == current_song_->id) {
-                song_table_->selectRow(row);
-                found = true;
-                break;
-            }
+        const std::optional<int> row = song_table_model_->row_of(current_song_->id);
+        if (row.has_value() && song_table_->currentIndex().row() != *row) {
+            song_table_->selectRow(*row);
         }
-        if (!found) {
+        // A song still matching on a page not fetched yet stays loaded.
+        if (!row.has_value() && !song_table_model_->contains(current_song_->id)) {
+            stop_autoplay();
             current_song_.reset();
-            current_sheet_.clear();
-            current_index_ = 0;
-            waiting_for_release_ = false;
-            paused_ = false;
-            pause_key_latched_ = false;
-            key_list_->clear();
+            key_list_model_->set_sheet(nullptr);
+            session_.clear();
+            finish_trace_recording();
         }
     }
 
     update_playback_labels();
 }
 
-void MainWindow::handle_song_double_click(const int row, const int /*column*/) {
-    if (row < 0 || row >= static_cast<int>(visible_songs_.size())) {
+void MainWindow::report_catalog_progress(const bool complete, const std::size_t song_count) {
+    if (!first_row_ms_.has_value() && song_table_model_->rowCount() > 0) {
+        first_row_ms_ = startup_timer_.elapsed();
+        startup_profiler().mark("first_row");
+    }
+    if (!complete || catalog_loaded_) {
         return;
     }
 
-    select_song(visible_songs_[static_cast<std::size_t>(row)]);
-}
+    catalog_loaded_ = true;
+    QString message = QString("Loaded %1 songs in %2 ms").arg(song_count).arg(startup_timer_.elapsed());
+    if (first_row_ms_.has_value()) {
+        message += QString(" (first row after %1 ms)").arg(*first_row_ms_);
+    }
+    statusBar()->showMessage(message, kStartupStatusTimeoutMs);
 
-void MainWindow::select_song(const Song& song) {
-    current_song_ = song;
-    current_sheet_ = repository_.load_sheet(song);
-    rebuild_overlay_lines(song);
-    current_index_ = 0;
-    waiting_for_release_ = false;
-    paused_ = false;
-    pause_key_latched_ = false;
+    startup_profiler().record("first_refresh_song_list", catalog_load_started_, StartupProfiler::Clock::now());
+    finish_startup_report();
+}
 
-    key_list_->clear();
-    for (std::size_t index = 0; index < current_sheet_.size(); ++index) {
-        const QString line = QString("%1. %2")
-                                 .arg(to_qt_int(index + 1))
-                                 .arg(QString::fromStdString(current_sheet_[index].keys));
-        key_list_->addItem(line);
+void MainWindow::handle_song_double_click(const QModelIndex& index) {
+    const std::optional<Song> song = song_table_model_->song_at(index.row());
+    if (!song.has_value()) {
+        return;
     }
 
-    if (!current_sheet_.empty()) {
-        key_list_->setCurrentRow(0);
+    select_song(*song);
+    const auto now = std::chrono::system_clock::now().time_since_epoch();
+    play_history_.record_play(song->id, std::chrono::duration_cast<std::chrono::seconds>(now).count());
+    if (sort_combo_->currentData().toInt() == static_cast<int>(SongSortKey::RecentlyPlayed)) {
+        refresh_song_list();
     }
-
-    update_playback_labels();
 }
 
-void MainWindow::rebuild_overlay_lines(const Song& song) {
-    overlay_lines_.clear();
-    overlay_line_starts_.clear();
-
-    const auto build_fixed_chunks = [this](const std::size_t chunk_size) {
-        overlay_lines_.clear();
-        overlay_line_starts_.clear();
-
-        std::size_t start = 0;
-        while (start < current_sheet_.size()) {
-            const std::size_t end = std::min(start + chunk_size, current_sheet_.size());
-            overlay_line_starts_.push_back(start);
-            overlay_lines_.emplace_back();
-            std::vector<std::string>& keys = overlay_lines_.back();
-            keys.reserve(end - start);
-            for (std::size_t index = start; index < end; ++index) {
-                keys.push_back(current_sheet_[index].keys);
-            }
-            start = end;
-        }
-    };
-
-    const auto build_smart_chunks = [this, &song, &build_fixed_chunks]() {
-        overlay_lines_.clear();
-        overlay_line_starts_.clear();
+void MainWindow::handle_song_hovered(const QModelIndex& index) {
+    std::optional<Song> song = song_table_model_->song_at(index.row());
+    if (!song.has_value() || (hovered_song_.has_value() && hovered_song_->id == song->id)) {
+        return;
+    }
+    hovered_song_ = std::move(song);
+    update_preload_targets();
+}
 
-        if (current_sheet_.empty()) {
+void MainWindow::update_preload_targets() {
+    // The selected row, the row after it and the hovered row are the likely next picks.
+    std::vector<Song> targets;
+    const auto add_target = [this, &targets](const std::optional<Song>& song) {
+        if (!song.has_value() || (current_song_.has_value() && current_song_->id == song->id)) {
             return;
         }
+        const bool duplicate = std::any_of(targets.begin(), targets.end(), [&song](const Song& target) {
+            return target.id == song->id;
+        });
+        if (!duplicate) {
+            targets.push_back(*song);
+        }
+    };
 
-        auto has_sustain = [&song](const std::string& keys) {
-            return keys.find(song.sustain_indicator) != std::string::npos ||
-                   keys.find('-') != std::string::npos ||
-                   keys.find('|') != std::string::npos;
-        };
+    const int selected_row = song_table_->currentIndex().row();
+    if (selected_row >= 0) {
+        add_target(song_table_model_->song_at(selected_row));
+        add_target(song_table_model_->song_at(selected_row + 1));
+    }
+    add_target(hovered_song_);
+    sheet_preloader_->set_targets(targets, settings_.overlay_chunking_mode);
+}
 
-        std::vector<std::string> current_line;
-        current_line.reserve(kOverlaySmartChunkMax);
-        std::size_t running_start = 0;
-
-        const auto flush_line = [&]() {
-            if (current_line.empty()) {
-                return;
-            }
-            overlay_line_starts_.push_back(running_start);
-            overlay_lines_.push_back(current_line);
-            running_start += current_line.size();
-            current_line.clear();
-        };
+void MainWindow::select_song(const Song& song) {
+    SHEETMASTER_TRACE_SCOPE("MainWindow::select_song");
+    stop_autoplay();
+    current_song_ = song;
 
-        for (const NoteGroup& group : current_sheet_) {
-            current_line.push_back(group.keys);
-            const bool sustain = has_sustain(group.keys);
+    // A speculative preload turns this into a move; otherwise the file is read once here.
+    std::optional<PreparedSheet> prepared = sheet_preloader_->take(song, settings_.overlay_chunking_mode);
+    if (!prepared.has_value()) {
+        prepared = prepare_sheet(repository_, song, settings_.overlay_chunking_mode, {}, song_arena_.resource());
+        song_arena_.reset();
+    }
+    rebuild_overlay_lines(song, prepared->sheet, std::move(prepared->overlay_layout));
 
-            if (current_line.size() >= kOverlaySmartChunkMax) {
-                flush_line();
-            } else if (current_line.size() >= kOverlaySmartChunkMin && !sustain) {
-                flush_line();
-            }
-        }
+    key_list_model_->set_sheet(nullptr);
+    session_.load(std::move(prepared->sheet));
+    key_list_model_->set_sheet(&session_.sheet());
+    update_playback_labels();
+    restart_trace_recording();
+}
 
-        flush_line();
-        if (overlay_lines_.empty()) {
-            build_fixed_chunks(kOverlayChunkSizeNoBreaks);
+void MainWindow::rebuild_overlay_lines(const Song& song, const CompiledSheet& sheet, OverlayLayout text_layout) {
+    SHEETMASTER_TRACE_SCOPE("MainWindow::rebuild_overlay_lines");
+    if (settings_.overlay_chunking_mode == OverlayChunkingMode::FitWidth && floating_overlay_ != nullptr) {
+        const OverlayRenderer& renderer = floating_overlay_->renderer();
+        OverlayLayoutKey key{
+            song.id,
+            sheet_fingerprint(sheet),
+            renderer.font_key().toStdString(),
+            static_cast<int>(renderer.line_width()),
+        };
+        if (const OverlayLayout* cached = overlay_layout_cache_.find(key); cached != nullptr) {
+            overlay_layout_ = *cached;
+            return;
         }
-    };
 
-    if (settings_.overlay_chunking_mode == OverlayChunkingMode::Smart) {
-        build_smart_chunks();
+        overlay_layout_ = layout_fit_width_lines(
+            sheet,
+            song.sustain_indicator,
+            renderer.measure_tokens(sheet.groups),
+            renderer.token_gap(),
+            renderer.line_width()
+        );
+        overlay_layout_cache_.insert(std::move(key), overlay_layout_);
         return;
     }
 
-    const std::string raw_text = repository_.load_raw_sheet_text(song);
-    const bool has_explicit_line_breaks = raw_text.find('\n') != std::string::npos ||
-                                          raw_text.find('\r') != std::string::npos;
-    std::istringstream input(raw_text);
-
-    std::size_t running_index = 0;
-    std::string line;
-    while (std::getline(input, line)) {
-        const std::vector<NoteGroup> parsed =
-            parse_sheet(line + " ", song.open_brace, song.close_brace, song.sustain_indicator);
-        if (parsed.empty()) {
-            continue;
-        }
+    overlay_layout_ = std::move(text_layout);
+}
 
-        overlay_line_starts_.push_back(running_index);
-        overlay_lines_.emplace_back();
-        std::vector<std::string>& keys = overlay_lines_.back();
-        keys.reserve(parsed.size());
-        for (const NoteGroup& group : parsed) {
-            keys.push_back(group.keys);
-        }
-        running_index += keys.size();
+void MainWindow::request_playback_view_update() {
+    const std::optional<std::chrono::nanoseconds> delay = frame_pacer_.mark_dirty(FramePacer::Clock::now());
+    if (delay.has_value()) {
+        frame_timer_.start(std::chrono::ceil<std::chrono::milliseconds>(*delay));
     }
+}
 
-    const bool mismatch = running_index != current_sheet_.size();
-    if (overlay_lines_.empty() || mismatch || !has_explicit_line_breaks) {
-        build_fixed_chunks(kOverlayChunkSizeNoBreaks);
+void MainWindow::flush_playback_view() {
+    if (frame_pacer_.begin_flush(FramePacer::Clock::now())) {
+        update_playback_labels();
     }
 }
 
@@ -469,26 +604,30 @@ void MainWindow::update_playback_labels() {
         return;
     }
 
-    const QString pause_suffix = paused_ ? " [PAUSED]" : "";
+    const bool paused = session_.paused();
+    const QString pause_suffix = paused ? " [PAUSED]" : "";
     current_song_label_->setText(
         QString("CURRENT SONG: %1%2")
             .arg(QString::fromStdString(current_song_->name))
             .arg(pause_suffix)
     );
 
-    const std::size_t total = current_sheet_.size();
-    const std::size_t display_current = total == 0 ? 0 : std::min(current_index_ + 1, total);
+    const std::size_t total = session_.sheet().size();
+    const std::size_t current_index = session_.cursor();
+    const std::size_t display_current = total == 0 ? 0 : std::min(current_index + 1, total);
     duration_label_->setText(
         QString("SONG DURATION: %1 / %2%3")
             .arg(to_qt_int(display_current))
             .arg(to_qt_int(total))
-            .arg(paused_ ? " (Enter to Resume)" : " (Enter to Pause)")
+            .arg(paused ? " (Enter to Resume)" : " (Enter to Pause)")
     );
 
     if (total > 0) {
-        const int row = to_qt_int(std::min(current_index_, total - 1));
-        key_list_->setCurrentRow(row);
-        key_list_->scrollToItem(key_list_->item(row), QAbstractItemView::PositionAtCenter);
+        const QModelIndex row = key_list_model_->index(to_qt_int(std::min(current_index, total - 1)));
+        if (row.isValid() && key_list_->currentIndex() != row) {
+            key_list_->setCurrentIndex(row);
+            key_list_->scrollTo(row, QAbstractItemView::PositionAtCenter);
+        }
     }
 
     update_floating_overlay();
@@ -499,19 +638,20 @@ void MainWindow::update_floating_overlay() {
         return;
     }
 
-    const std::string song_name = current_song_.has_value() ? current_song_->name : std::string{};
-    const std::size_t progress_current = current_sheet_.empty()
-                                             ? 0
-                                             : std::min(current_index_ + 1, current_sheet_.size());
-    const std::size_t progress_total = current_sheet_.size();
+    const CompiledSheet& sheet = session_.sheet();
+    const std::size_t current_index = session_.cursor();
+    const bool paused = session_.paused();
+    const std::string_view song_name = current_song_.has_value() ? std::string_view(current_song_->name) : std::string_view{};
+    const std::size_t progress_current = sheet.empty() ? 0 : std::min(current_index + 1, sheet.size());
+    const std::size_t progress_total = sheet.size();
 
-    if (current_sheet_.empty() || overlay_lines_.empty()) {
+    if (sheet.empty() || overlay_layout_.empty()) {
         floating_overlay_->set_song_progress(
             {},
             std::nullopt,
             {},
             false,
-            paused_,
+            paused,
             song_name,
             progress_current,
             progress_total
@@ -519,13 +659,13 @@ void MainWindow::update_floating_overlay() {
         return;
     }
 
-    if (current_index_ >= current_sheet_.size()) {
+    if (current_index >= sheet.size() || current_index >= overlay_layout_.line_of_note.size()) {
         floating_overlay_->set_song_progress(
             {},
             std::nullopt,
             {},
             true,
-            paused_,
+            paused,
             song_name,
             progress_total,
             progress_total
@@ -533,42 +673,52 @@ void MainWindow::update_floating_overlay() {
         return;
     }
 
-    std::size_t line_index = 0;
-    for (std::size_t i = 0; i < overlay_line_starts_.size(); ++i) {
-        const std::size_t start = overlay_line_starts_[i];
-        const std::size_t length = overlay_lines_[i].size();
-        const std::size_t end = start + length;
-        if (current_index_ >= start && current_index_ < end) {
-            line_index = i;
-            break;
-        }
+    const std::span<const NoteGroup> groups(sheet.groups);
+    const std::size_t line_index = overlay_layout_.line_of_note[current_index];
+    const OverlayLineRange line = overlay_layout_.lines[line_index];
+    const std::span<const NoteGroup> current_line = groups.subspan(line.begin, line.size());
+    std::span<const NoteGroup> next_line{};
+    if (line_index + 1 < overlay_layout_.lines.size()) {
+        const OverlayLineRange next = overlay_layout_.lines[line_index + 1];
+        next_line = groups.subspan(next.begin, next.size());
     }
 
-    const std::size_t line_start = overlay_line_starts_[line_index];
-    const std::size_t key_in_line = current_index_ - line_start;
-    const std::vector<std::string>& current_line = overlay_lines_[line_index];
-    static const std::vector<std::string> kEmptyLine;
-    const std::vector<std::string>& next_line =
-        (line_index + 1 < overlay_lines_.size()) ? overlay_lines_[line_index + 1] : kEmptyLine;
-
     floating_overlay_->set_song_progress(
         current_line,
-        key_in_line,
+        current_index - line.begin,
         next_line,
         false,
-        paused_,
+        paused,
         song_name,
         progress_current,
         progress_total
     );
 }
 
-std::optional<Song> MainWindow::selected_song_from_table() const {
-    const int row = song_table_->currentRow();
-    if (row < 0 || row >= static_cast<int>(visible_songs_.size())) {
-        return std::nullopt;
+void MainWindow::restart_trace_recording() {
+    finish_trace_recording();
+    if (settings_.record_input_traces && current_song_.has_value()) {
+        trace_recorder_.begin(current_song_->id);
     }
-    return visible_songs_[static_cast<std::size_t>(row)];
+}
+
+void MainWindow::finish_trace_recording() {
+    const std::optional<InputTrace> trace = trace_recorder_.finish();
+    if (!trace.has_value()) {
+        return;
+    }
+
+    const std::string stamp = QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss").toStdString();
+    const std::filesystem::path path =
+        std::filesystem::path(kTraceFolder) / (trace->song_id + "_" + stamp + std::string(kTraceExtension));
+    try {
+        write_input_trace(path, *trace);
+    } catch (const std::exception&) {
+    }
+}
+
+std::optional<Song> MainWindow::selected_song_from_table() const {
+    return song_table_model_->song_at(song_table_->currentIndex().row());
 }
 
 void MainWindow::handle_import_songs() {
@@ -659,7 +809,7 @@ void MainWindow::handle_import_songs() {
         );
         const std::vector<std::string> tags = parse_tags(tags_edit->text());
         tag_store_.set_tags_for_song(saved_song_id, tags);
-        refresh_song_list();
+        reload_song_list();
     } catch (const std::exception& exception) {
         QMessageBox::critical(this, "Import Songs", QString("Failed to import song:\n%1").arg(exception.what()));
     }
@@ -776,16 +926,16 @@ void MainWindow::handle_manage_songs() {
 
         repository_.delete_song(song);
         tag_store_.remove_song(song.id);
+        play_history_.remove_song(song.id);
+        sheet_preloader_->invalidate(song.id);
         if (current_song_.has_value() && current_song_->id == song.id) {
+            stop_autoplay();
             current_song_.reset();
-            current_sheet_.clear();
-            current_index_ = 0;
-            waiting_for_release_ = false;
-            paused_ = false;
-            pause_key_latched_ = false;
-            key_list_->clear();
+            key_list_model_->set_sheet(nullptr);
+            session_.clear();
+            finish_trace_recording();
         }
-        refresh_song_list();
+        reload_song_list();
         return;
     }
 
@@ -811,6 +961,7 @@ void MainWindow::handle_manage_songs() {
         song.name = final_name;
 
         repository_.update_song_contents(song, notes.toStdString());
+        sheet_preloader_->invalidate(song.id);
         const std::vector<std::string> tags = parse_tags(tags_edit->text());
         tag_store_.set_tags_for_song(song.id, tags);
 
@@ -818,7 +969,7 @@ void MainWindow::handle_manage_songs() {
             select_song(song);
         }
 
-        refresh_song_list();
+        reload_song_list();
     } catch (const std::exception& exception) {
         QMessageBox::critical(this, "Manage Songs", QString("Failed to save changes:\n%1").arg(exception.what()));
     }
@@ -830,20 +981,41 @@ void MainWindow::handle_settings() {
 
     auto* root = new QVBoxLayout(&dialog);
     auto* strict_checkbox = new QCheckBox("Strict Mode", &dialog);
+    auto* trace_checkbox = new QCheckBox("Record Practice Traces", &dialog);
     auto* poll_spin = new QSpinBox(&dialog);
+    auto* tempo_spin = new QSpinBox(&dialog);
+    auto* chord_window_spin = new QSpinBox(&dialog);
+    auto* resync_spin = new QSpinBox(&dialog);
     auto* chunking_combo = new QComboBox(&dialog);
     poll_spin->setRange(1, 100);
     poll_spin->setSuffix(" ms");
     poll_spin->setValue(settings_.input_poll_interval_ms);
+    tempo_spin->setRange(20, 1200);
+    tempo_spin->setSuffix(" steps/min");
+    tempo_spin->setValue(settings_.autoplay_tempo);
+    chord_window_spin->setRange(0, 250);
+    chord_window_spin->setSuffix(" ms");
+    chord_window_spin->setSpecialValueText("Off");
+    chord_window_spin->setValue(settings_.chord_window_ms);
+    resync_spin->setRange(0, 256);
+    resync_spin->setSuffix(" notes");
+    resync_spin->setSpecialValueText("Off");
+    resync_spin->setValue(settings_.resync_lookahead);
     chunking_combo->addItem("Auto Detect");
     chunking_combo->addItem("Smart");
+    chunking_combo->addItem("Fit Width");
     chunking_combo->setCurrentIndex(chunking_mode_to_combo_index(settings_.overlay_chunking_mode));
     strict_checkbox->setChecked(settings_.strict_mode);
+    trace_checkbox->setChecked(settings_.record_input_traces);
 
     auto* form = new QFormLayout();
     form->addRow("Playback Poll Interval:", poll_spin);
+    form->addRow("Chord Roll Window:", chord_window_spin);
+    form->addRow("Resync Lookahead:", resync_spin);
     form->addRow("Overlay Chunking:", chunking_combo);
+    form->addRow("Auto-Play Tempo:", tempo_spin);
     root->addWidget(strict_checkbox);
+    root->addWidget(trace_checkbox);
     root->addLayout(form);
 
     auto* buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, &dialog);
@@ -855,78 +1027,169 @@ void MainWindow::handle_settings() {
         return;
     }
 
+    const bool was_recording = settings_.record_input_traces;
     settings_.strict_mode = strict_checkbox->isChecked();
+    settings_.record_input_traces = trace_checkbox->isChecked();
     settings_.input_poll_interval_ms = poll_spin->value();
+    settings_.chord_window_ms = chord_window_spin->value();
+    settings_.resync_lookahead = resync_spin->value();
+    settings_.autoplay_tempo = tempo_spin->value();
     settings_.overlay_chunking_mode = chunking_mode_from_combo_index(chunking_combo->currentIndex());
     strict_mode_checkbox_->setChecked(settings_.strict_mode);
     input_poll_timer_.setInterval(settings_.input_poll_interval_ms);
+    session_.set_options(playback_options_from(settings_));
     settings_store_.save(settings_);
+    if (was_recording != settings_.record_input_traces) {
+        restart_trace_recording();
+    }
 
     if (current_song_.has_value()) {
-        rebuild_overlay_lines(*current_song_);
+        const std::string raw_text = settings_.overlay_chunking_mode == OverlayChunkingMode::AutoDetect
+                                         ? repository_.load_raw_sheet_text(*current_song_)
+                                         : std::string{};
+        rebuild_overlay_lines(
+            *current_song_,
+            session_.sheet(),
+            layout_for_chunking_mode(settings_.overlay_chunking_mode, *current_song_, session_.sheet(), raw_text)
+        );
     }
     update_playback_labels();
 }
 
+void MainWindow::handle_diagnostics() {
+    QDialog dialog(this);
+    dialog.setWindowTitle("Memory Diagnostics");
+
+    auto* root = new QVBoxLayout(&dialog);
+    auto* grid = new QGridLayout();
+    const QStringList headers{"Subsystem", "Live", "Peak", "Allocations"};
+    for (int column = 0; column < headers.size(); ++column) {
+        auto* header = new QLabel("<b>" + headers[column] + "</b>", &dialog);
+        grid->addWidget(header, 0, column, column == 0 ? Qt::AlignLeft : Qt::AlignRight);
+    }
+
+    std::vector<std::array<QLabel*, 3>> value_labels;
+    for (std::size_t index = 0; index < kMemorySubsystemCount; ++index) {
+        const int row = to_qt_int(index + 1);
+        const std::string_view name = memory_subsystem_name(static_cast<MemorySubsystem>(index));
+        grid->addWidget(new QLabel(QString::fromUtf8(name.data(), to_qt_int(name.size())), &dialog), row, 0);
+        std::array<QLabel*, 3> labels{};
+        for (std::size_t column = 0; column < labels.size(); ++column) {
+            labels[column] = new QLabel(&dialog);
+            grid->addWidget(labels[column], row, to_qt_int(column + 1), Qt::AlignRight);
+        }
+        value_labels.push_back(labels);
+    }
+    root->addLayout(grid);
+
+    const auto refresh = [&value_labels]() {
+        const auto usage = memory_usage_snapshot();
+        for (std::size_t index = 0; index < usage.size(); ++index) {
+            value_labels[index][0]->setText(format_bytes(usage[index].live_bytes));
+            value_labels[index][1]->setText(format_bytes(usage[index].peak_bytes));
+            value_labels[index][2]->setText(QString::number(usage[index].allocations));
+        }
+    };
+    refresh();
+
+    QTimer refresh_timer;
+    refresh_timer.setInterval(kDiagnosticsRefreshMs);
+    connect(&refresh_timer, &QTimer::timeout, &dialog, refresh);
+    refresh_timer.start();
+
+    auto* buttons = new QDialogButtonBox(QDialogButtonBox::Close, &dialog);
+    QPushButton* reset_button = buttons->addButton("Reset Peaks", QDialogButtonBox::ResetRole);
+    root->addWidget(buttons);
+    connect(reset_button, &QPushButton::clicked, &dialog, [&refresh]() {
+        reset_memory_peaks();
+        refresh();
+    });
+    connect(buttons, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+
+    dialog.exec();
+}
+
 void MainWindow::handle_strict_mode_toggle(const bool checked) {
     settings_.strict_mode = checked;
-    keyboard_.set_strict_mode(checked);
+    session_.set_options(playback_options_from(settings_));
     settings_store_.save(settings_);
 }
 
-void MainWindow::handle_overlay_toggle(const bool checked) {
-    if (floating_overlay_ == nullptr) {
+void MainWindow::ensure_floating_overlay() {
+    if (floating_overlay_ != nullptr) {
         return;
     }
 
+    const ScopedStartupPhase phase("overlay_creation");
+    floating_overlay_ = std::make_unique<FloatingOverlayWindow>();
+    floating_overlay_->setAttribute(Qt::WA_QuitOnClose, false);
+    if (current_song_.has_value() && settings_.overlay_chunking_mode == OverlayChunkingMode::FitWidth) {
+        // The song was laid out without overlay metrics; measure it now.
+        rebuild_overlay_lines(*current_song_, session_.sheet(), overlay_layout_);
+    }
+}
+
+void MainWindow::handle_overlay_toggle(const bool checked) {
     if (checked) {
+        ensure_floating_overlay();
         floating_overlay_->show();
         floating_overlay_->raise();
         update_floating_overlay();
-    } else {
+    } else if (floating_overlay_ != nullptr) {
         floating_overlay_->hide();
     }
 }
 
-void MainWindow::poll_input() {
-    const bool enter_down = (GetAsyncKeyState(VK_RETURN) & 0x8000) != 0;
-    if (enter_down && !pause_key_latched_) {
-        paused_ = !paused_;
-        pause_key_latched_ = true;
-        waiting_for_release_ = true;
-        update_playback_labels();
-    } else if (!enter_down) {
-        pause_key_latched_ = false;
-    }
-
-    if (!current_song_.has_value()) {
-        return;
-    }
-
-    if (current_sheet_.empty() || current_index_ >= current_sheet_.size()) {
+void MainWindow::handle_autoplay_toggle(const bool checked) {
+    if (!checked) {
+        stop_autoplay();
         return;
     }
 
-    if (paused_) {
+    if (!current_song_.has_value() || session_.paused() || session_.completed() || session_.sheet().empty()) {
+        stop_autoplay();
         return;
     }
 
-    if (waiting_for_release_) {
-        if (!KeyboardInput::is_any_monitored_key_down()) {
-            waiting_for_release_ = false;
+    // Deadlines are tracked on the scheduler thread; the GUI thread only applies the cursor.
+    const std::uint64_t generation = ++autoplay_generation_;
+    autoplay_scheduler_.start(
+        build_autoplay_timeline(session_.sheet(), current_song_->sustain_indicator, settings_.autoplay_tempo),
+        session_.cursor(),
+        [this, generation](const std::size_t index, const std::chrono::nanoseconds /*lateness*/) {
+            QMetaObject::invokeMethod(this, [this, generation, index]() {
+                if (generation != autoplay_generation_) {
+                    return;
+                }
+                session_.seek(index);
+                if (session_.completed()) {
+                    stop_autoplay();
+                }
+            }, Qt::QueuedConnection);
         }
-        return;
-    }
+    );
+}
 
-    const bool should_advance = settings_.strict_mode
-                                    ? keyboard_.check_chord(current_sheet_[current_index_].keys)
-                                    : KeyboardInput::is_any_monitored_key_down();
+void MainWindow::stop_autoplay() {
+    ++autoplay_generation_;
+    autoplay_scheduler_.stop();
+    if (autoplay_checkbox_ != nullptr && autoplay_checkbox_->isChecked()) {
+        const QSignalBlocker blocker(autoplay_checkbox_);
+        autoplay_checkbox_->setChecked(false);
+    }
+}
 
-    if (should_advance) {
-        ++current_index_;
-        waiting_for_release_ = true;
-        update_playback_labels();
+void MainWindow::poll_input() {
+    SHEETMASTER_TRACE_SCOPE("MainWindow::poll_input");
+    const InputSample sample{
+        monotonic_now(),
+        KeyboardInput::sample_key_mask(),
+        KeyboardInput::is_pause_key_down(),
+    };
+    if (trace_recorder_.active()) {
+        trace_recorder_.record(sample);
     }
+    session_.tick(sample);
 }
 
 } // namespace piano_assist
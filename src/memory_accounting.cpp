@@ -0,0 +1,91 @@
+#include "piano_assist/memory_accounting.hpp"
+
+#include <atomic>
+#include <sstream>
+
+namespace piano_assist {
+namespace {
+
+struct Counters {
+    std::atomic<std::size_t> live{0};
+    std::atomic<std::size_t> peak{0};
+    std::atomic<std::uint64_t> allocations{0};
+    std::atomic<std::uint64_t> deallocations{0};
+};
+
+constexpr std::array<std::string_view, kMemorySubsystemCount> kSubsystemNames = {
+    "catalog",
+    "compiled_sheet",
+    "overlay_layout",
+    "tags",
+};
+
+Counters& counters(const MemorySubsystem subsystem) {
+    static std::array<Counters, kMemorySubsystemCount> all;
+    return all[static_cast<std::size_t>(subsystem)];
+}
+
+void raise_peak(Counters& counter, const std::size_t live) {
+    std::size_t peak = counter.peak.load(std::memory_order_relaxed);
+    while (live > peak && !counter.peak.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+    }
+}
+
+} // namespace
+
+std::string_view memory_subsystem_name(const MemorySubsystem subsystem) {
+    return kSubsystemNames[static_cast<std::size_t>(subsystem)];
+}
+
+void record_allocation(const MemorySubsystem subsystem, const std::size_t bytes, const std::size_t blocks) {
+    Counters& counter = counters(subsystem);
+    counter.allocations.fetch_add(blocks, std::memory_order_relaxed);
+    raise_peak(counter, counter.live.fetch_add(bytes, std::memory_order_relaxed) + bytes);
+}
+
+void record_deallocation(const MemorySubsystem subsystem, const std::size_t bytes, const std::size_t blocks) {
+    Counters& counter = counters(subsystem);
+    counter.deallocations.fetch_add(blocks, std::memory_order_relaxed);
+    counter.live.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+MemoryUsage memory_usage(const MemorySubsystem subsystem) {
+    const Counters& counter = counters(subsystem);
+    return MemoryUsage{
+        subsystem,
+        counter.live.load(std::memory_order_relaxed),
+        counter.peak.load(std::memory_order_relaxed),
+        counter.allocations.load(std::memory_order_relaxed),
+        counter.deallocations.load(std::memory_order_relaxed),
+    };
+}
+
+std::array<MemoryUsage, kMemorySubsystemCount> memory_usage_snapshot() {
+    std::array<MemoryUsage, kMemorySubsystemCount> usage{};
+    for (std::size_t index = 0; index < kMemorySubsystemCount; ++index) {
+        usage[index] = memory_usage(static_cast<MemorySubsystem>(index));
+    }
+    return usage;
+}
+
+void reset_memory_peaks() {
+    for (std::size_t index = 0; index < kMemorySubsystemCount; ++index) {
+        Counters& counter = counters(static_cast<MemorySubsystem>(index));
+        counter.peak.store(counter.live.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+}
+
+std::string memory_usage_json() {
+    std::ostringstream out;
+    out << '{';
+    for (const MemoryUsage& usage : memory_usage_snapshot()) {
+        out << (usage.subsystem == MemorySubsystem::Catalog ? "" : ", ") << '"'
+            << memory_subsystem_name(usage.subsystem) << "\": {\"live_bytes\": " << usage.live_bytes
+            << ", \"peak_bytes\": " << usage.peak_bytes << ", \"allocations\": " << usage.allocations
+            << ", \"deallocations\": " << usage.deallocations << '}';
+    }
+    out << '}';
+    return out.str();
+}
+
+} // namespace piano_assist
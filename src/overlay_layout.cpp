@@ -0,0 +1,213 @@
+#include "piano_assist/overlay_layout.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <string>
+
+#include "piano_assist/song_parser.hpp"
+
+namespace piano_assist {
+namespace {
+
+// Accept up to this fraction of the width as extra slack to end a line on a held note.
+constexpr double kNonSustainBreakPenaltyFraction = 0.15;
+constexpr std::uint64_t kFnvOffsetBasis = 14695981039346656037ULL;
+constexpr std::uint64_t kFnvPrime = 1099511628211ULL;
+
+bool is_sustained(const std::string& keys, const char sustain_indicator) {
+    return keys.find(sustain_indicator) != std::string::npos ||
+           keys.find('-') != std::string::npos ||
+           keys.find('|') != std::string::npos;
+}
+
+} // namespace
+
+OverlayLayout layout_from_line_lengths(const std::span<const std::size_t> lengths) {
+    OverlayLayout layout{};
+    layout.lines.reserve(lengths.size());
+    layout.line_of_note.reserve(std::accumulate(lengths.begin(), lengths.end(), std::size_t{0}));
+
+    std::size_t begin = 0;
+    for (const std::size_t length : lengths) {
+        if (length == 0) {
+            continue;
+        }
+        const auto line_index = static_cast<std::uint32_t>(layout.lines.size());
+        layout.lines.push_back(OverlayLineRange{begin, begin + length});
+        layout.line_of_note.insert(layout.line_of_note.end(), length, line_index);
+        begin += length;
+    }
+    return layout;
+}
+
+OverlayLayout layout_fixed_lines(const std::size_t note_count, const std::size_t chunk_size) {
+    const std::size_t size = std::max<std::size_t>(chunk_size, 1);
+    std::vector<std::size_t> lengths;
+    lengths.reserve(note_count / size + 1);
+    for (std::size_t begin = 0; begin < note_count; begin += size) {
+        lengths.push_back(std::min(size, note_count - begin));
+    }
+    return layout_from_line_lengths(lengths);
+}
+
+OverlayLayout layout_smart_lines(const CompiledSheet& sheet, const char sustain_indicator) {
+    std::vector<std::size_t> lengths;
+    std::size_t current = 0;
+    for (const NoteGroup& group : sheet.groups) {
+        ++current;
+        if (current >= kOverlaySmartChunkMax || (current >= kOverlaySmartChunkMin && !is_sustained(group.keys, sustain_indicator))) {
+            lengths.push_back(current);
+            current = 0;
+        }
+    }
+    if (current > 0) {
+        lengths.push_back(current);
+    }
+    return layout_from_line_lengths(lengths);
+}
+
+OverlayLayout layout_fit_width_lines(
+    const CompiledSheet& sheet,
+    const char sustain_indicator,
+    const std::span<const double> token_widths,
+    const double gap,
+    const double max_width
+) {
+    const std::size_t count = std::min(sheet.size(), token_widths.size());
+    const double penalty = (kNonSustainBreakPenaltyFraction * max_width) * (kNonSustainBreakPenaltyFraction * max_width);
+    constexpr double kUnreachable = std::numeric_limits<double>::infinity();
+
+    // best[end] is the cheapest way to lay out notes [0, end); from[end] is where its last line starts.
+    std::vector<double> best(count + 1, kUnreachable);
+    std::vector<std::size_t> from(count + 1, 0);
+    best[0] = 0.0;
+    for (std::size_t end = 1; end <= count; ++end) {
+        const bool last_line = end == count;
+        const bool sustained_break = is_sustained(sheet.groups[end - 1].keys, sustain_indicator);
+        double width = 0.0;
+        for (std::size_t begin = end; begin-- > 0;) {
+            width += token_widths[begin] + (begin + 1 < end ? gap : 0.0);
+            if (width > max_width && begin + 1 < end) {
+                break;
+            }
+            if (best[begin] == kUnreachable) {
+                continue;
+            }
+
+            double cost = 0.0;
+            if (!last_line) {
+                const double slack = std::max(max_width - width, 0.0);
+                cost = slack * slack + (sustained_break ? 0.0 : penalty);
+            }
+            if (best[begin] + cost < best[end]) {
+                best[end] = best[begin] + cost;
+                from[end] = begin;
+            }
+        }
+    }
+
+    std::vector<std::size_t> lengths;
+    for (std::size_t end = count; end > 0; end = from[end]) {
+        lengths.push_back(end - from[end]);
+    }
+    std::reverse(lengths.begin(), lengths.end());
+    return layout_from_line_lengths(lengths);
+}
+
+std::optional<OverlayLayout> layout_source_lines(
+    const std::string_view raw_text,
+    const char open_brace,
+    const char close_brace,
+    const char sustain_indicator,
+    const std::size_t note_count,
+    std::pmr::memory_resource* scratch
+) {
+    if (raw_text.find('\n') == std::string_view::npos && raw_text.find('\r') == std::string_view::npos) {
+        return std::nullopt;
+    }
+
+    std::pmr::vector<std::size_t> lengths(scratch);
+    std::size_t total = 0;
+    for (std::size_t begin = 0; begin < raw_text.size();) {
+        const std::size_t newline = std::min(raw_text.find('\n', begin), raw_text.size());
+        const std::size_t length =
+            count_note_groups(raw_text.substr(begin, newline - begin), open_brace, close_brace, sustain_indicator);
+        begin = newline + 1;
+        if (length == 0) {
+            continue;
+        }
+        lengths.push_back(length);
+        total += length;
+    }
+
+    if (lengths.empty() || total != note_count) {
+        return std::nullopt;
+    }
+    return layout_from_line_lengths(lengths);
+}
+
+OverlayLayout layout_for_chunking_mode(
+    const OverlayChunkingMode mode,
+    const Song& song,
+    const CompiledSheet& sheet,
+    const std::string_view raw_text,
+    std::pmr::memory_resource* scratch
+) {
+    if (mode != OverlayChunkingMode::AutoDetect) {
+        return layout_smart_lines(sheet, song.sustain_indicator);
+    }
+
+    std::optional<OverlayLayout> layout = layout_source_lines(
+        raw_text,
+        song.open_brace,
+        song.close_brace,
+        song.sustain_indicator,
+        sheet.size(),
+        scratch
+    );
+    return layout.has_value() ? std::move(*layout) : layout_fixed_lines(sheet.size(), kOverlayChunkSizeNoBreaks);
+}
+
+std::uint64_t sheet_fingerprint(const CompiledSheet& sheet) {
+    std::uint64_t hash = kFnvOffsetBasis;
+    for (const NoteGroup& group : sheet.groups) {
+        for (const char value : group.keys) {
+            hash = (hash ^ static_cast<unsigned char>(value)) * kFnvPrime;
+        }
+        hash = (hash ^ 0xFFU) * kFnvPrime;
+    }
+    return hash;
+}
+
+OverlayLayoutCache::OverlayLayoutCache(const std::size_t capacity) : capacity_(std::max<std::size_t>(capacity, 1)) {}
+
+const OverlayLayout* OverlayLayoutCache::find(const OverlayLayoutKey& key) {
+    const auto it = std::find_if(entries_.begin(), entries_.end(), [&key](const auto& entry) {
+        return entry.first == key;
+    });
+    if (it == entries_.end()) {
+        return nullptr;
+    }
+    std::rotate(entries_.begin(), it, it + 1);
+    return &entries_.front().second;
+}
+
+void OverlayLayoutCache::insert(OverlayLayoutKey key, OverlayLayout layout) {
+    const auto it = std::find_if(entries_.begin(), entries_.end(), [&key](const auto& entry) {
+        return entry.first == key;
+    });
+    if (it != entries_.end()) {
+        entries_.erase(it);
+    }
+    if (entries_.size() >= capacity_) {
+        entries_.pop_back();
+    }
+    entries_.insert(entries_.begin(), {std::move(key), std::move(layout)});
+}
+
+std::size_t OverlayLayoutCache::size() const {
+    return entries_.size();
+}
+
+} // namespace piano_assist
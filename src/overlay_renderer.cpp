@@ -0,0 +1,387 @@
+#include "piano_assist/overlay_renderer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include <QFontMetricsF>
+#include <QImage>
+#include <QPainter>
+#include <QPen>
+#include <QPointF>
+#include <QTransform>
+
+#include "piano_assist/trace.hpp"
+
+namespace piano_assist {
+namespace {
+
+constexpr qreal kPanelRadius = 12.0;
+constexpr qreal kPanelMarginX = 14.0;
+constexpr qreal kPanelMarginY = 10.0;
+constexpr qreal kInfoHeight = 22.0;
+constexpr qreal kInfoPaddingX = 10.0;
+constexpr qreal kLineSpacing = 4.0;
+constexpr qreal kOutlineMargin = 2.0;
+
+const QColor kPanelFill(16, 16, 16, 215);
+const QColor kPanelBorder(255, 255, 255, 72);
+const QColor kInfoFill(0, 0, 0, 110);
+const QColor kInfoColor(0xFD, 0xFD, 0xFD);
+const QColor kCurrentColor(0xEA, 0xEA, 0xEA);
+const QColor kHighlightColor(0xFF, 0xD5, 0x4A);
+const QColor kNextColor(0x8B, 0x8B, 0x8B);
+const QColor kEmptyColor(0x6A, 0x6A, 0x6A);
+const QColor kCompletedNextColor(0x80, 0x80, 0x80);
+const QColor kOutlineColor(0, 0, 0, 220);
+
+QFont make_font(const int pixel_size, const QFont::Weight weight, const bool monospace) {
+    QFont font;
+    if (monospace) {
+        font.setFamilies({"Consolas", "Courier New"});
+        font.setStyleHint(QFont::Monospace);
+    }
+    font.setPixelSize(pixel_size);
+    font.setWeight(weight);
+    return font;
+}
+
+CachedText make_cached_text(const QString& value, const QFont& font, const qreal device_pixel_ratio) {
+    CachedText cached{};
+    cached.font = font;
+    cached.text = QStaticText(value);
+    cached.text.setTextFormat(Qt::PlainText);
+    cached.text.setPerformanceHint(QStaticText::AggressiveCaching);
+    cached.text.prepare(QTransform(), font);
+    cached.size = cached.text.size();
+
+    const QSizeF padded = cached.size + QSizeF(2.0 * kOutlineMargin, 2.0 * kOutlineMargin);
+    QImage image(
+        static_cast<int>(std::ceil(padded.width() * device_pixel_ratio)),
+        static_cast<int>(std::ceil(padded.height() * device_pixel_ratio)),
+        QImage::Format_ARGB32_Premultiplied
+    );
+    image.setDevicePixelRatio(device_pixel_ratio);
+    image.fill(Qt::transparent);
+
+    // Eight offset copies approximate the old 3px drop-shadow outline without a blur pass.
+    constexpr std::array<std::pair<qreal, qreal>, 8> kOffsets{{
+        {-1.0, -1.0}, {0.0, -1.0}, {1.0, -1.0}, {-1.0, 0.0},
+        {1.0, 0.0}, {-1.0, 1.0}, {0.0, 1.0}, {1.0, 1.0},
+    }};
+    QPainter painter(&image);
+    painter.setFont(font);
+    painter.setPen(kOutlineColor);
+    for (const auto& [dx, dy] : kOffsets) {
+        painter.drawStaticText(QPointF(kOutlineMargin + dx, kOutlineMargin + dy), cached.text);
+    }
+    painter.end();
+
+    cached.outline = QPixmap::fromImage(std::move(image));
+    return cached;
+}
+
+void draw_cached_text(QPainter& painter, const CachedText& cached, const QPointF& origin, const QColor& color) {
+    painter.drawPixmap(origin - QPointF(kOutlineMargin, kOutlineMargin), cached.outline);
+    painter.setFont(cached.font);
+    painter.setPen(color);
+    painter.drawStaticText(origin, cached.text);
+}
+
+bool same_keys(const std::span<const NoteGroup> groups, const std::vector<std::string>& keys) {
+    return std::equal(groups.begin(), groups.end(), keys.begin(), keys.end(), [](const NoteGroup& group, const std::string& key) {
+        return group.keys == key;
+    });
+}
+
+void assign_keys(const std::span<const NoteGroup> groups, std::vector<std::string>& keys) {
+    keys.clear();
+    keys.reserve(groups.size());
+    for (const NoteGroup& group : groups) {
+        keys.push_back(group.keys);
+    }
+}
+
+QRegion to_region(const QRectF& rect) {
+    return rect.isEmpty() ? QRegion() : QRegion(rect.toAlignedRect());
+}
+
+} // namespace
+
+OverlayRenderer::OverlayRenderer(const QSize size)
+    : size_(size),
+      info_font_(make_font(12, QFont::Bold, false)),
+      line_font_(make_font(20, QFont::Medium, true)),
+      highlight_font_(make_font(20, QFont::Bold, true)),
+      completed_font_(make_font(24, QFont::Bold, true)),
+      placeholder_font_(make_font(18, QFont::Medium, true)) {
+    rebuild_panel();
+    rebuild_info();
+    rebuild_lines();
+}
+
+QSize OverlayRenderer::size() const {
+    return size_;
+}
+
+bool OverlayRenderer::set_device_pixel_ratio(const qreal ratio) {
+    if (qFuzzyCompare(ratio, device_pixel_ratio_) || ratio <= 0.0) {
+        return false;
+    }
+
+    device_pixel_ratio_ = ratio;
+    rebuild_panel();
+    rebuild_info();
+    rebuild_lines();
+    return true;
+}
+
+QRegion OverlayRenderer::set_info(const QString& text) {
+    if (text == info_) {
+        return {};
+    }
+
+    const QRectF previous = info_bounds_;
+    info_ = text;
+    rebuild_info();
+    return to_region(previous) | to_region(info_bounds_);
+}
+
+QRegion OverlayRenderer::set_lines(
+    const std::span<const NoteGroup> current_line,
+    const std::span<const NoteGroup> next_line,
+    const bool completed
+) {
+    // Advancing within a line compares a few short strings and allocates nothing.
+    if (completed == completed_ && same_keys(current_line, current_keys_) && same_keys(next_line, next_keys_)) {
+        return {};
+    }
+
+    assign_keys(current_line, current_keys_);
+    assign_keys(next_line, next_keys_);
+    completed_ = completed;
+    rebuild_lines();
+    return to_region(current_line_rect()) | to_region(next_line_rect());
+}
+
+QRegion OverlayRenderer::set_highlight(const std::optional<std::size_t> key_index) {
+    if (key_index == highlight_) {
+        return {};
+    }
+
+    const QRegion previous = to_region(token_bounds(highlight_));
+    highlight_ = key_index;
+    return previous | to_region(token_bounds(highlight_));
+}
+
+void OverlayRenderer::paint(QPainter& painter, const QRegion& exposed) const {
+    SHEETMASTER_TRACE_SCOPE("OverlayRenderer::paint");
+    painter.save();
+    painter.setClipRegion(exposed);
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+    painter.drawPixmap(0, 0, panel_);
+    painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+
+    if (exposed.intersects(info_bounds_.toAlignedRect())) {
+        painter.setRenderHint(QPainter::Antialiasing, true);
+        painter.setPen(Qt::NoPen);
+        painter.setBrush(kInfoFill);
+        painter.drawRoundedRect(info_bounds_, 6.0, 6.0);
+        draw_cached_text(
+            painter,
+            info_text_,
+            QPointF(info_bounds_.left() + kInfoPaddingX, info_bounds_.center().y() - info_text_.size.height() / 2.0),
+            kInfoColor
+        );
+    }
+
+    const bool current_is_placeholder = completed_ || current_keys_.empty();
+    for (std::size_t index = 0; index < current_tokens_.size(); ++index) {
+        const TokenSlot& slot = current_tokens_[index];
+        if (!exposed.intersects(slot.bounds.toAlignedRect())) {
+            continue;
+        }
+
+        const bool highlighted = !current_is_placeholder && highlight_.has_value() && *highlight_ == index;
+        const CachedText& text = highlighted ? slot.highlighted : slot.normal;
+        const QColor color = completed_ ? kHighlightColor
+                             : current_keys_.empty() ? kEmptyColor
+                             : highlighted ? kHighlightColor
+                                           : kCurrentColor;
+        const QPointF origin(
+            slot.bounds.center().x() - text.size.width() / 2.0,
+            slot.bounds.center().y() - text.size.height() / 2.0
+        );
+        draw_cached_text(painter, text, origin, color);
+    }
+
+    for (const TokenSlot& slot : next_tokens_) {
+        if (!exposed.intersects(slot.bounds.toAlignedRect())) {
+            continue;
+        }
+
+        const QColor color = completed_ ? kCompletedNextColor : next_keys_.empty() ? kEmptyColor : kNextColor;
+        const QPointF origin(
+            slot.bounds.center().x() - slot.normal.size.width() / 2.0,
+            slot.bounds.center().y() - slot.normal.size.height() / 2.0
+        );
+        draw_cached_text(painter, slot.normal, origin, color);
+    }
+
+    painter.restore();
+}
+
+std::vector<double> OverlayRenderer::measure_tokens(const std::span<const NoteGroup> groups) const {
+    const QFontMetricsF normal(line_font_);
+    const QFontMetricsF highlighted(highlight_font_);
+    std::unordered_map<std::string, double> measured;
+
+    std::vector<double> widths;
+    widths.reserve(groups.size());
+    for (const NoteGroup& group : groups) {
+        auto [it, inserted] = measured.try_emplace(group.keys, 0.0);
+        if (inserted) {
+            const QString token = QString::fromStdString(group.keys);
+            it->second = std::max(normal.horizontalAdvance(token), highlighted.horizontalAdvance(token));
+        }
+        widths.push_back(it->second);
+    }
+    return widths;
+}
+
+double OverlayRenderer::token_gap() const {
+    return QFontMetricsF(line_font_).horizontalAdvance(QStringLiteral("   "));
+}
+
+double OverlayRenderer::line_width() const {
+    return current_line_rect().width() - 2.0 * kOutlineMargin;
+}
+
+QString OverlayRenderer::font_key() const {
+    return line_font_.key() + QLatin1Char('/') + highlight_font_.key();
+}
+
+QRectF OverlayRenderer::current_line_rect() const {
+    const qreal top = kPanelMarginY + kInfoHeight + kLineSpacing;
+    const qreal height = (size_.height() - top - kPanelMarginY - kLineSpacing) / 2.0;
+    return QRectF(kPanelMarginX, top, size_.width() - 2.0 * kPanelMarginX, height);
+}
+
+QRectF OverlayRenderer::next_line_rect() const {
+    const QRectF current = current_line_rect();
+    return current.translated(0.0, current.height() + kLineSpacing);
+}
+
+QRectF OverlayRenderer::token_bounds(const std::optional<std::size_t> key_index) const {
+    if (!key_index.has_value() || *key_index >= current_tokens_.size()) {
+        return {};
+    }
+    return current_tokens_[*key_index].bounds;
+}
+
+void OverlayRenderer::rebuild_panel() {
+    SHEETMASTER_TRACE_SCOPE("OverlayRenderer::rebuild_panel");
+    QImage image(
+        static_cast<int>(std::ceil(size_.width() * device_pixel_ratio_)),
+        static_cast<int>(std::ceil(size_.height() * device_pixel_ratio_)),
+        QImage::Format_ARGB32_Premultiplied
+    );
+    image.setDevicePixelRatio(device_pixel_ratio_);
+    image.fill(Qt::transparent);
+
+    QPainter painter(&image);
+    painter.setRenderHint(QPainter::Antialiasing, true);
+    painter.setPen(QPen(kPanelBorder, 1.0));
+    painter.setBrush(kPanelFill);
+    painter.drawRoundedRect(QRectF(0.5, 0.5, size_.width() - 1.0, size_.height() - 1.0), kPanelRadius, kPanelRadius);
+    painter.end();
+
+    panel_ = QPixmap::fromImage(std::move(image));
+}
+
+void OverlayRenderer::rebuild_info() {
+    info_text_ = make_cached_text(info_, info_font_, device_pixel_ratio_);
+    const qreal width = info_text_.size.width() + 2.0 * kInfoPaddingX;
+    info_bounds_ = QRectF((size_.width() - width) / 2.0, kPanelMarginY, width, kInfoHeight);
+}
+
+void OverlayRenderer::rebuild_lines() {
+    SHEETMASTER_TRACE_SCOPE("OverlayRenderer::rebuild_lines");
+    std::vector<QString> current;
+    std::vector<QString> next;
+    if (completed_) {
+        current.push_back("completed!");
+        next.push_back("-");
+        current_tokens_ = layout_line(current, completed_font_, nullptr, current_line_rect());
+        next_tokens_ = layout_line(next, placeholder_font_, nullptr, next_line_rect());
+        return;
+    }
+
+    current.reserve(current_keys_.size());
+    for (const std::string& key : current_keys_) {
+        current.push_back(QString::fromStdString(key));
+    }
+    next.reserve(next_keys_.size());
+    for (const std::string& key : next_keys_) {
+        next.push_back(QString::fromStdString(key));
+    }
+    if (current.empty()) {
+        current.push_back("-");
+    }
+    if (next.empty()) {
+        next.push_back("-");
+    }
+
+    current_tokens_ = layout_line(current, line_font_, current_keys_.empty() ? nullptr : &highlight_font_, current_line_rect());
+    next_tokens_ = layout_line(next, line_font_, nullptr, next_line_rect());
+}
+
+std::vector<OverlayRenderer::TokenSlot> OverlayRenderer::layout_line(
+    const std::vector<QString>& tokens,
+    const QFont& font,
+    const QFont* highlight_font,
+    const QRectF& area
+) const {
+    std::vector<TokenSlot> slots;
+    slots.reserve(tokens.size());
+
+    // Slots are sized for the wider (bold) variant so highlighting never shifts the line.
+    const QFontMetricsF metrics(font);
+    const std::optional<QFontMetricsF> highlight_metrics =
+        highlight_font != nullptr ? std::optional<QFontMetricsF>(QFontMetricsF(*highlight_font)) : std::nullopt;
+    qreal total_width = 0.0;
+    for (const QString& token : tokens) {
+        TokenSlot slot{};
+        slot.normal = make_cached_text(token, font, device_pixel_ratio_);
+        qreal width = metrics.horizontalAdvance(token);
+        qreal height = slot.normal.size.height();
+        if (highlight_font != nullptr) {
+            slot.highlighted = make_cached_text(token, *highlight_font, device_pixel_ratio_);
+            width = std::max(width, highlight_metrics->horizontalAdvance(token));
+            height = std::max(height, slot.highlighted.size.height());
+        }
+        slot.bounds = QRectF(0.0, 0.0, width, height);
+        total_width += width;
+        slots.push_back(std::move(slot));
+    }
+
+    const qreal gap = metrics.horizontalAdvance(QStringLiteral("   "));
+    if (!slots.empty()) {
+        total_width += gap * static_cast<qreal>(slots.size() - 1);
+    }
+
+    qreal x = area.center().x() - total_width / 2.0;
+    for (TokenSlot& slot : slots) {
+        const qreal width = slot.bounds.width();
+        const qreal height = slot.bounds.height();
+        slot.bounds = QRectF(x, area.center().y() - height / 2.0, width, height)
+                          .adjusted(-kOutlineMargin, -kOutlineMargin, kOutlineMargin, kOutlineMargin);
+        x += width + gap;
+    }
+    return slots;
+}
+
+} // namespace piano_assist
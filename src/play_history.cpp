@@ -0,0 +1,113 @@
+#include "piano_assist/play_history.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <fstream>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "piano_assist/trace.hpp"
+
+namespace piano_assist {
+namespace {
+
+std::mutex& storage_mutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+std::atomic<std::uint64_t>& write_revision() {
+    static std::atomic<std::uint64_t> revision{0};
+    return revision;
+}
+
+PlayTimes load_map(const std::filesystem::path& storage_file) {
+    PlayTimes result;
+    std::ifstream in(storage_file);
+    if (!in) {
+        return result;
+    }
+
+    std::string line;
+    while (std::getline(in, line)) {
+        const std::size_t delimiter = line.find('\t');
+        if (delimiter == 0 || delimiter == std::string::npos) {
+            continue;
+        }
+        std::int64_t played_at = 0;
+        const char* first = line.data() + delimiter + 1;
+        const char* last = line.data() + line.size();
+        if (std::from_chars(first, last, played_at).ec == std::errc{}) {
+            result[line.substr(0, delimiter)] = played_at;
+        }
+    }
+    return result;
+}
+
+void save_map(const std::filesystem::path& storage_file, const PlayTimes& map) {
+    std::error_code error;
+    if (storage_file.has_parent_path()) {
+        std::filesystem::create_directories(storage_file.parent_path(), error);
+    }
+
+    std::ofstream out(storage_file, std::ios::trunc);
+    if (!out) {
+        return;
+    }
+
+    std::vector<const PlayTimes::value_type*> entries;
+    entries.reserve(map.size());
+    for (const auto& entry : map) {
+        entries.push_back(&entry);
+    }
+    std::sort(entries.begin(), entries.end(), [](const auto* lhs, const auto* rhs) {
+        return lhs->first < rhs->first;
+    });
+    for (const auto* entry : entries) {
+        out << entry->first << '\t' << entry->second << '\n';
+    }
+    write_revision().fetch_add(1, std::memory_order_release);
+}
+
+bool is_valid_id(const std::string_view song_id) {
+    return !song_id.empty() && song_id.find_first_of("\t\r\n") == std::string_view::npos;
+}
+
+} // namespace
+
+PlayHistory::PlayHistory(std::filesystem::path storage_file) : storage_file_(std::move(storage_file)) {}
+
+void PlayHistory::record_play(const std::string_view song_id, const std::int64_t played_at) const {
+    SHEETMASTER_TRACE_SCOPE("PlayHistory::record_play");
+    if (!is_valid_id(song_id)) {
+        return;
+    }
+
+    const std::lock_guard lock(storage_mutex());
+    PlayTimes map = load_map(storage_file_);
+    map[std::string(song_id)] = played_at;
+    save_map(storage_file_, map);
+}
+
+void PlayHistory::remove_song(const std::string_view song_id) const {
+    SHEETMASTER_TRACE_SCOPE("PlayHistory::remove_song");
+    const std::lock_guard lock(storage_mutex());
+    PlayTimes map = load_map(storage_file_);
+    if (map.erase(std::string(song_id)) != 0) {
+        save_map(storage_file_, map);
+    }
+}
+
+PlayTimes PlayHistory::load_all() const {
+    SHEETMASTER_TRACE_SCOPE("PlayHistory::load_all");
+    const std::lock_guard lock(storage_mutex());
+    return load_map(storage_file_);
+}
+
+std::uint64_t PlayHistory::revision() {
+    return write_revision().load(std::memory_order_acquire);
+}
+
+} // namespace piano_assist
@@ -0,0 +1,159 @@
+#include "piano_assist/playback_session.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <utility>
+
+namespace piano_assist {
+
+PlaybackSession::PlaybackSession(const PlaybackOptions& options)
+    : options_(options),
+      chord_matcher_(options.chord_window),
+      resync_matcher_(options.resync_lookahead) {}
+
+void PlaybackSession::set_options(const PlaybackOptions& options) {
+    options_ = options;
+    chord_matcher_.set_window(options_.chord_window);
+    resync_matcher_.set_lookahead(options_.resync_lookahead);
+    resync_matcher_.seek(cursor_);
+}
+
+void PlaybackSession::subscribe(Listener listener) {
+    listeners_.push_back(std::move(listener));
+}
+
+void PlaybackSession::load(CompiledSheet sheet) {
+    sheet_ = std::move(sheet);
+    loaded_ = true;
+    cursor_ = 0;
+    paused_ = false;
+    pause_key_latched_ = false;
+    reset_input_state();
+    resync_matcher_.load(&sheet_);
+    emit(CursorEvent{CursorEventKind::Loaded, 0, 0, paused_});
+}
+
+void PlaybackSession::clear() {
+    sheet_ = {};
+    loaded_ = false;
+    cursor_ = 0;
+    paused_ = false;
+    pause_key_latched_ = false;
+    reset_input_state();
+    resync_matcher_.load(&sheet_);
+    emit(CursorEvent{CursorEventKind::Cleared, 0, 0, paused_});
+}
+
+void PlaybackSession::seek(const std::size_t index) {
+    reset_input_state();
+    move_cursor(CursorEventKind::Seeked, std::min(index, sheet_.size()));
+}
+
+void PlaybackSession::tick(const InputSample& sample) {
+    if (sample.pause_key_down && !pause_key_latched_) {
+        paused_ = !paused_;
+        pause_key_latched_ = true;
+        waiting_for_release_ = true;
+        emit(CursorEvent{CursorEventKind::PauseChanged, cursor_, cursor_, paused_});
+    } else if (!sample.pause_key_down) {
+        pause_key_latched_ = false;
+    }
+
+    if (!loaded_ || cursor_ >= sheet_.size() || paused_) {
+        return;
+    }
+
+    if (waiting_for_release_) {
+        if (sample.keys_down == 0) {
+            reset_input_state();
+        }
+        return;
+    }
+
+    const bool should_advance = options_.strict_mode ? match_strict(sample) : sample.keys_down != 0;
+    if (should_advance) {
+        move_cursor(CursorEventKind::Advanced, cursor_ + 1);
+        waiting_for_release_ = true;
+    }
+}
+
+bool PlaybackSession::match_strict(const InputSample& sample) {
+    const KeyMask required = sheet_.masks[cursor_];
+    if (chord_matcher_.target() != required) {
+        chord_matcher_.reset(required);
+    }
+
+    // Rolled chords are accepted as soon as their last key goes down inside the window;
+    // a chord held down in full is still accepted from the snapshot alone. Either way no
+    // foreign key may be down in the accepting sample.
+    bool matched = false;
+    const KeyMask down = sample.keys_down;
+    for_each_key_edge(previous_key_mask_, down, [&](const std::uint8_t slot, const bool is_down) {
+        matched = chord_matcher_.feed(KeyEvent{sample.timestamp, slot, is_down}) || matched;
+    });
+    previous_key_mask_ = down;
+    if (required != 0 && (matched || down == required) && (down & ~required) == 0) {
+        return true;
+    }
+
+    // A chord that never matched the cursor is offered to the lookahead once it is released.
+    attempt_mask_ |= down;
+    if (down != 0 || attempt_mask_ == 0) {
+        return false;
+    }
+
+    const KeyMask played = std::exchange(attempt_mask_, 0);
+    if (const std::optional<ResyncJump> jump = resync_matcher_.observe(played)) {
+        for (std::size_t index = jump->skipped_begin; index < jump->skipped_end; ++index) {
+            sheet_.groups[index].was_correct = false;
+        }
+        move_cursor(CursorEventKind::Resynced, jump->resume_at);
+    }
+    return false;
+}
+
+void PlaybackSession::move_cursor(const CursorEventKind kind, const std::size_t index) {
+    const std::size_t previous = cursor_;
+    cursor_ = index;
+    resync_matcher_.seek(cursor_);
+    emit(CursorEvent{kind, previous, cursor_, paused_});
+}
+
+void PlaybackSession::reset_input_state() {
+    waiting_for_release_ = false;
+    previous_key_mask_ = 0;
+    attempt_mask_ = 0;
+}
+
+void PlaybackSession::emit(const CursorEvent& event) const {
+    for (const Listener& listener : listeners_) {
+        listener(event);
+    }
+}
+
+const CompiledSheet& PlaybackSession::sheet() const {
+    return sheet_;
+}
+
+const PlaybackOptions& PlaybackSession::options() const {
+    return options_;
+}
+
+std::size_t PlaybackSession::cursor() const {
+    return cursor_;
+}
+
+bool PlaybackSession::loaded() const {
+    return loaded_;
+}
+
+bool PlaybackSession::paused() const {
+    return paused_;
+}
+
+bool PlaybackSession::completed() const {
+    return loaded_ && cursor_ >= sheet_.size();
+}
+
+} // namespace piano_assist
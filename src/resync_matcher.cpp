@@ -0,0 +1,130 @@
+#include "piano_assist/resync_matcher.hpp"
+
+#include <algorithm>
+
+namespace piano_assist {
+
+ResyncMatcher::ResyncMatcher(const std::size_t lookahead, const std::size_t confirmations)
+    : lookahead_(lookahead), confirmations_(std::max<std::size_t>(confirmations, 1)) {}
+
+void ResyncMatcher::load(const CompiledSheet* sheet) {
+    sheet_ = sheet;
+    cursor_ = 0;
+    rebuild_window();
+}
+
+void ResyncMatcher::set_lookahead(const std::size_t lookahead) {
+    lookahead_ = lookahead;
+    rebuild_window();
+}
+
+void ResyncMatcher::seek(const std::size_t cursor) {
+    candidate_start_.reset();
+    if (sheet_ == nullptr) {
+        cursor_ = cursor;
+        return;
+    }
+
+    if (cursor < cursor_ || cursor - cursor_ > lookahead_) {
+        cursor_ = cursor;
+        rebuild_window();
+        return;
+    }
+
+    const std::size_t size = sheet_->masks.size();
+    const std::size_t old_end = window_end_;
+    const std::size_t new_begin = std::min(cursor + 1, size);
+    const std::size_t new_end = std::min(new_begin + lookahead_, size);
+    for (std::size_t index = std::min(cursor_ + 1, size); index < std::min(new_begin, old_end); ++index) {
+        pop_front_position(index);
+    }
+    for (std::size_t index = std::max(old_end, new_begin); index < new_end; ++index) {
+        push_back_position(index);
+    }
+    cursor_ = cursor;
+    window_end_ = new_end;
+}
+
+std::optional<ResyncJump> ResyncMatcher::observe(const KeyMask played) {
+    if (sheet_ == nullptr || lookahead_ == 0 || played == 0) {
+        return std::nullopt;
+    }
+
+    const auto& masks = sheet_->masks;
+    if (cursor_ < masks.size() && masks[cursor_] == played) {
+        candidate_start_.reset();
+        return std::nullopt;
+    }
+
+    if (candidate_start_.has_value()) {
+        if (candidate_next_ < masks.size() && masks[candidate_next_] == played) {
+            ++candidate_next_;
+            if (candidate_next_ - *candidate_start_ >= confirmations_) {
+                const ResyncJump jump{cursor_, *candidate_start_, candidate_next_};
+                candidate_start_.reset();
+                return jump;
+            }
+            return std::nullopt;
+        }
+        candidate_start_.reset();
+    }
+
+    const auto it = first_in_window_.find(played);
+    if (it == first_in_window_.end()) {
+        return std::nullopt;
+    }
+
+    candidate_start_ = it->second;
+    candidate_next_ = it->second + 1;
+    if (confirmations_ <= 1) {
+        const ResyncJump jump{cursor_, *candidate_start_, candidate_next_};
+        candidate_start_.reset();
+        return jump;
+    }
+    return std::nullopt;
+}
+
+bool ResyncMatcher::has_candidate() const {
+    return candidate_start_.has_value();
+}
+
+void ResyncMatcher::rebuild_window() {
+    first_in_window_.clear();
+    candidate_start_.reset();
+    window_end_ = 0;
+    if (sheet_ == nullptr) {
+        return;
+    }
+
+    const std::size_t size = sheet_->masks.size();
+    const std::size_t begin = std::min(cursor_ + 1, size);
+    window_end_ = std::min(begin + lookahead_, size);
+    first_in_window_.reserve(window_end_ - begin);
+    for (std::size_t index = begin; index < window_end_; ++index) {
+        push_back_position(index);
+    }
+}
+
+void ResyncMatcher::push_back_position(const std::size_t index) {
+    const KeyMask mask = sheet_->masks[index];
+    if (mask != 0) {
+        first_in_window_.try_emplace(mask, index);
+    }
+}
+
+void ResyncMatcher::pop_front_position(const std::size_t index) {
+    const KeyMask mask = sheet_->masks[index];
+    const auto it = first_in_window_.find(mask);
+    if (mask == 0 || it == first_in_window_.end() || it->second != index) {
+        return;
+    }
+
+    const std::size_t next = sheet_->next_same_mask[index];
+    if (next != kNoNextOccurrence && next < window_end_) {
+        it->second = next;
+    } else {
+        first_in_window_.erase(it);
+    }
+}
+
+} // namespace piano_assist
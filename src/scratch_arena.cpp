@@ -0,0 +1,11 @@
+#include "piano_assist/scratch_arena.hpp"
+
+#include <algorithm>
+
+namespace piano_assist {
+
+ScratchArena::ScratchArena(const std::size_t initial_bytes)
+    : initial_block_(std::make_unique_for_overwrite<std::byte[]>(std::max<std::size_t>(initial_bytes, 1))),
+      arena_(initial_block_.get(), std::max<std::size_t>(initial_bytes, 1)) {}
+
+} // namespace piano_assist
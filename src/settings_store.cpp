@@ -7,6 +7,9 @@
 #include <sstream>
 #include <utility>
 
+#include "piano_assist/startup_profiler.hpp"
+#include "piano_assist/trace.hpp"
+
 namespace piano_assist {
 namespace {
 
@@ -28,11 +31,22 @@ OverlayChunkingMode parse_chunking_mode(const std::string_view value) {
     if (normalized == "smart" || normalized == "Smart") {
         return OverlayChunkingMode::Smart;
     }
+    if (normalized == "fit_width") {
+        return OverlayChunkingMode::FitWidth;
+    }
     return OverlayChunkingMode::AutoDetect;
 }
 
 std::string chunking_mode_to_string(const OverlayChunkingMode mode) {
-    return mode == OverlayChunkingMode::Smart ? "smart" : "auto_detect";
+    switch (mode) {
+        case OverlayChunkingMode::Smart:
+            return "smart";
+        case OverlayChunkingMode::FitWidth:
+            return "fit_width";
+        case OverlayChunkingMode::AutoDetect:
+            break;
+    }
+    return "auto_detect";
 }
 
 std::filesystem::path legacy_settings_path_for(const std::filesystem::path& modern_path) {
@@ -44,6 +58,7 @@ std::filesystem::path legacy_settings_path_for(const std::filesystem::path& mode
 } // namespace
 
 SettingsStore::SettingsStore(std::filesystem::path settings_file) : settings_file_(std::move(settings_file)) {
+    const ScopedStartupPhase phase("settings_store_open");
     std::error_code error;
     if (settings_file_.has_parent_path()) {
         std::filesystem::create_directories(settings_file_.parent_path(), error);
@@ -70,6 +85,8 @@ SettingsStore::SettingsStore(std::filesystem::path settings_file) : settings_fil
 }
 
 AppSettings SettingsStore::load() const {
+    SHEETMASTER_TRACE_SCOPE("SettingsStore::load");
+    const ScopedStartupPhase phase("settings_load");
     AppSettings settings{};
     std::ifstream in(settings_file_);
     if (!in) {
@@ -110,6 +127,30 @@ AppSettings SettingsStore::load() const {
                     settings.input_poll_interval_ms = std::clamp(parsed, 1, 100);
                 } catch (const std::exception&) {
                 }
+            } else if (key == "chord_window_ms") {
+                try {
+                    const int parsed = std::stoi(value);
+                    settings.chord_window_ms = std::clamp(parsed, 0, 250);
+                } catch (const std::exception&) {
+                }
+            } else if (key == "resync_lookahead") {
+                try {
+                    const int parsed = std::stoi(value);
+                    settings.resync_lookahead = std::clamp(parsed, 0, 256);
+                } catch (const std::exception&) {
+                }
+            } else if (key == "autoplay_tempo") {
+                try {
+                    const int parsed = std::stoi(value);
+                    settings.autoplay_tempo = std::clamp(parsed, 20, 1200);
+                } catch (const std::exception&) {
+                }
+            } else if (key == "record_input_traces") {
+                if (value == "true" || value == "1") {
+                    settings.record_input_traces = true;
+                } else if (value == "false" || value == "0") {
+                    settings.record_input_traces = false;
+                }
             } else if (key == "overlay_chunking_mode") {
                 settings.overlay_chunking_mode = parse_chunking_mode(value);
             }
@@ -134,6 +175,7 @@ AppSettings SettingsStore::load() const {
 }
 
 void SettingsStore::save(const AppSettings& settings) const {
+    SHEETMASTER_TRACE_SCOPE("SettingsStore::save");
     std::error_code error;
     if (settings_file_.has_parent_path()) {
         std::filesystem::create_directories(settings_file_.parent_path(), error);
@@ -147,6 +189,10 @@ void SettingsStore::save(const AppSettings& settings) const {
     out << std::boolalpha;
     out << "strict_mode=" << settings.strict_mode << '\n';
     out << "input_poll_interval_ms=" << std::clamp(settings.input_poll_interval_ms, 1, 100) << '\n';
+    out << "chord_window_ms=" << std::clamp(settings.chord_window_ms, 0, 250) << '\n';
+    out << "resync_lookahead=" << std::clamp(settings.resync_lookahead, 0, 256) << '\n';
+    out << "autoplay_tempo=" << std::clamp(settings.autoplay_tempo, 20, 1200) << '\n';
+    out << "record_input_traces=" << settings.record_input_traces << '\n';
     out << "overlay_chunking_mode=" << chunking_mode_to_string(settings.overlay_chunking_mode) << '\n';
 
     const std::filesystem::path legacy_path = legacy_settings_path_for(settings_file_);
@@ -0,0 +1,238 @@
+#include "piano_assist/sheet_preloader.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <utility>
+
+#include "piano_assist/scratch_arena.hpp"
+#include "piano_assist/song_parser.hpp"
+#include "piano_assist/trace.hpp"
+
+namespace piano_assist {
+
+std::optional<PreparedSheet> prepare_sheet(
+    const SongRepository& repository,
+    const Song& song,
+    const OverlayChunkingMode chunking_mode,
+    const std::function<bool()>& should_stop,
+    std::pmr::memory_resource* scratch
+) {
+    SHEETMASTER_TRACE_SCOPE("prepare_sheet");
+    const auto stopped = [&should_stop]() {
+        return should_stop && should_stop();
+    };
+
+    // The text and the parse are only scaffolding for the compiled sheet and its layout.
+    const std::pmr::string raw_text = repository.load_raw_sheet_text(song, scratch);
+    if (stopped()) {
+        return std::nullopt;
+    }
+
+    PreparedSheet prepared{};
+    prepared.song = song;
+    prepared.chunking_mode = chunking_mode;
+    std::pmr::vector<NoteGroup> groups =
+        parse_sheet(raw_text, song.open_brace, song.close_brace, song.sustain_indicator, scratch);
+    prepared.sheet = compile_sheet(groups, scratch);
+    if (stopped()) {
+        return std::nullopt;
+    }
+
+    prepared.overlay_layout = layout_for_chunking_mode(chunking_mode, song, prepared.sheet, raw_text, scratch);
+    return prepared;
+}
+
+SheetPreloader::SheetPreloader(SongRepository repository, const std::size_t worker_count, const std::size_t capacity)
+    : repository_(std::move(repository)), capacity_(std::max<std::size_t>(capacity, 1)) {
+    const std::size_t count = std::max<std::size_t>(worker_count, 1);
+    workers_.reserve(count);
+    for (std::size_t index = 0; index < count; ++index) {
+        workers_.emplace_back([this](const std::stop_token stop) {
+            run(stop);
+        });
+    }
+}
+
+SheetPreloader::~SheetPreloader() {
+    stop();
+}
+
+void SheetPreloader::set_targets(const std::vector<Song>& songs, const OverlayChunkingMode chunking_mode) {
+    {
+        const std::lock_guard lock(mutex_);
+        for (auto it = entries_.begin(); it != entries_.end();) {
+            const std::shared_ptr<Entry>& entry = it->second;
+            const bool wanted = std::any_of(songs.begin(), songs.end(), [&entry, chunking_mode](const Song& song) {
+                return song.id == entry->song.id && song.file_name == entry->song.file_name &&
+                       chunking_mode == entry->chunking_mode;
+            });
+            if (wanted || entry->state == EntryState::Ready) {
+                ++it;
+                continue;
+            }
+            cancel_locked(entry);
+            it = entries_.erase(it);
+        }
+
+        for (const Song& song : songs) {
+            const auto existing = entries_.find(song.id);
+            if (existing != entries_.end()) {
+                if (existing->second->chunking_mode == chunking_mode && existing->second->song.file_name == song.file_name) {
+                    existing->second->last_used = ++use_counter_;
+                    continue;
+                }
+                cancel_locked(existing->second);
+                entries_.erase(existing);
+            }
+
+            auto entry = std::make_shared<Entry>();
+            entry->song = song;
+            entry->chunking_mode = chunking_mode;
+            entry->last_used = ++use_counter_;
+            entries_.emplace(song.id, entry);
+            queue_.push_back(std::move(entry));
+        }
+    }
+    work_available_.notify_all();
+}
+
+std::optional<PreparedSheet> SheetPreloader::take(const Song& song, const OverlayChunkingMode chunking_mode) {
+    std::unique_lock lock(mutex_);
+    const auto it = entries_.find(song.id);
+    if (it == entries_.end() || it->second->chunking_mode != chunking_mode || it->second->song.file_name != song.file_name) {
+        return std::nullopt;
+    }
+
+    const std::shared_ptr<Entry> entry = it->second;
+    if (entry->state == EntryState::Queued) {
+        // Not started yet; the caller is about to load it anyway.
+        cancel_locked(entry);
+        entries_.erase(it);
+        return std::nullopt;
+    }
+
+    work_finished_.wait(lock, [&entry]() {
+        return entry->state != EntryState::Running || entry->cancelled.load();
+    });
+    if (entry->state != EntryState::Ready || !entry->result.has_value()) {
+        return std::nullopt;
+    }
+
+    std::optional<PreparedSheet> result = std::move(entry->result);
+    if (const auto current = entries_.find(song.id); current != entries_.end() && current->second == entry) {
+        entries_.erase(current);
+    }
+    return result;
+}
+
+void SheetPreloader::invalidate(const std::string_view song_id) {
+    const std::lock_guard lock(mutex_);
+    const auto it = entries_.find(std::string(song_id));
+    if (it == entries_.end()) {
+        return;
+    }
+    cancel_locked(it->second);
+    entries_.erase(it);
+}
+
+void SheetPreloader::stop() {
+    {
+        const std::lock_guard lock(mutex_);
+        for (const auto& entry : entries_) {
+            cancel_locked(entry.second);
+        }
+        entries_.clear();
+        queue_.clear();
+    }
+    for (std::jthread& worker : workers_) {
+        worker.request_stop();
+    }
+    work_available_.notify_all();
+    work_finished_.notify_all();
+    workers_.clear();
+}
+
+std::size_t SheetPreloader::cached_count() const {
+    const std::lock_guard lock(mutex_);
+    return static_cast<std::size_t>(std::count_if(entries_.begin(), entries_.end(), [](const auto& entry) {
+        return entry.second->state == EntryState::Ready;
+    }));
+}
+
+void SheetPreloader::run(const std::stop_token stop) {
+    tracer().set_thread_name("sheet_preloader");
+    ScratchArena arena;
+    while (!stop.stop_requested()) {
+        std::shared_ptr<Entry> entry;
+        {
+            std::unique_lock lock(mutex_);
+            if (!work_available_.wait(lock, stop, [this]() {
+                    return !queue_.empty();
+                })) {
+                return;
+            }
+            entry = std::move(queue_.front());
+            queue_.pop_front();
+            if (entry->cancelled.load() || entry->state != EntryState::Queued) {
+                continue;
+            }
+            entry->state = EntryState::Running;
+        }
+
+        std::optional<PreparedSheet> prepared;
+        try {
+            prepared = prepare_sheet(
+                repository_,
+                entry->song,
+                entry->chunking_mode,
+                [&entry, &stop]() {
+                    return entry->cancelled.load() || stop.stop_requested();
+                },
+                arena.resource()
+            );
+        } catch (const std::exception&) {
+        }
+        arena.reset();
+
+        {
+            const std::lock_guard lock(mutex_);
+            if (prepared.has_value() && !entry->cancelled.load()) {
+                entry->result = std::move(prepared);
+                entry->state = EntryState::Ready;
+                evict_locked();
+            } else {
+                entry->cancelled.store(true);
+                if (const auto it = entries_.find(entry->song.id); it != entries_.end() && it->second == entry) {
+                    entries_.erase(it);
+                }
+            }
+        }
+        work_finished_.notify_all();
+    }
+}
+
+void SheetPreloader::cancel_locked(const std::shared_ptr<Entry>& entry) {
+    entry->cancelled.store(true);
+}
+
+void SheetPreloader::evict_locked() {
+    while (true) {
+        std::size_t ready = 0;
+        auto oldest = entries_.end();
+        for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+            if (it->second->state != EntryState::Ready) {
+                continue;
+            }
+            ++ready;
+            if (oldest == entries_.end() || it->second->last_used < oldest->second->last_used) {
+                oldest = it;
+            }
+        }
+        if (ready <= capacity_ || oldest == entries_.end()) {
+            return;
+        }
+        entries_.erase(oldest);
+    }
+}
+
+} // namespace piano_assist
@@ -0,0 +1,313 @@
+#include "piano_assist/song_catalog.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <functional>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+
+namespace piano_assist {
+namespace {
+
+constexpr std::string_view kSongDataExtension = ".PADATA";
+constexpr std::size_t kMinInternedSlots = 16;
+// A 32-bit length takes at most five 7-bit groups.
+constexpr std::size_t kMaxLengthBytes = 5;
+
+bool has_capitals(const std::string_view value) {
+    return std::any_of(value.begin(), value.end(), [](const unsigned char c) {
+        return std::isupper(c) != 0;
+    });
+}
+
+bool is_data_file_of(const std::string_view file_name, const std::string_view stem) {
+    return file_name.size() == stem.size() + kSongDataExtension.size() && file_name.starts_with(stem) &&
+           file_name.ends_with(kSongDataExtension);
+}
+
+using FileNameParts = std::pair<std::string_view, std::string_view>;
+
+bool same_text(const FileNameParts& lhs, const FileNameParts& rhs) {
+    if (lhs.first.size() + lhs.second.size() != rhs.first.size() + rhs.second.size()) {
+        return false;
+    }
+    const auto char_at = [](const FileNameParts& parts, const std::size_t index) {
+        return index < parts.first.size() ? parts.first[index] : parts.second[index - parts.first.size()];
+    };
+    for (std::size_t index = 0; index < lhs.first.size() + lhs.second.size(); ++index) {
+        if (char_at(lhs, index) != char_at(rhs, index)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+StringHandle StringPool::add(const std::string_view value) {
+    if (characters_.size() + kMaxLengthBytes + value.size() >= kNoString) {
+        throw std::length_error("String pool is full.");
+    }
+    const StringHandle handle = static_cast<StringHandle>(characters_.size());
+    std::size_t length = value.size();
+    do {
+        const auto low_bits = static_cast<unsigned char>(length & 0x7FU);
+        length >>= 7U;
+        characters_.push_back(static_cast<char>(length == 0 ? low_bits : low_bits | 0x80U));
+    } while (length != 0);
+    characters_.insert(characters_.end(), value.begin(), value.end());
+    ++count_;
+    return handle;
+}
+
+StringHandle StringPool::add_lowercase(const std::string_view value) {
+    const StringHandle handle = add(value);
+    const auto first = characters_.end() - static_cast<std::ptrdiff_t>(value.size());
+    std::transform(first, characters_.end(), first, [](const unsigned char c) {
+        return static_cast<char>(std::tolower(c));
+    });
+    return handle;
+}
+
+StringHandle StringPool::intern(const std::string_view value) {
+    if ((interned_count_ + 1) * 2 > interned_.size()) {
+        grow_interned();
+    }
+    StringHandle& slot = interned_[slot_of(value)];
+    if (slot == kNoString) {
+        slot = add(value);
+        ++interned_count_;
+    }
+    return slot;
+}
+
+StringHandle StringPool::find(const std::string_view value) const {
+    return interned_.empty() ? kNoString : interned_[slot_of(value)];
+}
+
+std::string_view StringPool::view(const StringHandle handle) const {
+    const char* data = characters_.data() + handle;
+    std::size_t length = 0;
+    for (unsigned shift = 0;; shift += 7) {
+        const auto byte = static_cast<unsigned char>(*data++);
+        length |= static_cast<std::size_t>(byte & 0x7FU) << shift;
+        if ((byte & 0x80U) == 0) {
+            break;
+        }
+    }
+    return std::string_view(data, length);
+}
+
+std::size_t StringPool::memory_bytes() const {
+    return characters_.capacity() + interned_.capacity() * sizeof(StringHandle);
+}
+
+void StringPool::shrink_to_fit() {
+    characters_.shrink_to_fit();
+}
+
+std::size_t StringPool::slot_of(const std::string_view value) const {
+    const std::size_t mask = interned_.size() - 1;
+    for (std::size_t slot = std::hash<std::string_view>{}(value) & mask;; slot = (slot + 1) & mask) {
+        if (interned_[slot] == kNoString || view(interned_[slot]) == value) {
+            return slot;
+        }
+    }
+}
+
+void StringPool::grow_interned() {
+    AccountedVector<MemorySubsystem::Catalog, StringHandle> previous(
+        std::max(kMinInternedSlots, interned_.size() * 2),
+        kNoString
+    );
+    previous.swap(interned_);
+    for (const StringHandle handle : previous) {
+        if (handle != kNoString) {
+            interned_[slot_of(view(handle))] = handle;
+        }
+    }
+}
+
+SongCatalog::Index SongCatalog::add(
+    const std::string_view id,
+    const std::string_view name,
+    const std::string_view file_name,
+    const char open_brace,
+    const char close_brace,
+    const char sustain_indicator,
+    const std::uint32_t sheet_bytes
+) {
+    if (records_.size() >= std::numeric_limits<Index>::max()) {
+        throw std::length_error("Song catalog is full.");
+    }
+
+    CatalogRecord record{};
+    record.id = strings_.add(id);
+    record.name = strings_.add(name);
+    record.collation_key = has_capitals(name) ? strings_.add_lowercase(name) : record.name;
+
+    record.config = static_cast<std::uint8_t>((open_brace == '(' && close_brace == ')' ? kRoundGrouping : 0U) |
+                                              (sustain_indicator == '|' ? kPipeSustain : 0U));
+    if (is_data_file_of(file_name, id)) {
+        record.config |= kFileNamedById;
+    } else if (is_data_file_of(file_name, name)) {
+        record.config |= kFileNamedByName;
+    } else {
+        record.file_name = strings_.add(file_name);
+    }
+    record.first_tag = static_cast<std::uint32_t>(tags_.size());
+
+    records_.push_back(record);
+    sheet_bytes_.push_back(sheet_bytes);
+    return static_cast<Index>(records_.size() - 1);
+}
+
+SongCatalog::Index SongCatalog::add(const Song& song) {
+    return add(song.id, song.name, song.file_name, song.open_brace, song.close_brace, song.sustain_indicator);
+}
+
+void SongCatalog::set_tags(const Index index, const std::span<const std::string> tags) {
+    CatalogRecord& record = records_[index];
+    record.first_tag = static_cast<std::uint32_t>(tags_.size());
+    record.tag_count = static_cast<std::uint16_t>(std::min<std::size_t>(tags.size(), std::numeric_limits<std::uint16_t>::max()));
+    for (std::size_t position = 0; position < record.tag_count; ++position) {
+        tags_.push_back(strings_.intern(tags[position]));
+    }
+}
+
+std::string_view SongCatalog::id(const Index index) const {
+    return strings_.view(records_[index].id);
+}
+
+std::string_view SongCatalog::name(const Index index) const {
+    return strings_.view(records_[index].name);
+}
+
+std::string_view SongCatalog::collation_key(const Index index) const {
+    return strings_.view(records_[index].collation_key);
+}
+
+std::string SongCatalog::file_name(const Index index) const {
+    const FileNameParts parts = file_name_parts(index);
+    std::string file_name;
+    file_name.reserve(parts.first.size() + parts.second.size());
+    file_name.append(parts.first).append(parts.second);
+    return file_name;
+}
+
+char SongCatalog::open_brace(const Index index) const {
+    return (records_[index].config & kRoundGrouping) != 0 ? '(' : '[';
+}
+
+char SongCatalog::close_brace(const Index index) const {
+    return (records_[index].config & kRoundGrouping) != 0 ? ')' : ']';
+}
+
+char SongCatalog::sustain_indicator(const Index index) const {
+    return (records_[index].config & kPipeSustain) != 0 ? '|' : '-';
+}
+
+std::size_t SongCatalog::tag_count(const Index index) const {
+    return records_[index].tag_count;
+}
+
+std::string_view SongCatalog::tag(const Index index, const std::size_t position) const {
+    return strings_.view(tags_[records_[index].first_tag + position]);
+}
+
+bool SongCatalog::has_tag(const Index index, const std::string_view tag) const {
+    const StringHandle handle = find_tag(tag);
+    if (handle == kNoString) {
+        return false;
+    }
+    const std::span<const StringHandle> handles = tag_handles(index);
+    return std::find(handles.begin(), handles.end(), handle) != handles.end();
+}
+
+std::span<const StringHandle> SongCatalog::tag_handles(const Index index) const {
+    const CatalogRecord& record = records_[index];
+    return std::span<const StringHandle>(tags_).subspan(record.first_tag, record.tag_count);
+}
+
+StringHandle SongCatalog::find_tag(const std::string_view tag) const {
+    return strings_.find(tag);
+}
+
+std::uint32_t SongCatalog::sheet_bytes(const Index index) const {
+    return sheet_bytes_[index];
+}
+
+Song SongCatalog::song(const Index index) const {
+    Song song{};
+    song.id = std::string(id(index));
+    song.name = std::string(name(index));
+    song.file_name = file_name(index);
+    song.open_brace = open_brace(index);
+    song.close_brace = close_brace(index);
+    song.sustain_indicator = sustain_indicator(index);
+    return song;
+}
+
+bool SongCatalog::same_contents(const Index index, const SongCatalog& other, const Index other_index) const {
+    const CatalogRecord& record = records_[index];
+    const CatalogRecord& other_record = other.records_[other_index];
+    if ((record.config & (kRoundGrouping | kPipeSustain)) != (other_record.config & (kRoundGrouping | kPipeSustain)) || record.tag_count != other_record.tag_count ||
+        name(index) != other.name(other_index)) {
+        return false;
+    }
+
+    if (!same_text(file_name_parts(index), other.file_name_parts(other_index))) {
+        return false;
+    }
+
+    for (std::size_t position = 0; position < record.tag_count; ++position) {
+        if (tag(index, position) != other.tag(other_index, position)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void SongCatalog::sort(CatalogRows& rows) const {
+    std::sort(rows.begin(), rows.end(), [this](const Index lhs, const Index rhs) {
+        const std::string_view left = collation_key(lhs);
+        const std::string_view right = collation_key(rhs);
+        if (left == right) {
+            return id(lhs) < id(rhs);
+        }
+        return left < right;
+    });
+}
+
+CatalogRows SongCatalog::sorted_rows() const {
+    CatalogRows rows(records_.size());
+    std::iota(rows.begin(), rows.end(), Index{0});
+    sort(rows);
+    return rows;
+}
+
+void SongCatalog::shrink_to_fit() {
+    strings_.shrink_to_fit();
+    records_.shrink_to_fit();
+    tags_.shrink_to_fit();
+    sheet_bytes_.shrink_to_fit();
+}
+
+SongCatalog::FileNameParts SongCatalog::file_name_parts(const Index index) const {
+    const CatalogRecord& record = records_[index];
+    if ((record.config & kFileNamedById) != 0) {
+        return {strings_.view(record.id), kSongDataExtension};
+    }
+    if ((record.config & kFileNamedByName) != 0) {
+        return {strings_.view(record.name), kSongDataExtension};
+    }
+    return {strings_.view(record.file_name), {}};
+}
+
+std::size_t SongCatalog::memory_bytes() const {
+    return strings_.memory_bytes() + records_.capacity() * sizeof(CatalogRecord) +
+           tags_.capacity() * sizeof(StringHandle) + sheet_bytes_.capacity() * sizeof(std::uint32_t);
+}
+
+} // namespace piano_assist
@@ -0,0 +1,71 @@
+#include "piano_assist/song_list_diff.hpp"
+
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+namespace piano_assist {
+namespace {
+
+void append_index(std::vector<RowRange>& ranges, const std::size_t index) {
+    if (!ranges.empty() && ranges.back().first + ranges.back().count == index) {
+        ++ranges.back().count;
+        return;
+    }
+    ranges.push_back(RowRange{index, 1});
+}
+
+} // namespace
+
+SongListDiff diff_song_lists(const SongListView& before, const SongListView& after) {
+    SongListDiff diff{};
+
+    std::unordered_map<std::string_view, std::size_t> after_index;
+    after_index.reserve(after.size());
+    for (std::size_t index = 0; index < after.size(); ++index) {
+        after_index.emplace(after.catalog->id(after.rows[index]), index);
+    }
+
+    // Surviving rows must keep their relative order; the catalog is sorted, so only a rename moves a row.
+    std::vector<bool> survives(after.size(), false);
+    std::size_t last_position = 0;
+    bool first_survivor = true;
+    for (std::size_t index = before.size(); index-- > 0;) {
+        const auto it = after_index.find(before.catalog->id(before.rows[index]));
+        if (it == after_index.end()) {
+            if (diff.removed.empty() || diff.removed.back().first != index + 1) {
+                diff.removed.push_back(RowRange{index, 1});
+            } else {
+                --diff.removed.back().first;
+                ++diff.removed.back().count;
+            }
+            continue;
+        }
+
+        if (!first_survivor && it->second >= last_position) {
+            return SongListDiff{true, {}, {}, {}};
+        }
+        first_survivor = false;
+        last_position = it->second;
+        survives[it->second] = true;
+        if (!before.catalog->same_contents(before.rows[index], *after.catalog, after.rows[it->second])) {
+            diff.changed.push_back(RowRange{it->second, 1});
+        }
+    }
+
+    for (std::size_t index = 0; index < after.size(); ++index) {
+        if (!survives[index]) {
+            append_index(diff.inserted, index);
+        }
+    }
+
+    // Changes were collected back to front; merge them into ascending ranges.
+    std::vector<RowRange> changed;
+    for (auto it = diff.changed.rbegin(); it != diff.changed.rend(); ++it) {
+        append_index(changed, it->first);
+    }
+    diff.changed = std::move(changed);
+    return diff;
+}
+
+} // namespace piano_assist
@@ -1,16 +1,39 @@
 #include "piano_assist/song_parser.hpp"
 
 #include <cctype>
+#include <string>
+#include <utility>
+
+#include "piano_assist/trace.hpp"
 
 namespace piano_assist {
+namespace {
 
-std::vector<NoteGroup> parse_sheet(
-    const std::string& raw,
+// Stands in for a group vector where only the number of groups matters.
+struct GroupCounter {
+    std::size_t count{0};
+    NoteGroup last{};
+
+    void push_back(NoteGroup group) {
+        ++count;
+        last = std::move(group);
+    }
+    [[nodiscard]] bool empty() const {
+        return count == 0;
+    }
+    NoteGroup& back() {
+        return last;
+    }
+};
+
+template <typename Groups>
+void parse_into(
+    Groups& sheet,
+    const std::string_view raw,
     const char open_brace,
     const char close_brace,
     const char sustain_indicator
 ) {
-    std::vector<NoteGroup> sheet;
     std::string current_keys;
     bool in_brackets = false;
 
@@ -50,10 +73,11 @@ std::vector<NoteGroup> parse_sheet(
 
         const bool is_sustain = (ch == sustain_indicator) || (ch == '-') || (ch == '|');
         if (is_sustain) {
-            if (!sheet.empty()) {
-                sheet.back().keys.push_back(ch);
-            } else if (!current_keys.empty()) {
+            // A marker holds the note it follows, which is still pending unless it was bracketed.
+            if (!current_keys.empty()) {
                 current_keys.push_back(ch);
+            } else if (!sheet.empty()) {
+                sheet.back().keys.push_back(ch);
             }
             continue;
         }
@@ -63,7 +87,44 @@ std::vector<NoteGroup> parse_sheet(
     }
 
     flush_current();
+}
+
+} // namespace
+
+std::vector<NoteGroup> parse_sheet(
+    const std::string_view raw,
+    const char open_brace,
+    const char close_brace,
+    const char sustain_indicator
+) {
+    SHEETMASTER_TRACE_SCOPE("parse_sheet");
+    std::vector<NoteGroup> sheet;
+    parse_into(sheet, raw, open_brace, close_brace, sustain_indicator);
     return sheet;
 }
 
+std::pmr::vector<NoteGroup> parse_sheet(
+    const std::string_view raw,
+    const char open_brace,
+    const char close_brace,
+    const char sustain_indicator,
+    std::pmr::memory_resource* scratch
+) {
+    SHEETMASTER_TRACE_SCOPE("parse_sheet");
+    std::pmr::vector<NoteGroup> sheet(scratch);
+    parse_into(sheet, raw, open_brace, close_brace, sustain_indicator);
+    return sheet;
+}
+
+std::size_t count_note_groups(
+    const std::string_view raw,
+    const char open_brace,
+    const char close_brace,
+    const char sustain_indicator
+) {
+    GroupCounter counter;
+    parse_into(counter, raw, open_brace, close_brace, sustain_indicator);
+    return counter.count;
+}
+
 } // namespace piano_assist
@@ -0,0 +1,245 @@
+#include "piano_assist/song_query.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <compare>
+#include <numeric>
+#include <utility>
+
+#include "piano_assist/scratch_arena.hpp"
+#include "piano_assist/trace.hpp"
+
+namespace piano_assist {
+namespace {
+
+// Trimmed and case-folded the way collation keys are.
+std::string folded_needle(const std::string_view value) {
+    std::size_t start = 0;
+    std::size_t end = value.size();
+    while (start < end && std::isspace(static_cast<unsigned char>(value[start])) != 0) {
+        ++start;
+    }
+    while (end > start && std::isspace(static_cast<unsigned char>(value[end - 1])) != 0) {
+        --end;
+    }
+    std::string folded(value.substr(start, end - start));
+    std::transform(folded.begin(), folded.end(), folded.begin(), [](const unsigned char c) {
+        return static_cast<char>(std::tolower(c));
+    });
+    return folded;
+}
+
+bool name_matches(const SongCatalog& catalog, const SongCatalog::Index index, const std::string_view folded_name) {
+    return folded_name.empty() || catalog.collation_key(index).find(folded_name) != std::string_view::npos;
+}
+
+bool content_matches(
+    const SongRepository& repository,
+    const SongCatalog& catalog,
+    const SongCatalog::Index index,
+    const std::string_view content,
+    std::pmr::memory_resource* scratch
+) {
+    return content.empty() ||
+           repository.load_raw_sheet_text(catalog.song(index), scratch).find(content) != std::pmr::string::npos;
+}
+
+} // namespace
+
+struct SongQueryIndex::SortKey {
+    std::int64_t number{0};
+    std::string_view key{};
+    std::string_view id{};
+
+    auto operator<=>(const SortKey&) const = default;
+};
+
+SongQueryIndex::SongQueryIndex(
+    std::shared_ptr<const SongCatalog> catalog,
+    SongRepository repository,
+    const PlayTimes& played
+)
+    : catalog_(std::move(catalog)),
+      repository_(std::move(repository)) {
+    SHEETMASTER_TRACE_SCOPE("SongQueryIndex::SongQueryIndex");
+    const SongCatalog& songs = *catalog_;
+    by_id_.resize(songs.size());
+    std::iota(by_id_.begin(), by_id_.end(), SongCatalog::Index{0});
+    std::sort(by_id_.begin(), by_id_.end(), [&songs](const SongCatalog::Index lhs, const SongCatalog::Index rhs) {
+        return songs.id(lhs) < songs.id(rhs);
+    });
+
+    // The history is usually far smaller than the library, so it is the side that gets walked.
+    for (const auto& [id, played_at] : played) {
+        const std::optional<SongCatalog::Index> index = find(id);
+        if (!index.has_value()) {
+            continue;
+        }
+        if (played_at_.empty()) {
+            played_at_.resize(songs.size(), 0);
+        }
+        played_at_[*index] = played_at;
+    }
+
+    for (SongCatalog::Index index = 0; index < songs.size(); ++index) {
+        for (const StringHandle tag : songs.tag_handles(index)) {
+            by_tag_[tag].rows.push_back(index);
+        }
+    }
+}
+
+SongPage SongQueryIndex::run(const SongQuery& query, const std::function<bool()>& should_stop) const {
+    SHEETMASTER_TRACE_SCOPE("SongQueryIndex::run");
+    const SongCatalog& catalog = *catalog_;
+    SongPage page{};
+    page.songs.catalog = catalog_;
+    if (query.limit == 0) {
+        return page;
+    }
+
+    // A tag narrows the walk to its own songs.
+    const CatalogRows* candidates = nullptr;
+    if (query.tag.empty()) {
+        candidates = &order(orders_, query.sort, nullptr);
+    } else {
+        const auto it = by_tag_.find(catalog.find_tag(query.tag));
+        if (it == by_tag_.end()) {
+            return page;
+        }
+        candidates = &order(it->second.orders, query.sort, &it->second.rows);
+    }
+
+    const std::size_t count = candidates->size();
+    std::size_t position = 0;
+    if (query.after.has_value()) {
+        const SortKey cursor{query.after->number, query.after->key, query.after->id};
+        if (query.descending) {
+            const auto bound = std::lower_bound(candidates->begin(), candidates->end(), cursor, [this, &query](const SongCatalog::Index row, const SortKey& value) {
+                return key_of(query.sort, row) < value;
+            });
+            position = static_cast<std::size_t>(candidates->end() - bound);
+        } else {
+            const auto bound = std::upper_bound(candidates->begin(), candidates->end(), cursor, [this, &query](const SortKey& value, const SongCatalog::Index row) {
+                return value < key_of(query.sort, row);
+            });
+            position = static_cast<std::size_t>(bound - candidates->begin());
+        }
+    }
+
+    const std::string folded_name = folded_needle(query.name);
+    std::optional<ScratchArena> arena;
+    if (!query.content.empty()) {
+        arena.emplace();
+    }
+
+    std::size_t skipped = 0;
+    for (; position < count; ++position) {
+        if (should_stop && should_stop()) {
+            page.songs.rows.clear();
+            page.next.reset();
+            return page;
+        }
+
+        const SongCatalog::Index row = (*candidates)[query.descending ? count - 1 - position : position];
+        ++page.examined;
+        if (!name_matches(catalog, row, folded_name)) {
+            continue;
+        }
+        if (arena.has_value()) {
+            const bool found = content_matches(repository_, catalog, row, query.content, arena->resource());
+            arena->reset();
+            if (!found) {
+                continue;
+            }
+        }
+        if (skipped < query.offset) {
+            ++skipped;
+            continue;
+        }
+
+        page.songs.rows.push_back(row);
+        if (page.songs.rows.size() == query.limit) {
+            if (position + 1 < count) {
+                const SortKey last = key_of(query.sort, row);
+                page.next = SongCursor{last.number, std::string(last.key), std::string(last.id)};
+            }
+            break;
+        }
+    }
+    return page;
+}
+
+bool SongQueryIndex::matches(const SongQuery& query, const std::string_view song_id) const {
+    const std::optional<SongCatalog::Index> index = find(song_id);
+    if (!index.has_value()) {
+        return false;
+    }
+
+    const SongCatalog& catalog = *catalog_;
+    if (!query.tag.empty() && !catalog.has_tag(*index, query.tag)) {
+        return false;
+    }
+    if (!name_matches(catalog, *index, folded_needle(query.name))) {
+        return false;
+    }
+    if (query.content.empty()) {
+        return true;
+    }
+    ScratchArena arena;
+    return content_matches(repository_, catalog, *index, query.content, arena.resource());
+}
+
+std::int64_t SongQueryIndex::played_at(const SongCatalog::Index index) const {
+    return played_at_.empty() ? 0 : played_at_[index];
+}
+
+SongQueryIndex::SortKey SongQueryIndex::key_of(const SongSortKey sort, const SongCatalog::Index index) const {
+    const SongCatalog& catalog = *catalog_;
+    SortKey key{0, catalog.collation_key(index), catalog.id(index)};
+    switch (sort) {
+        case SongSortKey::Name:
+            break;
+        case SongSortKey::RecentlyPlayed:
+            // Negated so the newest comes first and unplayed songs, at 0, after every played one.
+            key.number = -played_at(index);
+            break;
+        case SongSortKey::Length:
+            key.number = catalog.sheet_bytes(index);
+            break;
+    }
+    return key;
+}
+
+const CatalogRows& SongQueryIndex::order(Orders& orders, const SongSortKey sort, const CatalogRows* songs) const {
+    Order& order = orders[static_cast<std::size_t>(sort)];
+    std::call_once(order.built, [this, sort, songs, &order]() {
+        SHEETMASTER_TRACE_SCOPE("SongQueryIndex::order");
+        // Name order breaks every tie the other keys leave, so a stable sort on the number finishes them.
+        if (songs == nullptr) {
+            order.rows = catalog_->sorted_rows();
+        } else {
+            order.rows = *songs;
+            catalog_->sort(order.rows);
+        }
+        if (sort == SongSortKey::Name || (sort == SongSortKey::RecentlyPlayed && played_at_.empty())) {
+            return;
+        }
+        std::stable_sort(order.rows.begin(), order.rows.end(), [this, sort](const SongCatalog::Index lhs, const SongCatalog::Index rhs) {
+            return key_of(sort, lhs).number < key_of(sort, rhs).number;
+        });
+    });
+    return order.rows;
+}
+
+std::optional<SongCatalog::Index> SongQueryIndex::find(const std::string_view song_id) const {
+    const SongCatalog& catalog = *catalog_;
+    const auto it = std::lower_bound(by_id_.begin(), by_id_.end(), song_id, [&catalog](const SongCatalog::Index index, const std::string_view id) {
+        return catalog.id(index) < id;
+    });
+    if (it == by_id_.end() || catalog.id(*it) != song_id) {
+        return std::nullopt;
+    }
+    return *it;
+}
+
+} // namespace piano_assist
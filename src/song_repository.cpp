@@ -4,12 +4,16 @@
 #include <cctype>
 #include <cstdint>
 #include <fstream>
-#include <sstream>
+#include <limits>
+#include <memory_resource>
 #include <stdexcept>
 #include <string_view>
 #include <utility>
 
+#include "piano_assist/scratch_arena.hpp"
 #include "piano_assist/song_parser.hpp"
+#include "piano_assist/startup_profiler.hpp"
+#include "piano_assist/trace.hpp"
 
 namespace piano_assist {
 namespace {
@@ -21,18 +25,9 @@ constexpr std::string_view kSongDataExtensionLower = ".padata";
 constexpr std::string_view kLegacySongDataExtensionLower = ".txt";
 constexpr std::uint64_t kFnvOffsetBasis = 14695981039346656037ULL;
 constexpr std::uint64_t kFnvPrime = 1099511628211ULL;
+constexpr std::size_t kFileBufferBytes = 4096;
 
-struct SongDocument {
-    std::string id{};
-    std::string display_name{};
-    char open_brace{'['};
-    char close_brace{']'};
-    char sustain_indicator{'-'};
-    std::string body{};
-    bool is_modern{false};
-};
-
-std::string trim(const std::string_view value) {
+std::string_view trim(const std::string_view value) {
     std::size_t start = 0;
     while (start < value.size() && std::isspace(static_cast<unsigned char>(value[start])) != 0) {
         ++start;
@@ -43,7 +38,7 @@ std::string trim(const std::string_view value) {
         --end;
     }
 
-    return std::string(value.substr(start, end - start));
+    return value.substr(start, end - start);
 }
 
 bool is_grouping_pair_valid(const char open_brace, const char close_brace) {
@@ -77,51 +72,47 @@ std::string normalize_display_name_value(const std::string_view name) {
         }
     }
 
-    cleaned = trim(cleaned);
-    if (cleaned.empty()) {
+    const std::string_view kept = trim(cleaned);
+    if (kept.empty()) {
         return "Untitled Song";
     }
-    return cleaned;
+    return kept.size() == cleaned.size() ? cleaned : std::string(kept);
 }
 
+// Lowercases letters and digits, keeps '_' and '-', turns whitespace into '_' and drops
+// everything else; runs of separators collapse and none are left at either end.
 std::string sanitize_song_id(const std::string_view value) {
-    std::string cleaned;
-    cleaned.reserve(value.size());
-
+    std::string id;
+    id.reserve(value.size());
+    bool last_was_separator = true;
     for (const char raw : value) {
         const unsigned char c = static_cast<unsigned char>(raw);
+        char mapped = '\0';
         if (std::isalnum(c) != 0) {
-            cleaned.push_back(static_cast<char>(std::tolower(c)));
+            mapped = static_cast<char>(std::tolower(c));
         } else if (raw == '_' || raw == '-') {
-            cleaned.push_back(raw);
+            mapped = raw;
         } else if (std::isspace(c) != 0) {
-            cleaned.push_back('_');
+            mapped = '_';
+        } else {
+            continue;
         }
-    }
 
-    std::string compacted;
-    compacted.reserve(cleaned.size());
-    bool last_was_separator = true;
-    for (const char c : cleaned) {
-        const bool is_separator = c == '_' || c == '-';
+        const bool is_separator = mapped == '_' || mapped == '-';
         if (is_separator && last_was_separator) {
             continue;
         }
-        compacted.push_back(c);
+        id.push_back(mapped);
         last_was_separator = is_separator;
     }
 
-    while (!compacted.empty() && (compacted.front() == '_' || compacted.front() == '-')) {
-        compacted.erase(compacted.begin());
-    }
-    while (!compacted.empty() && (compacted.back() == '_' || compacted.back() == '-')) {
-        compacted.pop_back();
+    while (!id.empty() && (id.back() == '_' || id.back() == '-')) {
+        id.pop_back();
     }
-
-    if (compacted.empty()) {
+    if (id.empty()) {
         return "song";
     }
-    return compacted;
+    return id;
 }
 
 std::string id_slug_from_name(const std::string_view name) {
@@ -157,6 +148,14 @@ std::uint64_t fnv1a_64(const std::string_view data) {
     return hash;
 }
 
+// needle must already be lowercase.
+bool contains_lowercase(const std::string_view haystack, const std::string_view needle) {
+    const auto found = std::search(haystack.begin(), haystack.end(), needle.begin(), needle.end(), [](const char lhs, const char rhs) {
+        return std::tolower(static_cast<unsigned char>(lhs)) == static_cast<unsigned char>(rhs);
+    });
+    return needle.empty() || found != haystack.end();
+}
+
 std::string build_song_id(
     const std::string_view display_name,
     const std::string_view raw_sheet_data,
@@ -177,23 +176,55 @@ std::string build_song_id(
     return id_slug_from_name(display_name) + "_" + hex_u64(fnv1a_64(seed));
 }
 
-SongDocument read_song_document(const std::filesystem::path& path) {
-    SongDocument document{};
-
-    std::ifstream in(path);
+// Fills document's metadata and, when body is given, appends the sheet text to it. The file
+// buffer and the line buffer come from scratch.
+template <typename Body>
+void read_document(
+    const std::filesystem::path& path,
+    std::pmr::memory_resource* scratch,
+    SongDocument& document,
+    Body* body
+) {
+    // Declared first so it outlives the stream that reads into it.
+    std::pmr::vector<char> file_buffer(kFileBufferBytes, scratch);
+    std::ifstream in;
+    in.rdbuf()->pubsetbuf(file_buffer.data(), static_cast<std::streamsize>(file_buffer.size()));
+    in.open(path);
     if (!in) {
-        return document;
+        return;
     }
 
-    std::string first_line;
-    if (!std::getline(in, first_line)) {
-        return document;
+    std::error_code size_error;
+    const std::uintmax_t file_bytes = std::filesystem::file_size(path, size_error);
+    // Whatever follows the metadata already read is sheet text.
+    const auto count_body_bytes = [&in, &document, &size_error, file_bytes]() {
+        const std::streamoff position = in.tellg();
+        if (!size_error && position >= 0 && static_cast<std::uintmax_t>(position) <= file_bytes) {
+            document.body_bytes = static_cast<std::size_t>(file_bytes - static_cast<std::uintmax_t>(position));
+        }
+    };
+
+    std::pmr::string line(scratch);
+    const auto append_lines = [&in, &line, body](bool first) {
+        while (std::getline(in, line)) {
+            if (!first) {
+                body->push_back('\n');
+            }
+            body->append(line);
+            first = false;
+        }
+    };
+
+    if (!std::getline(in, line)) {
+        return;
+    }
+    if (body != nullptr) {
+        body->reserve(size_error ? 0 : static_cast<std::size_t>(file_bytes));
     }
 
-    const std::string first_trimmed = trim(first_line);
+    const std::string_view first_trimmed = trim(line);
     if (first_trimmed == kModernMarker) {
         document.is_modern = true;
-        std::string line;
         while (std::getline(in, line)) {
             if (trim(line) == kMetadataSeparator) {
                 break;
@@ -204,8 +235,8 @@ SongDocument read_song_document(const std::filesystem::path& path) {
                 continue;
             }
 
-            const std::string key = trim(line.substr(0, delimiter));
-            const std::string value = trim(line.substr(delimiter + 1));
+            const std::string_view key = trim(std::string_view(line).substr(0, delimiter));
+            const std::string_view value = trim(std::string_view(line).substr(delimiter + 1));
             if (key == "id") {
                 document.id = sanitize_song_id(value);
             } else if (key == "name") {
@@ -221,49 +252,46 @@ SongDocument read_song_document(const std::filesystem::path& path) {
             }
         }
 
-        std::ostringstream body;
-        bool first = true;
-        while (std::getline(in, line)) {
-            if (!first) {
-                body << '\n';
-            }
-            body << line;
-            first = false;
+        count_body_bytes();
+        if (body != nullptr) {
+            append_lines(true);
         }
-        document.body = body.str();
-        return document;
+        return;
     }
 
-    const auto [legacy_open, legacy_close] = parse_grouping_token(first_trimmed);
     if (first_trimmed == "[]" || first_trimmed == "()") {
+        const auto [legacy_open, legacy_close] = parse_grouping_token(first_trimmed);
         document.open_brace = legacy_open;
         document.close_brace = legacy_close;
-    } else {
-        std::ostringstream body;
-        body << first_line;
-        std::string line;
-        while (std::getline(in, line)) {
-            body << '\n' << line;
+        count_body_bytes();
+        if (body != nullptr) {
+            append_lines(true);
         }
-        document.body = body.str();
-        return document;
+        return;
     }
 
-    std::ostringstream body;
-    std::string line;
-    bool first = true;
-    while (std::getline(in, line)) {
-        if (!first) {
-            body << '\n';
-        }
-        body << line;
-        first = false;
+    document.body_bytes = size_error ? 0 : static_cast<std::size_t>(file_bytes);
+    if (body != nullptr) {
+        body->append(line);
+        append_lines(false);
     }
-    document.body = body.str();
+}
+
+} // namespace
+
+SongDocument read_song_document(const std::filesystem::path& path) {
+    return read_song_document(path, std::pmr::get_default_resource());
+}
+
+SongDocument read_song_document(const std::filesystem::path& path, std::pmr::memory_resource* scratch) {
+    SHEETMASTER_TRACE_SCOPE("read_song_document");
+    SongDocument document{};
+    read_document(path, scratch, document, &document.body);
     return document;
 }
 
 void write_song_document(const std::filesystem::path& path, const SongDocument& document) {
+    SHEETMASTER_TRACE_SCOPE("write_song_document");
     std::ofstream out(path, std::ios::trunc);
     if (!out) {
         throw std::runtime_error("Unable to write song file.");
@@ -296,11 +324,11 @@ void write_song_document(const std::filesystem::path& path, const SongDocument&
     }
 }
 
-} // namespace
-
-SongRepository::SongRepository(std::filesystem::path sheet_folder) : sheet_folder_(std::move(sheet_folder)) {}
+SongRepository::SongRepository(std::filesystem::path sheet_folder)
+    : sheet_folder_(std::move(sheet_folder)), migration_once_(std::make_shared<std::once_flag>()) {}
 
 void SongRepository::ensure_storage() const {
+    SHEETMASTER_TRACE_SCOPE("SongRepository::ensure_storage");
     std::error_code error;
     std::filesystem::create_directories(sheet_folder_, error);
     migrate_legacy_files_if_needed();
@@ -332,16 +360,47 @@ std::filesystem::path SongRepository::make_unique_path(const std::string_view ba
 }
 
 std::vector<Song> SongRepository::list_songs(const std::string_view filter) const {
+    return list_songs(filter, {});
+}
+
+std::vector<Song> SongRepository::list_songs(
+    const std::string_view filter,
+    const std::function<bool()>& should_stop
+) const {
+    SHEETMASTER_TRACE_SCOPE("SongRepository::list_songs");
+    const SongCatalog catalog = load_catalog(filter, should_stop);
     std::vector<Song> songs;
+    songs.reserve(catalog.size());
+    for (const SongCatalog::Index index : catalog.sorted_rows()) {
+        songs.push_back(catalog.song(index));
+    }
+    return songs;
+}
+
+SongCatalog SongRepository::load_catalog(
+    const std::string_view filter,
+    const std::function<bool()>& should_stop,
+    const std::size_t first_batch,
+    const SongBatchCallback& on_batch
+) const {
+    SHEETMASTER_TRACE_SCOPE("SongRepository::load_catalog");
+    SongCatalog catalog;
+    std::size_t next_batch = std::max<std::size_t>(first_batch, 1);
 
     migrate_legacy_files_if_needed();
 
     if (!std::filesystem::exists(sheet_folder_)) {
-        return songs;
+        return catalog;
     }
 
+    // Listing needs only the metadata; each file's buffers are dropped before the next is read.
+    ScratchArena arena;
     const std::string lowered_filter = to_lower(trim(filter));
     for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(sheet_folder_)) {
+        if (should_stop && should_stop()) {
+            return {};
+        }
+        arena.reset();
         if (!entry.is_regular_file()) {
             continue;
         }
@@ -351,44 +410,65 @@ std::vector<Song> SongRepository::list_songs(const std::string_view filter) cons
             continue;
         }
 
-        const SongDocument document = read_song_document(entry.path());
-        const std::string display_name = normalize_display_name(
-            document.display_name.empty() ? entry.path().stem().string() : document.display_name
-        );
-        if (!lowered_filter.empty() && to_lower(display_name).find(lowered_filter) == std::string::npos) {
+        SongDocument document{};
+        read_document<std::string>(entry.path(), arena.resource(), document, nullptr);
+        // Stored names and ids were normalized as they were read.
+        const std::string display_name = document.display_name.empty()
+                                             ? normalize_display_name(entry.path().stem().string())
+                                             : std::move(document.display_name);
+        if (!contains_lowercase(display_name, lowered_filter)) {
             continue;
         }
 
-        Song song{};
-        song.id = sanitize_song_id(document.id.empty() ? entry.path().stem().string() : document.id);
-        song.name = display_name;
-        song.file_name = entry.path().filename().string();
-        song.open_brace = document.open_brace;
-        song.close_brace = document.close_brace;
-        song.sustain_indicator = document.sustain_indicator;
-
-        songs.push_back(std::move(song));
+        const std::string id = document.id.empty() ? sanitize_song_id(entry.path().stem().string()) : std::move(document.id);
+        catalog.add(
+            id,
+            display_name,
+            entry.path().filename().string(),
+            document.open_brace,
+            document.close_brace,
+            document.sustain_indicator,
+            static_cast<std::uint32_t>(std::min<std::size_t>(document.body_bytes, std::numeric_limits<std::uint32_t>::max()))
+        );
+        if (on_batch && catalog.size() == next_batch) {
+            on_batch(catalog);
+            next_batch *= 2;
+        }
     }
+    catalog.shrink_to_fit();
+    return catalog;
+}
 
-    std::sort(songs.begin(), songs.end(), [](const Song& lhs, const Song& rhs) {
-        const std::string left = SongRepository::to_lower(lhs.name);
-        const std::string right = SongRepository::to_lower(rhs.name);
-        if (left == right) {
-            return lhs.id < rhs.id;
+void SongRepository::sort_songs(std::vector<Song>& songs) {
+    // Each name is folded once rather than on every comparison.
+    std::vector<std::pair<std::string, std::size_t>> keys;
+    keys.reserve(songs.size());
+    for (std::size_t index = 0; index < songs.size(); ++index) {
+        keys.emplace_back(to_lower(songs[index].name), index);
+    }
+    std::sort(keys.begin(), keys.end(), [&songs](const auto& lhs, const auto& rhs) {
+        if (lhs.first == rhs.first) {
+            return songs[lhs.second].id < songs[rhs.second].id;
         }
-        return left < right;
+        return lhs.first < rhs.first;
     });
 
-    return songs;
+    std::vector<Song> sorted;
+    sorted.reserve(songs.size());
+    for (const auto& key : keys) {
+        sorted.push_back(std::move(songs[key.second]));
+    }
+    songs = std::move(sorted);
 }
 
 std::vector<NoteGroup> SongRepository::load_sheet(const Song& song) const {
+    SHEETMASTER_TRACE_SCOPE("SongRepository::load_sheet");
     migrate_legacy_files_if_needed();
 
     const std::filesystem::path path = sheet_folder_ / song.file_name;
     const SongDocument document = read_song_document(path);
     return parse_sheet(
-        document.body + " ",
+        document.body,
         document.open_brace,
         document.close_brace,
         document.sustain_indicator
@@ -396,12 +476,23 @@ std::vector<NoteGroup> SongRepository::load_sheet(const Song& song) const {
 }
 
 std::string SongRepository::load_raw_sheet_text(const Song& song) const {
+    SHEETMASTER_TRACE_SCOPE("SongRepository::load_raw_sheet_text");
     migrate_legacy_files_if_needed();
 
     const std::filesystem::path path = sheet_folder_ / song.file_name;
     return read_song_document(path).body;
 }
 
+std::pmr::string SongRepository::load_raw_sheet_text(const Song& song, std::pmr::memory_resource* scratch) const {
+    SHEETMASTER_TRACE_SCOPE("SongRepository::load_raw_sheet_text");
+    migrate_legacy_files_if_needed();
+
+    SongDocument document{};
+    std::pmr::string body(scratch);
+    read_document(sheet_folder_ / song.file_name, scratch, document, &body);
+    return body;
+}
+
 std::string SongRepository::import_song(
     const std::string_view requested_name,
     const std::string_view raw_sheet_data,
@@ -409,6 +500,7 @@ std::string SongRepository::import_song(
     const char close_brace,
     const char sustain_indicator
 ) const {
+    SHEETMASTER_TRACE_SCOPE("SongRepository::import_song");
     ensure_storage();
 
     const std::string display_name = normalize_display_name(requested_name);
@@ -435,6 +527,7 @@ std::string SongRepository::import_song(
 }
 
 std::string SongRepository::rename_song(const Song& song, const std::string_view new_name) const {
+    SHEETMASTER_TRACE_SCOPE("SongRepository::rename_song");
     const std::filesystem::path path = sheet_folder_ / song.file_name;
     SongDocument document = read_song_document(path);
     document.id = sanitize_song_id(song.id.empty() ? path.stem().string() : song.id);
@@ -447,12 +540,14 @@ std::string SongRepository::rename_song(const Song& song, const std::string_view
 }
 
 void SongRepository::delete_song(const Song& song) const {
+    SHEETMASTER_TRACE_SCOPE("SongRepository::delete_song");
     const std::filesystem::path path = sheet_folder_ / song.file_name;
     std::error_code error;
     std::filesystem::remove(path, error);
 }
 
 void SongRepository::update_song_contents(const Song& song, const std::string_view raw_sheet_data) const {
+    SHEETMASTER_TRACE_SCOPE("SongRepository::update_song_contents");
     const std::filesystem::path path = sheet_folder_ / song.file_name;
     SongDocument document = read_song_document(path);
     document.id = sanitize_song_id(song.id.empty() ? path.stem().string() : song.id);
@@ -465,11 +560,14 @@ void SongRepository::update_song_contents(const Song& song, const std::string_vi
 }
 
 void SongRepository::migrate_legacy_files_if_needed() const {
-    if (migration_checked_) {
-        return;
-    }
-    migration_checked_ = true;
+    std::call_once(*migration_once_, [this]() {
+        const ScopedStartupPhase phase("legacy_song_migration");
+        migrate_legacy_files();
+    });
+}
 
+void SongRepository::migrate_legacy_files() const {
+    SHEETMASTER_TRACE_SCOPE("SongRepository::migrate_legacy_files");
     if (!std::filesystem::exists(sheet_folder_)) {
         return;
     }
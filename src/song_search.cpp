@@ -0,0 +1,195 @@
+#include "piano_assist/song_search.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <set>
+#include <string_view>
+#include <utility>
+
+#include "piano_assist/startup_profiler.hpp"
+#include "piano_assist/trace.hpp"
+
+namespace piano_assist {
+namespace {
+
+// Attaches the stored tags to catalog and freezes it for sharing.
+std::shared_ptr<const SongCatalog> tagged_catalog(SongCatalog catalog, const SongTagMap& tags) {
+    if (!tags.empty()) {
+        // Few songs carry tags, so the stored ids are sorted once and searched per song.
+        std::vector<const SongTagMap::value_type*> tagged;
+        tagged.reserve(tags.size());
+        for (const auto& entry : tags) {
+            tagged.push_back(&entry);
+        }
+        std::sort(tagged.begin(), tagged.end(), [](const auto* lhs, const auto* rhs) {
+            return lhs->first < rhs->first;
+        });
+        for (SongCatalog::Index index = 0; index < catalog.size(); ++index) {
+            const std::string_view id = catalog.id(index);
+            const auto it = std::lower_bound(tagged.begin(), tagged.end(), id, [](const auto* entry, const std::string_view value) {
+                return entry->first < value;
+            });
+            if (it != tagged.end() && (*it)->first == id) {
+                catalog.set_tags(index, (*it)->second);
+            }
+        }
+        catalog.shrink_to_fit();
+    }
+    return std::make_shared<const SongCatalog>(std::move(catalog));
+}
+
+} // namespace
+
+std::vector<std::string> collect_tags(const SongTagMap& tags) {
+    std::set<std::string> unique;
+    for (const auto& entry : tags) {
+        unique.insert(entry.second.begin(), entry.second.end());
+    }
+    return std::vector<std::string>(unique.begin(), unique.end());
+}
+
+SongSearchWorker::SongSearchWorker(
+    SongRepository repository,
+    TagStore tag_store,
+    PlayHistory play_history,
+    Completion completion
+)
+    : repository_(std::move(repository)),
+      tag_store_(std::move(tag_store)),
+      play_history_(std::move(play_history)),
+      completion_(std::move(completion)),
+      worker_([this](const std::stop_token stop) {
+          run(stop);
+      }) {}
+
+SongSearchWorker::~SongSearchWorker() {
+    stop();
+}
+
+std::uint64_t SongSearchWorker::submit(SongSearchQuery query) {
+    std::uint64_t generation = 0;
+    {
+        const std::lock_guard lock(mutex_);
+        pending_ = std::move(query);
+        generation = ++generation_;
+    }
+    wake_.notify_one();
+    return generation;
+}
+
+void SongSearchWorker::stop() {
+    if (!worker_.joinable()) {
+        return;
+    }
+    ++generation_;
+    worker_.request_stop();
+    wake_.notify_one();
+    worker_.join();
+}
+
+std::uint64_t SongSearchWorker::generation() const {
+    return generation_.load();
+}
+
+void SongSearchWorker::run(const std::stop_token stop) {
+    tracer().set_thread_name("song_search");
+    try {
+        const ScopedStartupPhase phase("ensure_storage");
+        repository_.ensure_storage();
+    } catch (const std::exception&) {
+    }
+
+    while (!stop.stop_requested()) {
+        SongSearchQuery query{};
+        std::uint64_t generation = 0;
+        {
+            std::unique_lock lock(mutex_);
+            if (!wake_.wait(lock, stop, [this] {
+                    return pending_.has_value();
+                })) {
+                return;
+            }
+            query = std::move(*pending_);
+            pending_.reset();
+            generation = generation_.load();
+        }
+
+        std::optional<SongSearchResult> result = execute(query, generation, stop);
+        if (result.has_value() && generation == generation_.load() && completion_) {
+            completion_(std::move(*result));
+        }
+    }
+}
+
+std::optional<SongSearchResult> SongSearchWorker::execute(
+    const SongSearchQuery& query,
+    const std::uint64_t generation,
+    const std::stop_token& stop
+) {
+    SHEETMASTER_TRACE_SCOPE("SongSearchWorker::execute");
+    const std::function<bool()> superseded = [this, generation, &stop]() {
+        return stop.stop_requested() || generation != generation_.load();
+    };
+
+    if (query.reload || index_ == nullptr) {
+        SongTagMap tags;
+        PlayTimes played;
+        SongBatchCallback on_batch;
+        if (query.stream) {
+            // Partial pages use the tags as stored; the complete result applies the name-key migration.
+            tags = tag_store_.load_all();
+            played = play_history_.load_all();
+            on_batch = [&](const SongCatalog& songs_so_far) {
+                if (superseded() || !completion_) {
+                    return;
+                }
+                SongSearchResult partial{};
+                partial.generation = generation;
+                partial.query = query;
+                partial.index = std::make_shared<const SongQueryIndex>(tagged_catalog(songs_so_far, tags), repository_, played);
+                partial.page = partial.index->run(query.query, superseded);
+                partial.all_tags = collect_tags(tags);
+                partial.complete = false;
+                completion_(std::move(partial));
+            };
+        }
+
+        // Every query after this one is answered from the catalog, so it is always read whole.
+        SongCatalog catalog = repository_.load_catalog({}, superseded, kSearchFirstBatch, on_batch);
+        if (superseded()) {
+            return std::nullopt;
+        }
+
+        {
+            const ScopedStartupPhase phase("tag_store_migration");
+            tag_store_.migrate_song_name_keys_to_ids(catalog);
+        }
+        tags = tag_store_.load_all();
+        // Taken before reading, so a play recorded meanwhile still marks the index stale.
+        play_revision_ = PlayHistory::revision();
+        played = play_history_.load_all();
+        if (superseded()) {
+            return std::nullopt;
+        }
+
+        all_tags_ = collect_tags(tags);
+        index_ = std::make_shared<const SongQueryIndex>(tagged_catalog(std::move(catalog), tags), repository_, played);
+    } else if (query.query.sort == SongSortKey::RecentlyPlayed && PlayHistory::revision() != play_revision_) {
+        // The catalog is unchanged; only the play times behind the order moved.
+        play_revision_ = PlayHistory::revision();
+        index_ = std::make_shared<const SongQueryIndex>(index_->catalog(), repository_, play_history_.load_all());
+    }
+
+    SongSearchResult result{};
+    result.generation = generation;
+    result.query = query;
+    result.index = index_;
+    result.page = index_->run(query.query, superseded);
+    result.all_tags = all_tags_;
+    if (superseded()) {
+        return std::nullopt;
+    }
+    return result;
+}
+
+} // namespace piano_assist
@@ -0,0 +1,202 @@
+#include "piano_assist/song_table_model.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <numeric>
+#include <utility>
+
+#include <QStringList>
+
+namespace piano_assist {
+namespace {
+
+// Beyond this many scattered ranges the per-signal bookkeeping in the view costs more than a reset.
+constexpr std::size_t kMaxIncrementalRanges = 64;
+
+int to_qt_int(const std::size_t value) {
+    if (value > static_cast<std::size_t>(std::numeric_limits<int>::max())) {
+        return std::numeric_limits<int>::max();
+    }
+    return static_cast<int>(value);
+}
+
+QString to_qstring(const std::string_view value) {
+    return QString::fromUtf8(value.data(), static_cast<qsizetype>(value.size()));
+}
+
+QString join_tags(const SongCatalog& catalog, const SongCatalog::Index song) {
+    QStringList values;
+    for (std::size_t position = 0; position < catalog.tag_count(song); ++position) {
+        values.push_back(to_qstring(catalog.tag(song, position)));
+    }
+    return values.join(", ");
+}
+
+} // namespace
+
+SongTableModel::SongTableModel(QObject* parent) : QAbstractTableModel(parent) {}
+
+int SongTableModel::rowCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : to_qt_int(songs_.size());
+}
+
+int SongTableModel::columnCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+QVariant SongTableModel::data(const QModelIndex& index, const int role) const {
+    if (!index.isValid() || role != Qt::DisplayRole || index.row() >= to_qt_int(songs_.size())) {
+        return {};
+    }
+
+    const SongCatalog& catalog = *songs_.catalog;
+    const SongCatalog::Index song = songs_.rows[static_cast<std::size_t>(index.row())];
+    switch (index.column()) {
+        case NameColumn:
+            return to_qstring(catalog.name(song));
+        case TagsColumn:
+            return join_tags(catalog, song);
+        default:
+            return {};
+    }
+}
+
+QVariant SongTableModel::headerData(const int section, const Qt::Orientation orientation, const int role) const {
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) {
+        return {};
+    }
+    switch (section) {
+        case NameColumn:
+            return QString("Song");
+        case TagsColumn:
+            return QString("Tags");
+        default:
+            return {};
+    }
+}
+
+void SongTableModel::set_rows(SongListView songs) {
+    const SongListDiff diff = diff_song_lists(songs_, songs);
+    if (diff.empty()) {
+        // Same rows in the same order; only the catalog behind them is newer.
+        songs_ = std::move(songs);
+        return;
+    }
+
+    if (diff.reset || diff.removed.size() + diff.inserted.size() > kMaxIncrementalRanges) {
+        beginResetModel();
+        songs_ = std::move(songs);
+        rebuild_row_index();
+        endResetModel();
+        return;
+    }
+
+    for (const RowRange& range : diff.removed) {
+        beginRemoveRows(QModelIndex(), to_qt_int(range.first), to_qt_int(range.first + range.count - 1));
+        const auto first = songs_.rows.begin() + static_cast<std::ptrdiff_t>(range.first);
+        songs_.rows.erase(first, first + static_cast<std::ptrdiff_t>(range.count));
+        endRemoveRows();
+    }
+
+    // Every row left now survives into the new list, so it can switch to the new catalog
+    // before insertions index into it.
+    CatalogRows survivors;
+    survivors.reserve(songs_.rows.size());
+    auto next_inserted = diff.inserted.begin();
+    for (std::size_t row = 0; row < songs.rows.size(); ++row) {
+        if (next_inserted != diff.inserted.end() && row == next_inserted->first) {
+            row += next_inserted->count - 1;
+            ++next_inserted;
+            continue;
+        }
+        survivors.push_back(songs.rows[row]);
+    }
+    songs_.catalog = songs.catalog;
+    songs_.rows = std::move(survivors);
+
+    for (const RowRange& range : diff.inserted) {
+        beginInsertRows(QModelIndex(), to_qt_int(range.first), to_qt_int(range.first + range.count - 1));
+        const auto source = songs.rows.begin() + static_cast<std::ptrdiff_t>(range.first);
+        songs_.rows.insert(
+            songs_.rows.begin() + static_cast<std::ptrdiff_t>(range.first),
+            source,
+            source + static_cast<std::ptrdiff_t>(range.count)
+        );
+        endInsertRows();
+    }
+
+    songs_ = std::move(songs);
+    rebuild_row_index();
+    for (const RowRange& range : diff.changed) {
+        emit dataChanged(
+            index(to_qt_int(range.first), 0),
+            index(to_qt_int(range.first + range.count - 1), ColumnCount - 1)
+        );
+    }
+}
+
+void SongTableModel::set_page(std::shared_ptr<const SongQueryIndex> index, SongQuery query, SongPage page) {
+    index_ = std::move(index);
+    query_ = std::move(query);
+    next_ = std::move(page.next);
+    set_rows(std::move(page.songs));
+}
+
+bool SongTableModel::canFetchMore(const QModelIndex& parent) const {
+    return !parent.isValid() && index_ != nullptr && next_.has_value();
+}
+
+void SongTableModel::fetchMore(const QModelIndex& parent) {
+    if (!canFetchMore(parent)) {
+        return;
+    }
+
+    SongQuery query = query_;
+    query.after = std::move(next_);
+    query.offset = 0;
+    query.limit = kSongPageSize;
+    SongPage page = index_->run(query);
+    next_ = std::move(page.next);
+    if (page.songs.empty()) {
+        return;
+    }
+
+    const std::size_t first = songs_.size();
+    beginInsertRows(QModelIndex(), to_qt_int(first), to_qt_int(first + page.songs.size() - 1));
+    songs_.rows.insert(songs_.rows.end(), page.songs.rows.begin(), page.songs.rows.end());
+    endInsertRows();
+    rebuild_row_index();
+}
+
+std::optional<Song> SongTableModel::song_at(const int row) const {
+    if (row < 0 || row >= to_qt_int(songs_.size())) {
+        return std::nullopt;
+    }
+    return songs_.catalog->song(songs_.rows[static_cast<std::size_t>(row)]);
+}
+
+std::optional<int> SongTableModel::row_of(const std::string_view song_id) const {
+    const SongCatalog* catalog = songs_.catalog.get();
+    const auto it = std::lower_bound(rows_by_id_.begin(), rows_by_id_.end(), song_id, [this, catalog](const std::uint32_t row, const std::string_view id) {
+        return catalog->id(songs_.rows[row]) < id;
+    });
+    if (it == rows_by_id_.end() || catalog->id(songs_.rows[*it]) != song_id) {
+        return std::nullopt;
+    }
+    return to_qt_int(*it);
+}
+
+bool SongTableModel::contains(const std::string_view song_id) const {
+    return row_of(song_id).has_value() || (index_ != nullptr && next_.has_value() && index_->matches(query_, song_id));
+}
+
+void SongTableModel::rebuild_row_index() {
+    rows_by_id_.resize(songs_.size());
+    std::iota(rows_by_id_.begin(), rows_by_id_.end(), std::uint32_t{0});
+    std::sort(rows_by_id_.begin(), rows_by_id_.end(), [this](const std::uint32_t lhs, const std::uint32_t rhs) {
+        return songs_.catalog->id(songs_.rows[lhs]) < songs_.catalog->id(songs_.rows[rhs]);
+    });
+}
+
+} // namespace piano_assist
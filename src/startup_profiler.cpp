@@ -0,0 +1,181 @@
+#include "piano_assist/startup_profiler.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <utility>
+
+namespace piano_assist {
+namespace {
+
+std::chrono::microseconds since(const StartupProfiler::Clock::time_point origin, const StartupProfiler::Clock::time_point at) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(at - origin);
+}
+
+std::string milliseconds(const std::chrono::microseconds value) {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(3) << static_cast<double>(value.count()) / 1000.0;
+    return out.str();
+}
+
+std::string json_string(const std::string_view value) {
+    std::string out = "\"";
+    for (const char character : value) {
+        if (character == '"' || character == '\\') {
+            out.push_back('\\');
+        }
+        out.push_back(character);
+    }
+    out.push_back('"');
+    return out;
+}
+
+} // namespace
+
+StartupProfiler::StartupProfiler(const Clock::time_point origin) : origin_(origin) {}
+
+void StartupProfiler::enable(std::filesystem::path report_path) {
+    const std::lock_guard lock(mutex_);
+    enabled_ = true;
+    report_path_ = std::move(report_path);
+    ui_thread_ = std::this_thread::get_id();
+}
+
+bool StartupProfiler::enabled() const {
+    const std::lock_guard lock(mutex_);
+    return enabled_;
+}
+
+void StartupProfiler::record(const std::string_view name, const Clock::time_point start, const Clock::time_point end) {
+    const std::lock_guard lock(mutex_);
+    if (!enabled_ || written_) {
+        return;
+    }
+    const bool seen = std::any_of(phases_.begin(), phases_.end(), [name](const StartupPhase& phase) {
+        return phase.name == name;
+    });
+    if (seen) {
+        return;
+    }
+    phases_.push_back(StartupPhase{
+        std::string(name),
+        since(origin_, start),
+        std::chrono::duration_cast<std::chrono::microseconds>(end - start),
+        std::this_thread::get_id() == ui_thread_,
+    });
+}
+
+void StartupProfiler::mark(const std::string_view name, const Clock::time_point at) {
+    const std::lock_guard lock(mutex_);
+    if (!enabled_ || written_) {
+        return;
+    }
+    const bool seen = std::any_of(marks_.begin(), marks_.end(), [name](const StartupMark& mark) {
+        return mark.name == name;
+    });
+    if (!seen) {
+        marks_.push_back(StartupMark{std::string(name), since(origin_, at)});
+    }
+}
+
+std::vector<StartupPhase> StartupProfiler::phases() const {
+    const std::lock_guard lock(mutex_);
+    return phases_;
+}
+
+std::vector<StartupMark> StartupProfiler::marks() const {
+    const std::lock_guard lock(mutex_);
+    return marks_;
+}
+
+std::string StartupProfiler::to_json() const {
+    std::vector<StartupPhase> phases = this->phases();
+    const std::vector<StartupMark> marks = this->marks();
+    std::stable_sort(phases.begin(), phases.end(), [](const StartupPhase& lhs, const StartupPhase& rhs) {
+        return lhs.start < rhs.start;
+    });
+
+    std::chrono::microseconds total{};
+    for (const StartupPhase& phase : phases) {
+        total = std::max(total, phase.start + phase.duration);
+    }
+    for (const StartupMark& mark : marks) {
+        total = std::max(total, mark.at);
+    }
+
+    std::ostringstream out;
+    out << "{\n  \"total_ms\": " << milliseconds(total) << ",\n  \"phases\": [";
+    for (std::size_t index = 0; index < phases.size(); ++index) {
+        const StartupPhase& phase = phases[index];
+        out << (index == 0 ? "\n" : ",\n") << "    {\"name\": " << json_string(phase.name)
+            << ", \"start_ms\": " << milliseconds(phase.start) << ", \"duration_ms\": " << milliseconds(phase.duration)
+            << ", \"thread\": " << (phase.ui_thread ? "\"ui\"" : "\"background\"") << '}';
+    }
+    out << (phases.empty() ? "]" : "\n  ]") << ",\n  \"marks\": [";
+    for (std::size_t index = 0; index < marks.size(); ++index) {
+        out << (index == 0 ? "\n" : ",\n") << "    {\"name\": " << json_string(marks[index].name)
+            << ", \"at_ms\": " << milliseconds(marks[index].at) << '}';
+    }
+    out << (marks.empty() ? "]" : "\n  ]") << "\n}\n";
+    return out.str();
+}
+
+bool StartupProfiler::write_report() {
+    std::filesystem::path path;
+    {
+        const std::lock_guard lock(mutex_);
+        if (!enabled_ || written_) {
+            return false;
+        }
+        path = report_path_;
+    }
+
+    const std::string report = to_json();
+    {
+        const std::lock_guard lock(mutex_);
+        written_ = true;
+    }
+
+    std::error_code error;
+    if (path.has_parent_path()) {
+        std::filesystem::create_directories(path.parent_path(), error);
+    }
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out << report;
+    return static_cast<bool>(out);
+}
+
+ScopedStartupPhase::ScopedStartupPhase(const std::string_view name)
+    : name_(name), start_(StartupProfiler::Clock::now()) {}
+
+ScopedStartupPhase::~ScopedStartupPhase() {
+    startup_profiler().record(name_, start_, StartupProfiler::Clock::now());
+}
+
+StartupProfiler& startup_profiler() {
+    static StartupProfiler profiler;
+    return profiler;
+}
+
+std::optional<std::filesystem::path> startup_report_path(const int argc, const char* const* argv) {
+    for (int index = 1; index < argc; ++index) {
+        const std::string_view argument = argv[index];
+        if (argument == kStartupReportFlag && index + 1 < argc) {
+            return std::filesystem::path(argv[index + 1]);
+        }
+        if (argument.size() > kStartupReportFlag.size() + 1 && argument.starts_with(kStartupReportFlag) &&
+            argument[kStartupReportFlag.size()] == '=') {
+            return std::filesystem::path(argument.substr(kStartupReportFlag.size() + 1));
+        }
+    }
+
+    const char* environment = std::getenv(std::string(kStartupReportEnvironmentVariable).c_str());
+    if (environment != nullptr && *environment != '\0') {
+        return std::filesystem::path(environment);
+    }
+    return std::nullopt;
+}
+
+} // namespace piano_assist
@@ -3,15 +3,24 @@
 #include <algorithm>
 #include <cctype>
 #include <fstream>
+#include <mutex>
 #include <set>
 #include <sstream>
 #include <unordered_map>
 #include <utility>
 
+#include "piano_assist/startup_profiler.hpp"
+#include "piano_assist/trace.hpp"
+
 namespace piano_assist {
 namespace {
 
-using TagMap = std::unordered_map<std::string, std::vector<std::string>>;
+using TagMap = SongTagMap;
+
+std::mutex& storage_mutex() {
+    static std::mutex mutex;
+    return mutex;
+}
 
 std::string trim(std::string_view value) {
     std::size_t start = 0;
@@ -144,9 +153,51 @@ void save_map(const std::filesystem::path& storage_file, const TagMap& map) {
     }
 }
 
+// Moves tags stored under a song's name to its id when that name belongs to exactly one song.
+// Returns whether map changed.
+template <typename IdAt, typename NameAt>
+bool migrate_name_keys(TagMap& map, const std::size_t count, IdAt id_at, NameAt name_at) {
+    std::unordered_map<std::string, int> name_counts;
+    name_counts.reserve(count);
+    for (std::size_t index = 0; index < count; ++index) {
+        ++name_counts[trim(name_at(index))];
+    }
+
+    bool changed = false;
+    for (std::size_t index = 0; index < count; ++index) {
+        const std::string id_key = trim(id_at(index));
+        const std::string name_key = trim(name_at(index));
+        if (id_key.empty() || name_key.empty() || id_key == name_key) {
+            continue;
+        }
+
+        const auto existing_id = map.find(id_key);
+        if (existing_id != map.end()) {
+            continue;
+        }
+
+        const auto name_count = name_counts.find(name_key);
+        if (name_count == name_counts.end() || name_count->second != 1) {
+            continue;
+        }
+
+        const auto existing_name = map.find(name_key);
+        if (existing_name == map.end()) {
+            continue;
+        }
+
+        map[id_key] = normalize_tags(existing_name->second);
+        map.erase(existing_name);
+        changed = true;
+    }
+
+    return changed;
+}
+
 } // namespace
 
 TagStore::TagStore(std::filesystem::path storage_file) : storage_file_(std::move(storage_file)) {
+    const ScopedStartupPhase phase("tag_store_open");
     std::error_code error;
     if (storage_file_.has_parent_path()) {
         std::filesystem::create_directories(storage_file_.parent_path(), error);
@@ -176,51 +227,54 @@ TagStore::TagStore(std::filesystem::path storage_file) : storage_file_(std::move
 }
 
 void TagStore::migrate_song_name_keys_to_ids(const std::vector<Song>& songs) const {
+    SHEETMASTER_TRACE_SCOPE("TagStore::migrate_song_name_keys_to_ids");
+    const std::lock_guard lock(storage_mutex());
     TagMap map = load_map(storage_file_);
     if (map.empty() || songs.empty()) {
         return;
     }
 
-    std::unordered_map<std::string, int> name_counts;
-    name_counts.reserve(songs.size());
-    for (const Song& song : songs) {
-        ++name_counts[trim(song.name)];
-    }
-
-    bool changed = false;
-    for (const Song& song : songs) {
-        const std::string id_key = trim(song.id);
-        const std::string name_key = trim(song.name);
-        if (id_key.empty() || name_key.empty() || id_key == name_key) {
-            continue;
-        }
-
-        const auto existing_id = map.find(id_key);
-        if (existing_id != map.end()) {
-            continue;
-        }
-
-        const auto name_count = name_counts.find(name_key);
-        if (name_count == name_counts.end() || name_count->second != 1) {
-            continue;
-        }
-
-        const auto existing_name = map.find(name_key);
-        if (existing_name == map.end()) {
-            continue;
+    const bool changed = migrate_name_keys(
+        map,
+        songs.size(),
+        [&songs](const std::size_t index) {
+            return std::string_view(songs[index].id);
+        },
+        [&songs](const std::size_t index) {
+            return std::string_view(songs[index].name);
         }
+    );
+    if (changed) {
+        save_map(storage_file_, map);
+    }
+}
 
-        map[id_key] = normalize_tags(existing_name->second);
-        map.erase(existing_name);
-        changed = true;
+void TagStore::migrate_song_name_keys_to_ids(const SongCatalog& catalog) const {
+    SHEETMASTER_TRACE_SCOPE("TagStore::migrate_song_name_keys_to_ids");
+    const std::lock_guard lock(storage_mutex());
+    TagMap map = load_map(storage_file_);
+    if (map.empty() || catalog.empty()) {
+        return;
     }
 
+    const bool changed = migrate_name_keys(
+        map,
+        catalog.size(),
+        [&catalog](const std::size_t index) {
+            return catalog.id(static_cast<SongCatalog::Index>(index));
+        },
+        [&catalog](const std::size_t index) {
+            return catalog.name(static_cast<SongCatalog::Index>(index));
+        }
+    );
     if (changed) {
         save_map(storage_file_, map);
     }
 }
 
 std::vector<std::string> TagStore::tags_for_song(const std::string_view song_name) const {
+    SHEETMASTER_TRACE_SCOPE("TagStore::tags_for_song");
+    const std::lock_guard lock(storage_mutex());
     const TagMap map = load_map(storage_file_);
     const auto it = map.find(std::string(song_name));
     if (it == map.end()) {
@@ -230,6 +284,8 @@ std::vector<std::string> TagStore::tags_for_song(const std::string_view song_nam
 }
 
 std::vector<std::string> TagStore::list_all_tags() const {
+    SHEETMASTER_TRACE_SCOPE("TagStore::list_all_tags");
+    const std::lock_guard lock(storage_mutex());
     const TagMap map = load_map(storage_file_);
     std::set<std::string> unique;
     for (const auto& entry : map) {
@@ -240,30 +296,56 @@ std::vector<std::string> TagStore::list_all_tags() const {
     return std::vector<std::string>(unique.begin(), unique.end());
 }
 
+SongTagMap TagStore::load_all() const {
+    SHEETMASTER_TRACE_SCOPE("TagStore::load_all");
+    const std::lock_guard lock(storage_mutex());
+    return load_map(storage_file_);
+}
+
 void TagStore::set_tags_for_song(const std::string_view song_name, const std::vector<std::string>& tags) const {
+    SHEETMASTER_TRACE_SCOPE("TagStore::set_tags_for_song");
     const std::string key = trim(song_name);
     if (key.empty()) {
         return;
     }
 
+    const std::lock_guard lock(storage_mutex());
     TagMap map = load_map(storage_file_);
     map[key] = normalize_tags(tags);
     save_map(storage_file_, map);
 }
 
+void TagStore::replace_all(const SongTagMap& tags) const {
+    SHEETMASTER_TRACE_SCOPE("TagStore::replace_all");
+    TagMap map;
+    for (const auto& entry : tags) {
+        const std::string key = trim(entry.first);
+        if (!key.empty()) {
+            map[key] = normalize_tags(entry.second);
+        }
+    }
+
+    const std::lock_guard lock(storage_mutex());
+    save_map(storage_file_, map);
+}
+
 void TagStore::remove_song(const std::string_view song_name) const {
+    SHEETMASTER_TRACE_SCOPE("TagStore::remove_song");
+    const std::lock_guard lock(storage_mutex());
     TagMap map = load_map(storage_file_);
     map.erase(trim(song_name));
     save_map(storage_file_, map);
 }
 
 void TagStore::rename_song(const std::string_view old_song_name, const std::string_view new_song_name) const {
+    SHEETMASTER_TRACE_SCOPE("TagStore::rename_song");
     const std::string old_key = trim(old_song_name);
     const std::string new_key = trim(new_song_name);
     if (old_key.empty() || new_key.empty() || old_key == new_key) {
         return;
     }
 
+    const std::lock_guard lock(storage_mutex());
     TagMap map = load_map(storage_file_);
     const auto it = map.find(old_key);
     if (it == map.end()) {
@@ -0,0 +1,228 @@
+#include "piano_assist/trace.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+#include <utility>
+
+#include "piano_assist/memory_accounting.hpp"
+
+namespace piano_assist {
+
+// One thread's spans. Only the owning thread writes events; it publishes each one by
+// releasing size, and readers copy no further than the size they acquire.
+class TraceBuffer final {
+public:
+    TraceBuffer(const std::thread::id owner, const std::uint32_t track, const std::size_t capacity)
+        : owner(owner), track(track), capacity(capacity), events(std::make_unique<TraceEvent[]>(capacity)) {}
+
+    const std::thread::id owner;
+    const std::uint32_t track;
+    const std::size_t capacity;
+    const std::unique_ptr<TraceEvent[]> events;
+    std::atomic<std::size_t> size{0};
+    std::atomic<std::size_t> dropped{0};
+    // Guarded by the tracer's mutex.
+    std::string name{};
+};
+
+namespace {
+
+std::atomic<std::uint64_t> next_tracer_serial{1};
+
+// The buffer this thread last used, tagged with its tracer's serial so a buffer of a destroyed
+// tracer is never reused by a new one at the same address.
+struct CachedBuffer {
+    std::uint64_t serial{0};
+    TraceBuffer* buffer{nullptr};
+};
+
+thread_local CachedBuffer cached_buffer;
+
+std::string json_string(const std::string_view value) {
+    std::string out = "\"";
+    for (const char character : value) {
+        if (character == '"' || character == '\\') {
+            out.push_back('\\');
+        }
+        out.push_back(character);
+    }
+    out.push_back('"');
+    return out;
+}
+
+std::string microseconds(const std::chrono::nanoseconds value) {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(3) << static_cast<double>(value.count()) / 1000.0;
+    return out.str();
+}
+
+} // namespace
+
+Tracer::Tracer(const std::size_t events_per_thread)
+    : serial_(next_tracer_serial.fetch_add(1)),
+      events_per_thread_(std::max<std::size_t>(events_per_thread, 1)),
+      origin_(Clock::now()) {}
+
+Tracer::~Tracer() = default;
+
+void Tracer::enable(std::filesystem::path output_path) {
+    const std::lock_guard lock(mutex_);
+    output_path_ = std::move(output_path);
+    enabled_.store(true, std::memory_order_relaxed);
+}
+
+TraceBuffer& Tracer::buffer_for_this_thread() {
+    if (cached_buffer.serial == serial_) {
+        return *cached_buffer.buffer;
+    }
+
+    const std::lock_guard lock(mutex_);
+    const std::thread::id self = std::this_thread::get_id();
+    auto found = std::find_if(buffers_.begin(), buffers_.end(), [self](const std::unique_ptr<TraceBuffer>& buffer) {
+        return buffer->owner == self;
+    });
+    if (found == buffers_.end()) {
+        buffers_.push_back(std::make_unique<TraceBuffer>(self, static_cast<std::uint32_t>(buffers_.size() + 1), events_per_thread_));
+        found = std::prev(buffers_.end());
+    }
+    cached_buffer = CachedBuffer{serial_, found->get()};
+    return **found;
+}
+
+void Tracer::record(const char* name, const Clock::time_point start, const Clock::time_point end) {
+    TraceBuffer& buffer = buffer_for_this_thread();
+    const std::size_t index = buffer.size.load(std::memory_order_relaxed);
+    if (index >= buffer.capacity) {
+        buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    buffer.events[index] = TraceEvent{name, start - origin_, end - start};
+    buffer.size.store(index + 1, std::memory_order_release);
+}
+
+void Tracer::set_thread_name(const std::string_view name) {
+    if (!enabled()) {
+        return;
+    }
+    TraceBuffer& buffer = buffer_for_this_thread();
+    const std::lock_guard lock(mutex_);
+    buffer.name = std::string(name);
+}
+
+std::size_t Tracer::event_count() const {
+    const std::lock_guard lock(mutex_);
+    std::size_t count = 0;
+    for (const std::unique_ptr<TraceBuffer>& buffer : buffers_) {
+        count += buffer->size.load(std::memory_order_acquire);
+    }
+    return count;
+}
+
+std::size_t Tracer::dropped_count() const {
+    const std::lock_guard lock(mutex_);
+    std::size_t count = 0;
+    for (const std::unique_ptr<TraceBuffer>& buffer : buffers_) {
+        count += buffer->dropped.load(std::memory_order_relaxed);
+    }
+    return count;
+}
+
+std::string Tracer::to_json() const {
+    const std::size_t dropped = dropped_count();
+    const std::lock_guard lock(mutex_);
+    std::ostringstream out;
+    out << "{\"displayTimeUnit\": \"ms\", \"otherData\": {\"dropped_events\": " << dropped
+        << ", \"memory\": " << memory_usage_json() << "}, \"traceEvents\": [";
+    bool first = true;
+    const auto separator = [&first]() {
+        const char* text = first ? "\n" : ",\n";
+        first = false;
+        return text;
+    };
+    for (const std::unique_ptr<TraceBuffer>& buffer : buffers_) {
+        if (!buffer->name.empty()) {
+            out << separator() << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << buffer->track
+                << ", \"args\": {\"name\": " << json_string(buffer->name) << "}}";
+        }
+        const std::size_t size = buffer->size.load(std::memory_order_acquire);
+        for (std::size_t index = 0; index < size; ++index) {
+            const TraceEvent& event = buffer->events[index];
+            out << separator() << "{\"name\": " << json_string(event.name) << ", \"ph\": \"X\", \"ts\": "
+                << microseconds(event.start) << ", \"dur\": " << microseconds(event.duration)
+                << ", \"pid\": 1, \"tid\": " << buffer->track << '}';
+        }
+    }
+    // Memory is sampled once, as the trace is written; each subsystem becomes a counter track.
+    const std::string now = microseconds(Clock::now() - origin_);
+    for (const MemoryUsage& usage : memory_usage_snapshot()) {
+        out << separator() << "{\"name\": " << json_string("memory." + std::string(memory_subsystem_name(usage.subsystem)))
+            << ", \"ph\": \"C\", \"ts\": " << now << ", \"pid\": 1, \"args\": {\"live_bytes\": " << usage.live_bytes
+            << ", \"peak_bytes\": " << usage.peak_bytes << "}}";
+    }
+    out << "\n]}\n";
+    return out.str();
+}
+
+bool Tracer::write() const {
+    std::filesystem::path path;
+    {
+        const std::lock_guard lock(mutex_);
+        if (!enabled() || output_path_.empty()) {
+            return false;
+        }
+        path = output_path_;
+    }
+
+    const std::string trace = to_json();
+    std::error_code error;
+    if (path.has_parent_path()) {
+        std::filesystem::create_directories(path.parent_path(), error);
+    }
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out << trace;
+    return static_cast<bool>(out);
+}
+
+TraceSpan::TraceSpan(const char* name, Tracer& tracer) : name_(name), tracer_(tracer.enabled() ? &tracer : nullptr) {
+    if (tracer_ != nullptr) {
+        start_ = Tracer::Clock::now();
+    }
+}
+
+TraceSpan::TraceSpan(const char* name) : TraceSpan(name, tracer()) {}
+
+TraceSpan::~TraceSpan() {
+    if (tracer_ != nullptr) {
+        tracer_->record(name_, start_, Tracer::Clock::now());
+    }
+}
+
+Tracer& tracer() {
+    static Tracer instance;
+    return instance;
+}
+
+std::optional<std::filesystem::path> trace_output_path(const int argc, const char* const* argv) {
+    for (int index = 1; index < argc; ++index) {
+        const std::string_view argument = argv[index];
+        if (argument == kTraceFlag && index + 1 < argc) {
+            return std::filesystem::path(argv[index + 1]);
+        }
+        if (argument.size() > kTraceFlag.size() + 1 && argument.starts_with(kTraceFlag) &&
+            argument[kTraceFlag.size()] == '=') {
+            return std::filesystem::path(argument.substr(kTraceFlag.size() + 1));
+        }
+    }
+
+    const char* environment = std::getenv(std::string(kTraceEnvironmentVariable).c_str());
+    if (environment != nullptr && *environment != '\0') {
+        return std::filesystem::path(environment);
+    }
+    return std::nullopt;
+}
+
+} // namespace piano_assist
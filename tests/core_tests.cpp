@@ -1,9 +1,41 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
 #include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <future>
 #include <iostream>
+#include <iterator>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <thread>
 #include <vector>
 
+#include "piano_assist/autoplay.hpp"
+#include "piano_assist/chord_matcher.hpp"
+#include "piano_assist/compiled_sheet.hpp"
+#include "piano_assist/frame_pacer.hpp"
+#include "piano_assist/input_trace.hpp"
+#include "piano_assist/library_generator.hpp"
+#include "piano_assist/library_tools.hpp"
+#include "piano_assist/memory_accounting.hpp"
+#include "piano_assist/overlay_layout.hpp"
+#include "piano_assist/play_history.hpp"
+#include "piano_assist/playback_session.hpp"
+#include "piano_assist/resync_matcher.hpp"
+#include "piano_assist/scratch_arena.hpp"
+#include "piano_assist/sheet_preloader.hpp"
+#include "piano_assist/song_catalog.hpp"
+#include "piano_assist/song_list_diff.hpp"
 #include "piano_assist/song_parser.hpp"
+#include "piano_assist/song_query.hpp"
+#include "piano_assist/song_repository.hpp"
+#include "piano_assist/song_search.hpp"
+#include "piano_assist/startup_profiler.hpp"
+#include "piano_assist/tag_store.hpp"
+#include "piano_assist/trace.hpp"
 
 namespace {
 
@@ -14,9 +46,7 @@ void expect(bool condition, const std::string& message) {
     }
 }
 
-} // namespace
-
-int main() {
+void test_parse_sheet() {
     using piano_assist::NoteGroup;
     using piano_assist::parse_sheet;
 
@@ -25,6 +55,952 @@ int main() {
     expect(parsed[0].keys == "tf-", "first group should include sustain marker");
     expect(parsed[1].keys == "rd|", "second group should keep alternate sustain marker");
     expect(parsed[2].keys == "a", "third group should be single note");
+}
+
+void test_windowed_chord_matcher() {
+    using namespace std::chrono_literals;
+    using piano_assist::KeyEvent;
+    using piano_assist::KeyMask;
+    using piano_assist::chord_mask;
+    using piano_assist::key_slot;
+
+    expect(chord_mask("tf-") == chord_mask("TF"), "chord mask should ignore case and sustain markers");
+    expect(chord_mask("!") == chord_mask("1"), "shifted digits should share the digit key");
+    expect(chord_mask("`") == 0, "unmonitored keys should not produce a chord mask");
+
+    const auto slot = [](const char key) {
+        return static_cast<std::uint8_t>(*key_slot(key));
+    };
+
+    piano_assist::WindowedChordMatcher matcher(30ms);
+    matcher.reset(chord_mask("tfh"));
+    expect(!matcher.feed(KeyEvent{0ms, slot('t'), true}), "partial chord should not be accepted");
+    expect(!matcher.feed(KeyEvent{10ms, slot('t'), false}), "releases should not complete a chord");
+    expect(!matcher.feed(KeyEvent{20ms, slot('f'), true}), "partial chord should not be accepted");
+    expect(matcher.feed(KeyEvent{30ms, slot('h'), true}), "rolled chord inside the window should be accepted");
+
+    matcher.reset(chord_mask("tf"));
+    expect(!matcher.feed(KeyEvent{0ms, slot('t'), true}), "partial chord should not be accepted");
+    expect(!matcher.feed(KeyEvent{31ms, slot('f'), true}), "chord spread past the window should be rejected");
+    expect(matcher.feed(KeyEvent{40ms, slot('t'), true}), "window should restart from the late key");
+
+    matcher.reset(chord_mask("tf"));
+    expect(!matcher.feed(KeyEvent{0ms, slot('t'), true}), "partial chord should not be accepted");
+    expect(!matcher.feed(KeyEvent{5ms, slot('g'), true}), "extra key should not be accepted");
+    expect(!matcher.feed(KeyEvent{10ms, slot('f'), true}), "extra key in between should void the chord");
+
+    KeyMask edges_down = 0;
+    KeyMask edges_up = 0;
+    piano_assist::for_each_key_edge(0b0110, 0b1100, [&](const std::uint8_t edge_slot, const bool down) {
+        (down ? edges_down : edges_up) |= KeyMask{1} << edge_slot;
+    });
+    expect(edges_down == 0b1000 && edges_up == 0b0010, "key edges should report presses and releases");
+}
+
+void test_resync_matcher() {
+    using piano_assist::ResyncJump;
+    using piano_assist::chord_mask;
+
+    const piano_assist::CompiledSheet sheet = piano_assist::compile_sheet(
+        piano_assist::parse_sheet("a s d f g a s h j ", '[', ']', '-')
+    );
+    expect(sheet.next_same_mask[0] == 5, "repeated chords should link to their next occurrence");
+
+    piano_assist::ResyncMatcher matcher(4, 2);
+    matcher.load(&sheet);
+    expect(!matcher.observe(chord_mask("a")).has_value(), "current chord should never trigger a resync");
+    expect(!matcher.observe(chord_mask("h")).has_value(), "chords beyond the lookahead should be ignored");
+    expect(!matcher.observe(chord_mask("d")).has_value(), "a single matching chord should only be a candidate");
+    expect(matcher.has_candidate(), "matching chord inside the lookahead should become a candidate");
+
+    const std::optional<ResyncJump> jump = matcher.observe(chord_mask("f"));
+    expect(jump.has_value(), "continuing from the candidate should confirm the resync");
+    expect(jump->skipped_begin == 0 && jump->skipped_end == 2, "notes before the candidate should be skipped");
+    expect(jump->resume_at == 4, "playback should resume after the confirmed notes");
+
+    matcher.seek(jump->resume_at);
+    for (std::size_t cursor = 5; cursor <= 8; ++cursor) {
+        matcher.seek(cursor);
+    }
+    expect(!matcher.observe(chord_mask("g")).has_value(), "notes behind the cursor should not be candidates");
+
+    matcher.seek(2);
+    expect(!matcher.observe(chord_mask("a")).has_value(), "repeated chord ahead should be a candidate");
+    expect(matcher.observe(chord_mask("s")).has_value(), "window should index the first repeat after the cursor");
+}
+
+void test_playback_session() {
+    using namespace std::chrono_literals;
+    using piano_assist::CursorEvent;
+    using piano_assist::CursorEventKind;
+    using piano_assist::InputSample;
+    using piano_assist::chord_mask;
+
+    piano_assist::PlaybackSession session;
+    std::vector<CursorEvent> events;
+    session.subscribe([&events](const CursorEvent& event) {
+        events.push_back(event);
+    });
+    session.load(piano_assist::compile_sheet(piano_assist::parse_sheet("[tf] a s d ", '[', ']', '-')));
+    expect(events.size() == 1 && events[0].kind == CursorEventKind::Loaded, "loading should emit a cursor event");
+
+    session.tick(InputSample{0ms, chord_mask("t"), false});
+    session.tick(InputSample{8ms, 0, false});
+    session.tick(InputSample{16ms, chord_mask("f"), false});
+    expect(session.cursor() == 1, "rolled chord should advance the session");
+    expect(events.back().kind == CursorEventKind::Advanced, "advancing should emit a cursor event");
+
+    session.tick(InputSample{24ms, chord_mask("fa"), false});
+    expect(session.cursor() == 1, "held keys should block the next chord until released");
+    session.tick(InputSample{32ms, 0, false});
+    session.tick(InputSample{40ms, chord_mask("as"), false});
+    expect(session.cursor() == 1, "extra keys should not match in strict mode");
+
+    session.tick(InputSample{48ms, 0, true});
+    expect(session.paused() && events.back().kind == CursorEventKind::PauseChanged, "pause key should toggle");
+    session.tick(InputSample{56ms, chord_mask("a"), true});
+    expect(session.cursor() == 1, "paused session should ignore input");
+    session.tick(InputSample{64ms, 0, false});
+    session.tick(InputSample{72ms, 0, true});
+    expect(!session.paused(), "pause key should toggle back after release");
+
+    piano_assist::PlaybackOptions options = session.options();
+    options.strict_mode = false;
+    session.set_options(options);
+    session.tick(InputSample{80ms, 0, false});
+    session.tick(InputSample{88ms, chord_mask("z"), false});
+    expect(session.cursor() == 2, "any key should advance in non-strict mode");
+
+    session.seek(4);
+    expect(session.completed(), "seeking past the last group should complete the session");
+    session.clear();
+    expect(!session.loaded() && events.back().kind == CursorEventKind::Cleared, "clearing should unload the sheet");
+}
+
+void test_input_trace_round_trip() {
+    using namespace std::chrono_literals;
+    using piano_assist::InputSample;
+    using piano_assist::chord_mask;
+
+    piano_assist::InputTraceRecorder recorder;
+    recorder.begin("demo_song");
+    const std::vector<InputSample> samples = {
+        {1000ms, chord_mask("t"), false},
+        {1008ms, chord_mask("tf"), false},
+        {1016ms, 0, false},
+        {1024ms, chord_mask("ag"), false},
+        {1032ms, 0, false},
+        {1040ms, 0, true},
+        {1048ms, 0, false},
+    };
+    for (const InputSample& sample : samples) {
+        recorder.record(sample);
+    }
+    const std::optional<piano_assist::InputTrace> trace = recorder.finish();
+    expect(trace.has_value() && !recorder.active(), "finishing should hand over the recorded trace");
+
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "sheetmaster_core_tests.PATRACE";
+    piano_assist::write_input_trace(path, *trace);
+    const piano_assist::InputTrace loaded = piano_assist::read_input_trace(path);
+    std::filesystem::remove(path);
+
+    expect(loaded.song_id == "demo_song", "trace should keep the song id");
+    expect(loaded.records.size() == trace->records.size(), "trace should keep every record");
+    expect(loaded.records.front().timestamp.count() == 0, "timestamps should be relative to the first sample");
+    expect(loaded.records.back().timestamp == 48ms, "timestamps should survive delta encoding");
+
+    const piano_assist::CompiledSheet sheet =
+        piano_assist::compile_sheet(piano_assist::parse_sheet("[tf] a ", '[', ']', '-'));
+    piano_assist::PlaybackOptions options{};
+    const piano_assist::ReplayResult strict = piano_assist::replay_input_trace(loaded, sheet, options);
+    options.strict_mode = false;
+    const piano_assist::ReplayResult relaxed = piano_assist::replay_input_trace(loaded, sheet, options);
+    expect(strict.polls == samples.size(), "replay should tick once per recorded poll");
+    expect(strict.final_cursor == 1, "strict replay should reject the chord with an extra key");
+    expect(relaxed.completed, "non-strict replay should accept any key");
+}
+
+void test_autoplay_timeline() {
+    expect(piano_assist::sustain_steps("a--", '-') == 2, "trailing sustain markers should count as steps");
+    expect(piano_assist::sustain_steps("a|", '-') == 1, "bar lines should count as a sustain step");
+    expect(piano_assist::sustain_steps("a", '-') == 0, "plain groups should not sustain");
+
+    const piano_assist::CompiledSheet sheet =
+        piano_assist::compile_sheet(piano_assist::parse_sheet("a-- [tf] s ", '[', ']', '-'));
+    const piano_assist::AutoplayTimeline timeline = piano_assist::build_autoplay_timeline(sheet, '-', 180);
+    expect(timeline.group_count() == sheet.size(), "timeline should have one offset per group plus the end");
+    // 180 steps per minute: "a--" holds for three steps, the rest for one each.
+    const std::vector<std::chrono::nanoseconds> expected_offsets{
+        std::chrono::nanoseconds{0},
+        std::chrono::nanoseconds{1'000'000'000},
+        std::chrono::nanoseconds{1'333'333'333},
+        std::chrono::nanoseconds{1'666'666'666},
+    };
+    expect(timeline.offsets == expected_offsets, "offsets should be derived from whole step counts");
+
+    // The hold on an unbracketed note mid-sheet belongs to that note, not the one before it.
+    const piano_assist::CompiledSheet mid_sheet =
+        piano_assist::compile_sheet(piano_assist::parse_sheet("x y- z", '[', ']', '-'));
+    const std::vector<std::chrono::nanoseconds> expected_mid_offsets{
+        std::chrono::nanoseconds{0},
+        std::chrono::nanoseconds{333'333'333},
+        std::chrono::nanoseconds{1'000'000'000},
+        std::chrono::nanoseconds{1'333'333'333},
+    };
+    expect(piano_assist::build_autoplay_timeline(mid_sheet, '-', 180).offsets == expected_mid_offsets,
+        "a mid-sheet sustain should lengthen the note it follows");
+
+    std::mutex mutex;
+    std::vector<std::size_t> fired{};
+    piano_assist::DeadlineScheduler scheduler{std::chrono::microseconds{200}};
+    scheduler.start(piano_assist::build_autoplay_timeline(sheet, '-', 60'000), 0,
+        [&](const std::size_t index, std::chrono::nanoseconds /*lateness*/) {
+            const std::lock_guard lock(mutex);
+            fired.push_back(index);
+        });
+    const auto give_up = std::chrono::steady_clock::now() + std::chrono::seconds{5};
+    while (scheduler.running() && std::chrono::steady_clock::now() < give_up) {
+        std::this_thread::sleep_for(std::chrono::milliseconds{1});
+    }
+    scheduler.stop();
+    const std::lock_guard lock(mutex);
+    expect(fired == std::vector<std::size_t>{1, 2, 3}, "scheduler should fire every remaining boundary in order");
+}
+
+piano_assist::SongListView make_view(const std::vector<std::string>& ids, const piano_assist::SongTagMap& tags = {}) {
+    piano_assist::SongCatalog catalog;
+    piano_assist::SongListView view{};
+    for (const std::string& id : ids) {
+        const piano_assist::SongCatalog::Index index = catalog.add(id, id, id + ".PADATA", '[', ']', '-');
+        const auto it = tags.find(id);
+        if (it != tags.end()) {
+            catalog.set_tags(index, it->second);
+        }
+        view.rows.push_back(index);
+    }
+    view.catalog = std::make_shared<const piano_assist::SongCatalog>(std::move(catalog));
+    return view;
+}
+
+void test_song_list_diff() {
+    const piano_assist::SongListView before = make_view({"a", "b", "c", "d", "e"});
+    const piano_assist::SongListView after = make_view({"a", "c", "x", "y", "e", "z"}, {{"c", {"Jazz"}}});
+
+    const piano_assist::SongListDiff diff = piano_assist::diff_song_lists(before, after);
+    expect(!diff.reset, "sorted filtering should not require a reset");
+    expect(diff.removed.size() == 2, "separate removals should stay separate ranges");
+    expect(diff.removed[0].first == 3 && diff.removed[0].count == 1, "removals should be reported back to front");
+    expect(diff.removed[1].first == 1 && diff.removed[1].count == 1, "removals should use old indices");
+    expect(diff.inserted.size() == 2, "adjacent insertions should merge");
+    expect(diff.inserted[0].first == 2 && diff.inserted[0].count == 2, "insertions should use new indices");
+    expect(diff.inserted[1].first == 5 && diff.inserted[1].count == 1, "trailing insertion should be reported");
+    expect(diff.changed.size() == 1 && diff.changed[0].first == 1, "retagged rows should be reported as changed");
+
+    expect(piano_assist::diff_song_lists(before, before).empty(), "identical lists should produce no changes");
+    expect(piano_assist::diff_song_lists(before, make_view({"a", "b", "c", "d", "e"})).empty(),
+        "the same songs in a newer catalog should produce no changes");
+
+    const piano_assist::SongListView reordered = make_view({"b", "a"});
+    expect(piano_assist::diff_song_lists(before, reordered).reset, "reordered survivors should request a reset");
+}
+
+void test_song_search_worker() {
+    const std::filesystem::path folder = std::filesystem::temp_directory_path() / "sheetmaster_core_tests_search";
+    std::filesystem::remove_all(folder);
+
+    const piano_assist::SongRepository repository(folder);
+    repository.ensure_storage();
+    const piano_assist::TagStore tag_store(folder / "song_tags.PADISCRIM");
+    const piano_assist::PlayHistory play_history(folder / "play_history.PADISCRIM");
+    const std::string moonlight = repository.import_song("Moonlight Sonata", "a s d", '[', ']', '-');
+    const std::string minuet = repository.import_song("Minuet in G", "f g h", '[', ']', '-');
+    static_cast<void>(repository.import_song("Canon", "j k l", '[', ']', '-'));
+    tag_store.set_tags_for_song(moonlight, {"Classical"});
+    tag_store.set_tags_for_song(minuet, {"Classical", "Baroque"});
+
+    std::mutex mutex;
+    std::promise<piano_assist::SongSearchResult> delivered;
+    std::uint64_t awaited = 0;
+    piano_assist::SongSearchWorker worker(repository, tag_store, play_history, [&](piano_assist::SongSearchResult result) {
+        const std::lock_guard lock(mutex);
+        if (result.generation == awaited) {
+            delivered.set_value(std::move(result));
+        }
+    });
+
+    const auto submit = [&](piano_assist::SongSearchQuery query) {
+        std::future<piano_assist::SongSearchResult> future;
+        {
+            const std::lock_guard lock(mutex);
+            delivered = {};
+            future = delivered.get_future();
+            awaited = worker.submit(std::move(query));
+        }
+        expect(future.wait_for(std::chrono::seconds{5}) == std::future_status::ready, "search should complete");
+        return future.get();
+    };
+    const auto run = [&](std::string text, std::string tag) {
+        return submit(piano_assist::SongSearchQuery{piano_assist::SongQuery{std::move(text), std::move(tag)}});
+    };
+
+    const piano_assist::SongSearchResult all = run("", "");
+    const piano_assist::SongListView& all_songs = all.page.songs;
+    expect(all_songs.size() == 3 && !all.page.next.has_value(), "empty search should list every song");
+    expect(all_songs.catalog->name(all_songs.rows[0]) == "Canon", "results should keep catalog order");
+    expect((all.all_tags == std::vector<std::string>{"Baroque", "Classical"}), "all tags should be sorted and unique");
+
+    const piano_assist::SongSearchResult by_text = run("min", "");
+    const piano_assist::SongListView& text_songs = by_text.page.songs;
+    expect(text_songs.size() == 1 && text_songs.catalog->id(text_songs.rows[0]) == minuet,
+        "text search should filter by name");
+    expect(text_songs.catalog->tag_count(text_songs.rows[0]) == 2, "rows should carry their tags");
+
+    const piano_assist::SongSearchResult by_tag = run("", "Classical");
+    expect(by_tag.page.songs.size() == 2, "tag filter should keep tagged songs only");
+
+    // Without a reload the catalog already read is queried again, with play times kept current.
+    play_history.record_play(minuet, 50);
+    piano_assist::SongSearchQuery recent{};
+    recent.reload = false;
+    recent.query.sort = piano_assist::SongSortKey::RecentlyPlayed;
+    recent.query.limit = 1;
+    const piano_assist::SongSearchResult by_recent = submit(recent);
+    expect(by_recent.index->catalog() == by_tag.index->catalog(),
+        "a query without a reload should reuse the catalog");
+    expect(by_recent.page.songs.size() == 1 && by_recent.page.songs.catalog->id(by_recent.page.songs.rows[0]) == minuet &&
+               by_recent.page.next.has_value(),
+        "a play recorded after the load should lead the recently played order");
+
+    worker.stop();
+    std::filesystem::remove_all(folder);
+}
+
+void test_frame_pacer() {
+    using namespace std::chrono_literals;
+    piano_assist::FramePacer pacer{16ms};
+    const piano_assist::FramePacer::Clock::time_point start{};
+
+    expect(pacer.mark_dirty(start) == std::chrono::nanoseconds{0}, "first mark should flush immediately");
+    expect(!pacer.mark_dirty(start + 1ms).has_value(), "marks while scheduled should coalesce");
+    expect(pacer.begin_flush(start + 1ms), "scheduled flush should redraw");
+
+    // A burst of advances inside one frame costs one flush.
+    expect(pacer.mark_dirty(start + 5ms) == std::chrono::nanoseconds{12ms}, "next flush should wait for the frame");
+    for (int advance = 0; advance < 10; ++advance) {
+        expect(!pacer.mark_dirty(start + 6ms).has_value(), "burst marks should not reschedule");
+    }
+    expect(pacer.begin_flush(start + 17ms), "coalesced flush should redraw");
+    expect(!pacer.begin_flush(start + 18ms), "flush without marks should do nothing");
+    expect(pacer.marks() == 13 && pacer.flushes() == 2, "marks and flushes should be counted");
+
+    expect(pacer.mark_dirty(start + 100ms) == std::chrono::nanoseconds{0}, "idle pacer should flush immediately");
+}
+
+void test_overlay_layout() {
+    const piano_assist::OverlayLayout fixed = piano_assist::layout_fixed_lines(25, 10);
+    expect(fixed.lines.size() == 3, "fixed layout should chunk every ten notes");
+    expect(fixed.lines[2].begin == 20 && fixed.lines[2].end == 25, "last fixed line should hold the remainder");
+    expect(fixed.line_of_note.size() == 25 && fixed.line_of_note[19] == 1 && fixed.line_of_note[20] == 2,
+        "note lookup should map every note to its line");
+
+    const std::optional<piano_assist::OverlayLayout> source =
+        piano_assist::layout_source_lines("a s d\n\n[tf] g\r\nh", '[', ']', '-', 6);
+    expect(source.has_value() && source->lines.size() == 3, "source layout should follow non-empty text lines");
+    expect(source->lines[1].begin == 3 && source->lines[1].size() == 2, "source lines should be ranges over the sheet");
+    expect(!piano_assist::layout_source_lines("a s d", '[', ']', '-', 3).has_value(), "single-line text has no breaks");
+    expect(!piano_assist::layout_source_lines("a\ns", '[', ']', '-', 5).has_value(), "mismatched counts should be rejected");
+
+    std::vector<piano_assist::NoteGroup> groups(12, piano_assist::NoteGroup{"a", true});
+    groups[9].keys = "a-";
+    const piano_assist::OverlayLayout smart =
+        piano_assist::layout_smart_lines(piano_assist::compile_sheet(std::move(groups)), '-');
+    expect(smart.lines.size() == 2 && smart.lines[0].size() == 11, "smart layout should not break on a sustained note");
+}
+
+void test_fit_width_layout() {
+    const std::vector<double> widths(18, 10.0);
+    const auto sheet_with_sustain = [](const std::optional<std::size_t> sustained) {
+        std::vector<piano_assist::NoteGroup> groups(18, piano_assist::NoteGroup{"a", true});
+        if (sustained.has_value()) {
+            groups[*sustained].keys = "a-";
+        }
+        return piano_assist::compile_sheet(std::move(groups));
+    };
+
+    const piano_assist::OverlayLayout plain =
+        piano_assist::layout_fit_width_lines(sheet_with_sustain(std::nullopt), '-', widths, 0.0, 100.0);
+    expect(plain.lines.size() == 2 && plain.lines[0].size() == 10, "full lines should be preferred without sustains");
+    expect(plain.line_of_note.size() == 18, "fit-width layout should cover every note");
+
+    const piano_assist::OverlayLayout sustained =
+        piano_assist::layout_fit_width_lines(sheet_with_sustain(8), '-', widths, 0.0, 100.0);
+    expect(sustained.lines.size() == 2 && sustained.lines[0].size() == 9, "breaks should prefer sustained notes");
+
+    const std::vector<double> wide{10.0, 150.0, 10.0};
+    const piano_assist::OverlayLayout overflow = piano_assist::layout_fit_width_lines(
+        piano_assist::compile_sheet(std::vector<piano_assist::NoteGroup>(3, piano_assist::NoteGroup{"a", true})),
+        '-', wide, 0.0, 100.0);
+    expect(overflow.lines.size() == 3, "a token wider than the line should stand alone");
+
+    piano_assist::OverlayLayoutCache cache(2);
+    const piano_assist::OverlayLayoutKey first{"song", 1, "font", 900};
+    const piano_assist::OverlayLayoutKey second{"song", 1, "font", 800};
+    const piano_assist::OverlayLayoutKey third{"other", 2, "font", 900};
+    cache.insert(first, plain);
+    cache.insert(second, sustained);
+    expect(cache.find(first) != nullptr, "cached layouts should be found by key");
+    cache.insert(third, overflow);
+    expect(cache.find(second) == nullptr && cache.find(first) != nullptr, "least recently used layout should be evicted");
+    expect(piano_assist::sheet_fingerprint(sheet_with_sustain(8)) != piano_assist::sheet_fingerprint(sheet_with_sustain(std::nullopt)),
+        "edited sheets should get a new fingerprint");
+}
+
+void test_sheet_preloader() {
+    const std::filesystem::path folder = std::filesystem::temp_directory_path() / "sheetmaster_core_tests_preload";
+    std::filesystem::remove_all(folder);
+
+    const piano_assist::SongRepository repository(folder);
+    repository.ensure_storage();
+    static_cast<void>(repository.import_song("Etude", "a s d\nf g", '[', ']', '-'));
+    static_cast<void>(repository.import_song("Waltz", "q w e r", '[', ']', '-'));
+    const std::vector<piano_assist::Song> songs = repository.list_songs();
+    const piano_assist::Song& etude = songs[0];
+    const piano_assist::Song& waltz = songs[1];
+    constexpr auto mode = piano_assist::OverlayChunkingMode::AutoDetect;
+
+    piano_assist::SheetPreloader preloader(repository);
+    const auto wait_until_cached = [&preloader](const std::size_t count) {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{5};
+        while (preloader.cached_count() < count && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+        }
+    };
+    expect(!preloader.take(etude, mode).has_value(), "unrequested songs should not be prepared");
+
+    preloader.set_targets({etude}, mode);
+    wait_until_cached(1);
+    std::optional<piano_assist::PreparedSheet> prepared = preloader.take(etude, mode);
+    expect(prepared.has_value(), "targeted songs should be handed over");
+    expect(prepared->sheet.size() == 5 && prepared->sheet.groups[3].keys == "f", "preloaded sheet should match the file");
+    expect(prepared->overlay_layout.lines.size() == 2, "preloaded layout should follow source lines");
+    expect(!preloader.take(etude, mode).has_value(), "taken sheets should leave the cache");
+
+    preloader.set_targets({waltz}, mode);
+    wait_until_cached(1);
+    const std::optional<piano_assist::PreparedSheet> other_mode = preloader.take(waltz, piano_assist::OverlayChunkingMode::Smart);
+    expect(!other_mode.has_value(), "sheets laid out for another chunking mode should not be reused");
+
+    expect(preloader.cached_count() == 1, "a mode mismatch should leave the cached sheet alone");
+    repository.update_song_contents(waltz, "z x");
+    preloader.invalidate(waltz.id);
+    expect(preloader.cached_count() == 0, "invalidated songs should be dropped");
+    expect(!preloader.take(waltz, mode).has_value(), "invalidated songs should not be handed over");
 
+    preloader.stop();
+    std::filesystem::remove_all(folder);
+}
+
+void test_streamed_catalog_load() {
+    const std::filesystem::path folder = std::filesystem::temp_directory_path() / "sheetmaster_core_tests_stream";
+    std::filesystem::remove_all(folder);
+
+    const piano_assist::SongRepository repository(folder);
+    repository.ensure_storage();
+    for (int index = 0; index < 150; ++index) {
+        static_cast<void>(repository.import_song("Song " + std::to_string(1000 - index), "a s d", '[', ']', '-'));
+    }
+
+    std::vector<std::size_t> batch_sizes;
+    const piano_assist::SongCatalog catalog = repository.load_catalog("", {}, 64, [&](const piano_assist::SongCatalog& so_far) {
+        batch_sizes.push_back(so_far.size());
+    });
+    expect((batch_sizes == std::vector<std::size_t>{64, 128}), "batches should be reported as the catalog doubles");
+    expect(catalog.size() == 150 && catalog.name(catalog.sorted_rows().front()) == "Song 1000",
+        "the full listing should still be sorted");
+
+    std::mutex mutex;
+    std::vector<piano_assist::SongSearchResult> results;
+    std::promise<void> finished;
+    const piano_assist::TagStore tag_store(folder / "song_tags.PADISCRIM");
+    const piano_assist::PlayHistory play_history(folder / "play_history.PADISCRIM");
+    piano_assist::SongSearchWorker worker(repository, tag_store, play_history, [&](piano_assist::SongSearchResult result) {
+        const std::lock_guard lock(mutex);
+        const bool complete = result.complete;
+        results.push_back(std::move(result));
+        if (complete) {
+            finished.set_value();
+        }
+    });
+    piano_assist::SongSearchQuery query{};
+    query.stream = true;
+    static_cast<void>(worker.submit(std::move(query)));
+    expect(finished.get_future().wait_for(std::chrono::seconds{5}) == std::future_status::ready, "streamed load should complete");
+    worker.stop();
+
+    expect(results.size() == 3, "a streamed load should deliver two partial results and a complete one");
+    expect(results[0].page.songs.size() == 64 && !results[0].complete, "the first partial result should hold the first batch");
+    const auto sorted = [](const piano_assist::SongListView& songs) {
+        return std::is_sorted(songs.rows.begin(), songs.rows.end(), [&songs](const std::uint32_t lhs, const std::uint32_t rhs) {
+            return songs.catalog->name(lhs) < songs.catalog->name(rhs);
+        });
+    };
+    expect(sorted(results[0].page.songs) && sorted(results[1].page.songs), "partial results should be sorted");
+    expect(results[2].page.songs.size() == 150 && results[2].complete, "the last result should hold the whole catalog");
+
+    std::filesystem::remove_all(folder);
+}
+
+void test_startup_profiler() {
+    using namespace std::chrono_literals;
+    const piano_assist::StartupProfiler::Clock::time_point origin{};
+    piano_assist::StartupProfiler profiler(origin);
+    profiler.record("ignored", origin, origin + 1ms);
+    expect(profiler.phases().empty(), "a disabled profiler should record nothing");
+
+    const std::filesystem::path report = std::filesystem::temp_directory_path() / "sheetmaster_core_tests_startup.json";
+    std::filesystem::remove(report);
+    profiler.enable(report);
+    profiler.record("build_ui", origin + 2ms, origin + 5ms);
+    profiler.record("build_ui", origin + 9ms, origin + 10ms);
+    profiler.mark("first_paint", origin + 7ms);
+    std::thread([&profiler, origin]() {
+        profiler.record("ensure_storage", origin + 1ms, origin + 3ms);
+    }).join();
+
+    const std::vector<piano_assist::StartupPhase> phases = profiler.phases();
+    expect(phases.size() == 2 && phases[0].duration == 3ms, "only the first occurrence of a phase should count");
+    expect(phases[0].ui_thread && !phases[1].ui_thread, "phases should note which thread ran them");
+
+    const std::string json = profiler.to_json();
+    expect(json.find("\"total_ms\": 7.000") != std::string::npos, "total should end at the last phase or mark");
+    expect(json.find("\"ensure_storage\"") < json.find("\"build_ui\""), "phases should be ordered by start time");
+    expect(profiler.write_report() && std::filesystem::exists(report), "the report should be written when enabled");
+    expect(!profiler.write_report(), "the report should only be written once");
+
+    const char* flag_arguments[] = {"SheetMaster", "--startup-report=out/startup.json"};
+    const char* split_arguments[] = {"SheetMaster", "--startup-report", "startup.json"};
+    expect(piano_assist::startup_report_path(2, flag_arguments) == std::filesystem::path("out/startup.json"),
+        "the report flag should accept an inline path");
+    expect(piano_assist::startup_report_path(3, split_arguments) == std::filesystem::path("startup.json"),
+        "the report flag should accept a separate path");
+    std::filesystem::remove(report);
+}
+
+void test_tracer() {
+    piano_assist::Tracer tracer(4);
+    {
+        const piano_assist::TraceSpan span("ignored", tracer);
+    }
+    expect(tracer.event_count() == 0, "a disabled tracer should record nothing");
+
+    const std::filesystem::path output = std::filesystem::temp_directory_path() / "sheetmaster_core_tests_trace.json";
+    std::filesystem::remove(output);
+    tracer.enable(output);
+    tracer.set_thread_name("ui");
+    for (int index = 0; index < 6; ++index) {
+        const piano_assist::TraceSpan span("ui_span", tracer);
+    }
+    std::thread([&tracer]() {
+        tracer.set_thread_name("worker");
+        const piano_assist::TraceSpan span("worker_span", tracer);
+    }).join();
+
+    expect(tracer.event_count() == 5 && tracer.dropped_count() == 2, "spans past a thread's capacity should be dropped");
+    const std::string json = tracer.to_json();
+    expect(json.find("\"name\": \"worker_span\", \"ph\": \"X\"") != std::string::npos, "spans should be complete events");
+    expect(json.find("\"tid\": 2") != std::string::npos, "each thread should get its own track");
+    expect(json.find("\"args\": {\"name\": \"worker\"}") != std::string::npos, "thread names should be emitted as metadata");
+    expect(json.find("\"dropped_events\": 2") != std::string::npos, "dropped spans should be reported");
+    expect(json.find("\"name\": \"memory.compiled_sheet\", \"ph\": \"C\"") != std::string::npos,
+        "memory counters should be part of the trace");
+    expect(tracer.write() && std::filesystem::exists(output), "the trace should be written when enabled");
+
+    const char* arguments[] = {"SheetMaster", "--trace=slow.json"};
+    expect(piano_assist::trace_output_path(2, arguments) == std::filesystem::path("slow.json"),
+        "the trace flag should accept an inline path");
+    std::filesystem::remove(output);
+}
+
+void test_library_generator() {
+    piano_assist::SongDocument sample{};
+    sample.body = "[ab] c -\nd";
+    const piano_assist::LibraryProfile profile = piano_assist::profile_from_corpus({sample});
+    expect((profile.chord_sizes == std::vector<std::size_t>{2, 1, 1}), "chord sizes should be measured per note");
+    expect((profile.line_lengths == std::vector<std::size_t>{2, 1}), "line lengths should count notes");
+    expect(profile.keys == "abcd" && profile.sustain_rate > 0.3 && profile.sustain_rate < 0.4, "keys and sustains should be measured");
+
+    const std::filesystem::path root = std::filesystem::temp_directory_path() / "sheetmaster_core_tests_generator";
+    std::filesystem::remove_all(root);
+    piano_assist::LibraryOptions options{};
+    options.song_count = 80;
+    options.seed = 7;
+    options.legacy_rate = 0.25;
+    options.collision_rate = 0.2;
+    const piano_assist::LibraryProfile defaults = piano_assist::default_library_profile();
+    const piano_assist::GeneratedLibrary first = piano_assist::generate_library(root / "a", defaults, options);
+    static_cast<void>(piano_assist::generate_library(root / "b", defaults, options));
+
+    expect(first.modern_files + first.legacy_files == 80, "every song should be written");
+    expect(first.legacy_files > 0 && first.name_collisions > 0 && first.tagged_songs > 0, "legacy files, collisions and tags should appear");
+    bool identical = true;
+    for (const auto& entry : std::filesystem::directory_iterator(root / "a")) {
+        std::ifstream left(entry.path(), std::ios::binary);
+        std::ifstream right(root / "b" / entry.path().filename(), std::ios::binary);
+        const std::string left_bytes{std::istreambuf_iterator<char>(left), {}};
+        const std::string right_bytes{std::istreambuf_iterator<char>(right), {}};
+        identical = identical && right && left_bytes == right_bytes;
+    }
+    expect(identical, "the same seed should produce identical files");
+
+    const piano_assist::SongRepository repository(root / "a");
+    const std::vector<piano_assist::Song> songs = repository.list_songs();
+    expect(songs.size() == 80, "legacy files should migrate into the catalog");
+    bool all_parse = true;
+    for (const piano_assist::Song& song : songs) {
+        all_parse = all_parse && !repository.load_sheet(song).empty();
+    }
+    expect(all_parse, "every generated sheet should parse");
+    const piano_assist::TagStore tags(root / "a" / "song_tags.PADISCRIM");
+    expect(tags.load_all().size() <= first.tagged_songs && !tags.list_all_tags().empty(), "tags should be written for tagged songs");
+
+    std::filesystem::remove_all(root);
+}
+
+void test_library_tools() {
+    const std::vector<piano_assist::SheetIssue> issues = piano_assist::check_sheet_brackets("[ab] c]\n[d [e", '[', ']');
+    expect(issues.size() == 3, "stray, nested and unclosed brackets should be reported");
+    expect(issues[0].kind == piano_assist::SheetIssueKind::UnopenedGroup && issues[0].line == 1 && issues[0].column == 7,
+           "a stray closing bracket should be located");
+    expect(issues[1].kind == piano_assist::SheetIssueKind::NestedGroup && issues[1].line == 2 && issues[1].column == 4,
+           "a nested group should be located");
+    expect(issues[2].kind == piano_assist::SheetIssueKind::UnclosedGroup && issues[2].column == 4,
+           "an unclosed group should point at its last opening bracket");
+    expect(piano_assist::check_sheet_brackets("(ab) c\n(de)-", '(', ')').empty(), "well-formed sheets should pass");
+
+    const std::filesystem::path root = std::filesystem::temp_directory_path() / "sheetmaster_core_tests_tools";
+    std::filesystem::remove_all(root);
+    std::filesystem::create_directories(root / "in");
+    piano_assist::SongDocument document{};
+    document.id = "same_id";
+    document.display_name = "First";
+    document.body = "[ab] c -\n[def";
+    piano_assist::write_song_document(root / "in" / "First.PADATA", document);
+    document.display_name = "Second";
+    document.body = "g h";
+    piano_assist::write_song_document(root / "in" / "Second.PADATA", document);
+    {
+        std::ofstream legacy(root / "in" / "First.txt");
+        legacy << "()\n(ij) k\n";
+    }
+
+    const std::vector<piano_assist::SheetReport> reports = piano_assist::scan_library(root / "in", 2);
+    expect(reports.size() == 3 && reports[0].path.filename() == "First.PADATA", "reports should be in file name order");
+    expect(reports[0].issues.size() == 1 && reports[2].issues.empty(), "issues should be attached to their sheets");
+    const std::vector<piano_assist::DuplicateSongId> duplicates = piano_assist::find_duplicate_ids(reports);
+    expect(duplicates.size() == 1 && duplicates[0].paths.size() == 2, "a shared id should be reported once");
+
+    const piano_assist::LibraryStats stats = piano_assist::summarize_library(reports);
+    expect(stats.songs == 3 && stats.legacy_songs == 1 && stats.songs_with_issues == 1, "song counts should add up");
+    expect(stats.note_groups == 7 && stats.keys == 11, "notes and keys should exclude sustain marks");
+    expect((stats.chord_sizes == std::vector<std::size_t>{0, 4, 2, 1}), "the chord histogram should be indexed by size");
+
+    const piano_assist::ConvertedLibrary converted = piano_assist::convert_library(root / "in", root / "out", 2);
+    expect(converted.converted == 3 && converted.failed == 0, "every file should convert");
+    expect(std::filesystem::exists(root / "in" / "First.txt"), "conversion should leave the input untouched");
+    const piano_assist::SongDocument migrated = piano_assist::read_song_document(root / "out" / "First (2).PADATA");
+    expect(migrated.is_modern && migrated.id == "first_2" && migrated.open_brace == '(', "legacy files should convert like migration");
+
+    std::filesystem::remove_all(root);
+}
+
+} // namespace
+
+void test_memory_accounting() {
+    using piano_assist::MemorySubsystem;
+    const piano_assist::MemoryUsage before = piano_assist::memory_usage(MemorySubsystem::CompiledSheet);
+    piano_assist::reset_memory_peaks();
+    {
+        const piano_assist::CompiledSheet sheet = piano_assist::compile_sheet(piano_assist::parse_sheet("[ab] c d e ", '[', ']', '-'));
+        const piano_assist::MemoryUsage during = piano_assist::memory_usage(MemorySubsystem::CompiledSheet);
+        expect(during.live_bytes >= before.live_bytes + 4 * sizeof(piano_assist::NoteGroup),
+            "a compiled sheet should be charged to its subsystem");
+        expect(during.allocations >= before.allocations + 3, "each sheet vector should count as an allocation");
+    }
+    const piano_assist::MemoryUsage after = piano_assist::memory_usage(MemorySubsystem::CompiledSheet);
+    expect(after.live_bytes == before.live_bytes, "destroying the sheet should return its bytes");
+    expect(after.peak_bytes >= before.live_bytes + 4 * sizeof(piano_assist::NoteGroup), "the peak should survive the sheet");
+    expect(after.allocations - before.allocations == after.deallocations - before.deallocations,
+        "every block should be released");
+
+    expect(piano_assist::memory_usage_json().find("\"overlay_layout\": {\"live_bytes\": ") != std::string::npos,
+        "memory usage should be written per subsystem");
+}
+
+void test_scratch_arena() {
+    piano_assist::ScratchArena arena(256);
+    void* first = arena.resource()->allocate(64);
+    static_cast<void>(arena.resource()->allocate(4096));
+    arena.reset();
+    expect(arena.resource()->allocate(64) == first, "a reset arena should start over in its first block");
+    arena.reset();
+
+    const std::string sheet = "[tf]- a s\n\n[rd]| f ";
+    {
+        const std::pmr::vector<piano_assist::NoteGroup> scratch_groups =
+            piano_assist::parse_sheet(sheet, '[', ']', '-', arena.resource());
+        const std::vector<piano_assist::NoteGroup> groups = piano_assist::parse_sheet(sheet, '[', ']', '-');
+        expect(scratch_groups.size() == groups.size() && scratch_groups[2].keys == groups[2].keys &&
+                   scratch_groups[0].keys == "tf-",
+            "arena-backed parses should match plain ones");
+        expect(piano_assist::count_note_groups(sheet, '[', ']', '-') == groups.size(), "counting should agree with parsing");
+    }
+    arena.reset();
+
+    const std::filesystem::path folder = std::filesystem::temp_directory_path() / "sheetmaster_core_tests_arena";
+    std::filesystem::remove_all(folder);
+    const piano_assist::SongRepository repository(folder);
+    repository.ensure_storage();
+    static_cast<void>(repository.import_song("Nocturne", sheet, '[', ']', '-'));
+    std::ofstream(folder / "Legacy.txt") << "()\n(ab) c\nd";
+    const std::vector<piano_assist::Song> songs = repository.list_songs();
+    expect(songs.size() == 2 && songs[0].name == "Legacy" && songs[0].open_brace == '(' && songs[1].name == "Nocturne",
+        "listing should read metadata without the sheet text");
+
+    for (const piano_assist::Song& song : songs) {
+        const std::string text = repository.load_raw_sheet_text(song);
+        expect(std::string_view(repository.load_raw_sheet_text(song, arena.resource())) == text,
+            "arena-backed text should match the file");
+        const piano_assist::SongDocument document = piano_assist::read_song_document(folder / song.file_name, arena.resource());
+        const piano_assist::SongDocument plain_document = piano_assist::read_song_document(folder / song.file_name);
+        expect(document.body == text && document.id == plain_document.id && document.is_modern == plain_document.is_modern,
+            "arena-backed documents should match");
+
+        const auto prepared = piano_assist::prepare_sheet(
+            repository, song, piano_assist::OverlayChunkingMode::AutoDetect, {}, arena.resource()
+        );
+        arena.reset();
+        const auto plain = piano_assist::prepare_sheet(repository, song, piano_assist::OverlayChunkingMode::AutoDetect);
+        expect(prepared.has_value() && prepared->sheet.size() == plain->sheet.size() &&
+                   prepared->sheet.groups.back().keys == plain->sheet.groups.back().keys &&
+                   prepared->overlay_layout.lines.size() == plain->overlay_layout.lines.size(),
+            "a prepared sheet should outlive the arena it was built in");
+    }
+    std::filesystem::remove_all(folder);
+}
+
+void test_song_catalog() {
+    piano_assist::StringPool pool;
+    const piano_assist::StringHandle jazz = pool.intern("Jazz");
+    expect(pool.intern("Jazz") == jazz && pool.find("Jazz") == jazz, "interned strings should be stored once");
+    expect(pool.add("Jazz") != jazz && pool.find("Blues") == piano_assist::kNoString, "added strings should not be shared");
+    for (int index = 0; index < 100; ++index) {
+        static_cast<void>(pool.intern("tag " + std::to_string(index)));
+    }
+    expect(pool.find("Jazz") == jazz && pool.view(pool.find("tag 42")) == "tag 42", "interning should survive rehashing");
+    const std::string long_text(300, 'x');
+    const piano_assist::StringHandle long_handle = pool.add(long_text);
+    expect(pool.view(long_handle) == long_text && pool.view(jazz) == "Jazz", "lengths past one byte should read back");
+
+    const piano_assist::MemoryUsage before = piano_assist::memory_usage(piano_assist::MemorySubsystem::Catalog);
+    {
+        piano_assist::SongCatalog catalog;
+        const auto beta = catalog.add("beta", "beta", "beta.PADATA", '(', ')', '|');
+        const auto alpha_b = catalog.add("alpha_b", "Alpha", "Imported Alpha.PADATA", '[', ']', '-');
+        const auto alpha_a = catalog.add("alpha_a", "ALPHA", "ALPHA.PADATA", '[', ']', '-');
+        catalog.set_tags(alpha_a, std::vector<std::string>{"Jazz", "Live"});
+        catalog.set_tags(alpha_b, std::vector<std::string>{"Jazz"});
+
+        expect(sizeof(piano_assist::CatalogRecord) == 24, "a catalog record should stay at 24 bytes");
+        expect(catalog.collation_key(alpha_b) == "alpha" && catalog.name(alpha_b) == "Alpha", "keys should be case-folded");
+        expect(catalog.collation_key(beta).data() == catalog.name(beta).data(), "lowercase names should be their own key");
+        expect(catalog.file_name(beta) == "beta.PADATA" && catalog.file_name(alpha_a) == "ALPHA.PADATA" &&
+                   catalog.file_name(alpha_b) == "Imported Alpha.PADATA",
+            "rebuilt and stored file names should all read back");
+
+        const piano_assist::Song song = catalog.song(beta);
+        expect(song.id == "beta" && song.open_brace == '(' && song.close_brace == ')' && song.sustain_indicator == '|',
+            "packed grouping and sustain should round-trip");
+        expect(catalog.song(alpha_a).open_brace == '[' && catalog.song(alpha_a).sustain_indicator == '-',
+            "defaults should round-trip");
+
+        expect((catalog.sorted_rows() == piano_assist::CatalogRows{alpha_a, alpha_b, beta}),
+            "sorting should use the folded name, then the id");
+        expect(catalog.has_tag(alpha_a, "Live") && catalog.has_tag(alpha_b, "Jazz") && !catalog.has_tag(beta, "Jazz") &&
+                   !catalog.has_tag(alpha_b, "Blues"),
+            "tag checks should use the interned tags");
+        expect(catalog.tag_count(alpha_a) == 2 && catalog.tag(alpha_a, 1) == "Live", "tags should keep their order");
+
+        piano_assist::SongCatalog other;
+        const auto copy = other.add(catalog.song(alpha_b));
+        other.set_tags(copy, std::vector<std::string>{"Jazz"});
+        const auto renamed = other.add("beta", "Beta", "beta.PADATA", '(', ')', '|');
+        expect(catalog.same_contents(alpha_b, other, copy), "matching songs in another catalog should compare equal");
+        expect(!catalog.same_contents(beta, other, renamed), "a renamed song should differ");
+
+        const piano_assist::MemoryUsage during = piano_assist::memory_usage(piano_assist::MemorySubsystem::Catalog);
+        expect(during.live_bytes >= before.live_bytes + catalog.memory_bytes(), "catalog storage should be charged");
+    }
+    expect(piano_assist::memory_usage(piano_assist::MemorySubsystem::Catalog).live_bytes == before.live_bytes,
+        "catalog storage should be released with the catalog");
+}
+
+void test_play_history() {
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "sheetmaster_core_tests_play_history.PADISCRIM";
+    std::filesystem::remove(path);
+
+    const piano_assist::PlayHistory history(path);
+    expect(history.load_all().empty(), "a missing history should read as empty");
+
+    const std::uint64_t revision = piano_assist::PlayHistory::revision();
+    history.record_play("song_a", 100);
+    history.record_play("song_b", 200);
+    history.record_play("song_a", 300);
+    history.record_play("bad\tid", 400);
+    const piano_assist::PlayTimes played = history.load_all();
+    expect(played.size() == 2 && played.at("song_a") == 300 && played.at("song_b") == 200,
+        "the latest play of each song should be kept");
+    expect(piano_assist::PlayHistory::revision() > revision, "writes should bump the revision");
+
+    history.remove_song("song_a");
+    expect(history.load_all().size() == 1, "removed songs should leave the history");
+    std::filesystem::remove(path);
+}
+
+void test_song_query() {
+    const std::filesystem::path folder = std::filesystem::temp_directory_path() / "sheetmaster_core_tests_query";
+    std::filesystem::remove_all(folder);
+
+    const piano_assist::SongRepository repository(folder);
+    repository.ensure_storage();
+    const std::string waltz = repository.import_song("Waltz", "a s d f g h j k l z x c v", '[', ']', '-');
+    const std::string etude = repository.import_song("etude", "q w", '[', ']', '-');
+    const std::string blues = repository.import_song("Blues in C", "[zx] c v b n m", '[', ']', '-');
+    static_cast<void>(repository.import_song("Anthem", "a s d f", '[', ']', '-'));
+
+    const auto index_for = [&repository, &waltz, &blues](const piano_assist::PlayTimes& played) {
+        piano_assist::SongCatalog catalog = repository.load_catalog("", {});
+        const std::vector<std::string> jazz{"Jazz"};
+        for (piano_assist::SongCatalog::Index song = 0; song < catalog.size(); ++song) {
+            if (catalog.id(song) == waltz || catalog.id(song) == blues) {
+                catalog.set_tags(song, jazz);
+            }
+        }
+        return std::make_shared<const piano_assist::SongQueryIndex>(
+            std::make_shared<const piano_assist::SongCatalog>(std::move(catalog)),
+            repository,
+            played
+        );
+    };
+    const auto names = [](const piano_assist::SongPage& page) {
+        std::vector<std::string> result;
+        for (const std::uint32_t row : page.songs.rows) {
+            result.emplace_back(page.songs.catalog->name(row));
+        }
+        return result;
+    };
+    using Names = std::vector<std::string>;
+
+    const auto index = index_for({{etude, 100}, {blues, 300}, {"deleted_song", 500}});
+    piano_assist::SongQuery query{};
+    expect((names(index->run(query)) == Names{"Anthem", "Blues in C", "etude", "Waltz"}), "names should sort case-insensitively");
+    query.descending = true;
+    expect((names(index->run(query)) == Names{"Waltz", "etude", "Blues in C", "Anthem"}), "descending should reverse the order");
+
+    query = {};
+    query.sort = piano_assist::SongSortKey::Length;
+    expect((names(index->run(query)) == Names{"etude", "Anthem", "Blues in C", "Waltz"}), "length should put short sheets first");
+    query.sort = piano_assist::SongSortKey::RecentlyPlayed;
+    expect((names(index->run(query)) == Names{"Blues in C", "etude", "Anthem", "Waltz"}),
+        "recent plays should lead and unplayed songs follow by name");
+
+    query = {};
+    query.name = "  IN ";
+    expect((names(index->run(query)) == Names{"Blues in C"}), "the name predicate should be trimmed and case-insensitive");
+    query = {};
+    query.tag = "Jazz";
+    const piano_assist::SongPage tagged = index->run(query);
+    expect((names(tagged) == Names{"Blues in C", "Waltz"}) && tagged.examined == 2, "a tag should only walk its own songs");
+    query.sort = piano_assist::SongSortKey::Length;
+    query.descending = true;
+    query.limit = 1;
+    const piano_assist::SongPage longest = index->run(query);
+    query.after = longest.next;
+    expect((names(longest) == Names{"Waltz"}) && (names(index->run(query)) == Names{"Blues in C"}),
+        "a tag's songs should page in each sort order");
+    query = {};
+    query.tag = "Polka";
+    expect(index->run(query).songs.empty() && index->run(query).examined == 0, "an unknown tag should match nothing");
+    query = {};
+    query.content = "a s d";
+    expect((names(index->run(query)) == Names{"Anthem", "Waltz"}), "content should match the sheet text");
+    query.tag = "Jazz";
+    expect((names(index->run(query)) == Names{"Waltz"}), "predicates should combine");
+
+    query = {};
+    query.offset = 1;
+    query.limit = 2;
+    const piano_assist::SongPage window = index->run(query);
+    expect((names(window) == Names{"Blues in C", "etude"}) && window.next.has_value() && window.examined == 3,
+        "offset and limit should cut a window and stop there");
+    query.limit = 0;
+    expect(index->run(query).songs.empty(), "a zero limit should return nothing");
+    query.limit = piano_assist::kNoLimit;
+    expect(index->run(query, [] { return true; }).songs.empty(), "a stopped query should return nothing");
+
+    query = {};
+    query.limit = 2;
+    const piano_assist::SongPage first = index->run(query);
+    expect((names(first) == Names{"Anthem", "Blues in C"}) && first.next.has_value(), "the first page should leave a cursor");
+    // Songs added on either side of the cursor between pages neither repeat nor push rows out.
+    static_cast<void>(repository.import_song("Aria", "a", '[', ']', '-'));
+    static_cast<void>(repository.import_song("Bolero", "b", '[', ']', '-'));
+    const auto reloaded = index_for({});
+    query.after = first.next;
+    const piano_assist::SongPage second = reloaded->run(query);
+    expect((names(second) == Names{"Bolero", "etude"}) && second.next.has_value(), "the cursor should resume after the last row");
+    query.after = second.next;
+    const piano_assist::SongPage last = reloaded->run(query);
+    expect((names(last) == Names{"Waltz"}) && !last.next.has_value(), "the last page should have no cursor");
+
+    query = {};
+    query.descending = true;
+    query.limit = 2;
+    query.after = reloaded->run(query).next;
+    expect((names(reloaded->run(query)) == Names{"Bolero", "Blues in C"}), "a cursor should resume a descending walk");
+
+    query = {};
+    query.name = "walt";
+    expect(index->matches(query, waltz) && !index->matches(query, etude) && !index->matches(query, "deleted_song"),
+        "matches should apply the predicates to one song");
+    query.tag = "Jazz";
+    expect(index->matches(query, waltz) && !reloaded->matches(piano_assist::SongQuery{"", "Jazz"}, etude),
+        "matches should check tags");
+
+    std::filesystem::remove_all(folder);
+}
+
+int main() {
+    test_parse_sheet();
+    test_windowed_chord_matcher();
+    test_resync_matcher();
+    test_playback_session();
+    test_input_trace_round_trip();
+    test_autoplay_timeline();
+    test_song_list_diff();
+    test_song_search_worker();
+    test_streamed_catalog_load();
+    test_frame_pacer();
+    test_overlay_layout();
+    test_fit_width_layout();
+    test_sheet_preloader();
+    test_startup_profiler();
+    test_tracer();
+    test_library_generator();
+    test_library_tools();
+    test_memory_accounting();
+    test_scratch_arena();
+    test_song_catalog();
+    test_play_history();
+    test_song_query();
     return 0;
 }
@@ -0,0 +1,88 @@
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "piano_assist/library_generator.hpp"
+#include "piano_assist/song_repository.hpp"
+
+namespace {
+
+constexpr std::string_view kUsage =
+    " <output-folder> [--count <n>] [--seed <n>] [--corpus <sheet-folder>] [--legacy-rate <0..1>]"
+    " [--collision-rate <0..1>] [--tagged-rate <0..1>]\n";
+
+std::vector<piano_assist::SongDocument> read_corpus(const std::filesystem::path& folder) {
+    std::vector<piano_assist::SongDocument> corpus;
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(folder, error)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".PADATA") {
+            corpus.push_back(piano_assist::read_song_document(entry.path()));
+        }
+    }
+    return corpus;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0] << kUsage;
+        return 2;
+    }
+
+    const std::filesystem::path output(argv[1]);
+    std::filesystem::path corpus_folder("sheets");
+    piano_assist::LibraryOptions options{};
+    for (int index = 2; index < argc; ++index) {
+        const std::string_view argument = argv[index];
+        if (index + 1 >= argc) {
+            std::cerr << "usage: " << argv[0] << kUsage;
+            return 2;
+        }
+        const char* value = argv[++index];
+        if (argument == "--count") {
+            options.song_count = static_cast<std::size_t>(std::strtoull(value, nullptr, 10));
+        } else if (argument == "--seed") {
+            options.seed = std::strtoull(value, nullptr, 10);
+        } else if (argument == "--corpus") {
+            corpus_folder = value;
+        } else if (argument == "--legacy-rate") {
+            options.legacy_rate = std::strtod(value, nullptr);
+        } else if (argument == "--collision-rate") {
+            options.collision_rate = std::strtod(value, nullptr);
+        } else if (argument == "--tagged-rate") {
+            options.tagged_rate = std::strtod(value, nullptr);
+        } else {
+            std::cerr << "usage: " << argv[0] << kUsage;
+            return 2;
+        }
+    }
+
+    std::error_code error;
+    if (std::filesystem::exists(output, error) && !std::filesystem::is_empty(output, error)) {
+        std::cerr << "error: " << output.string() << " is not empty\n";
+        return 1;
+    }
+
+    try {
+        const std::vector<piano_assist::SongDocument> corpus = read_corpus(corpus_folder);
+        if (corpus.empty()) {
+            std::cerr << "note: no .PADATA files in " << corpus_folder.string() << ", using the built-in profile\n";
+        }
+        const piano_assist::GeneratedLibrary generated =
+            piano_assist::generate_library(output, piano_assist::profile_from_corpus(corpus), options);
+
+        std::cout << "generated " << options.song_count << " songs in " << output.string() << ": "
+                  << generated.modern_files << " modern, " << generated.legacy_files << " legacy, "
+                  << generated.name_collisions << " name collisions, " << generated.tagged_songs << " tagged, "
+                  << generated.notes << " notes (seed " << options.seed << ")\n";
+    } catch (const std::exception& exception) {
+        std::cerr << "error: " << exception.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,302 @@
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "bench_harness.hpp"
+#include "piano_assist/compiled_sheet.hpp"
+#include "piano_assist/library_tools.hpp"
+#include "piano_assist/song_parser.hpp"
+#include "piano_assist/song_repository.hpp"
+#include "piano_assist/tag_store.hpp"
+#include "piano_assist/trace.hpp"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr std::string_view kUsage =
+    "usage: sheetmaster-cli <command> [options] [--trace <trace.json>]\n"
+    "  (tracing also turns on with --trace=<trace.json> or SHEETMASTER_TRACE=<trace.json>)\n"
+    "  index <folder> [--json <path|->]       migrate legacy files and tags, then list the catalog\n"
+    "  verify <folder> [--jobs <n>]           report malformed brackets and duplicate ids\n"
+    "  convert <input> <output> [--jobs <n>]  write modern copies of every song file\n"
+    "  stats <folder> [--jobs <n>] [--json <path|->]\n"
+    "                                         note counts and chord-size histogram\n"
+    "  bench <folder> [--json <path|->] [--filter <text>] [--min-time-ms <n>] [--quick]\n"
+    "                                         time the catalog, parse and compile workloads (migrates like index)\n";
+
+struct Options {
+    std::vector<std::filesystem::path> folders{};
+    std::size_t jobs{0};
+    std::string json_path{};
+    std::string filter{};
+    std::chrono::milliseconds min_time{300};
+    std::size_t max_iterations{10'000};
+};
+
+int usage() {
+    std::cerr << kUsage;
+    return 2;
+}
+
+bool is_trace_assignment(const std::string_view argument) {
+    constexpr std::string_view flag = piano_assist::kTraceFlag;
+    return argument.size() > flag.size() && argument.starts_with(flag) && argument[flag.size()] == '=';
+}
+
+bool parse_options(const int argc, char* argv[], Options& options) {
+    for (int index = 2; index < argc; ++index) {
+        const std::string_view argument = argv[index];
+        const bool has_value = index + 1 < argc;
+        if (argument == "--jobs" && has_value) {
+            options.jobs = static_cast<std::size_t>(std::strtoull(argv[++index], nullptr, 10));
+        } else if (argument == "--json" && has_value) {
+            options.json_path = argv[++index];
+        } else if (argument == piano_assist::kTraceFlag && has_value) {
+            // Both trace forms are read by piano_assist::trace_output_path() in main, as in the GUI.
+            ++index;
+        } else if (is_trace_assignment(argument)) {
+            continue;
+        } else if (argument == "--filter" && has_value) {
+            options.filter = argv[++index];
+        } else if (argument == "--min-time-ms" && has_value) {
+            options.min_time = std::chrono::milliseconds(std::strtoll(argv[++index], nullptr, 10));
+        } else if (argument == "--quick") {
+            options.min_time = std::chrono::milliseconds(0);
+            options.max_iterations = 1;
+        } else if (argument.starts_with("--")) {
+            return false;
+        } else {
+            options.folders.emplace_back(argument);
+        }
+    }
+    return true;
+}
+
+std::string json_string(const std::string_view value) {
+    std::string escaped = "\"";
+    for (const char c : value) {
+        if (c == '"' || c == '\\') {
+            escaped.push_back('\\');
+            escaped.push_back(c);
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            std::ostringstream code;
+            code << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c);
+            escaped += code.str();
+        } else {
+            escaped.push_back(c);
+        }
+    }
+    escaped.push_back('"');
+    return escaped;
+}
+
+// "-" means stdout; returns false if the file can't be written.
+bool write_output(const std::string& path, const std::string& text) {
+    if (path == "-") {
+        std::cout << text;
+        return true;
+    }
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out << text;
+    return static_cast<bool>(out);
+}
+
+double elapsed_ms(const Clock::time_point started) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - started).count();
+}
+
+int run_index(const Options& options) {
+    const std::filesystem::path& folder = options.folders.front();
+    const Clock::time_point started = Clock::now();
+    const piano_assist::SongRepository repository(folder);
+    repository.ensure_storage();
+    const std::vector<piano_assist::Song> songs = repository.list_songs();
+    piano_assist::TagStore(folder / "song_tags.PADISCRIM").migrate_song_name_keys_to_ids(songs);
+
+    std::cerr << "indexed " << songs.size() << " songs in " << folder.string() << " (" << std::fixed
+              << std::setprecision(1) << elapsed_ms(started) << " ms)\n";
+    if (options.json_path.empty()) {
+        return 0;
+    }
+
+    std::ostringstream json;
+    json << "{\n  \"folder\": " << json_string(folder.string()) << ",\n  \"songs\": [";
+    for (std::size_t index = 0; index < songs.size(); ++index) {
+        const piano_assist::Song& song = songs[index];
+        json << (index == 0 ? "\n" : ",\n") << "    {\"id\": " << json_string(song.id)
+             << ", \"name\": " << json_string(song.name) << ", \"file\": " << json_string(song.file_name) << '}';
+    }
+    json << (songs.empty() ? "]" : "\n  ]") << "\n}\n";
+    if (!write_output(options.json_path, json.str())) {
+        std::cerr << "error: unable to write " << options.json_path << '\n';
+        return 1;
+    }
+    return 0;
+}
+
+int run_verify(const Options& options) {
+    const std::vector<piano_assist::SheetReport> reports = piano_assist::scan_library(options.folders.front(), options.jobs);
+    std::size_t problems = 0;
+    for (const piano_assist::SheetReport& report : reports) {
+        for (const piano_assist::SheetIssue& issue : report.issues) {
+            std::cout << report.path.string() << ':' << issue.line << ':' << issue.column << ": "
+                      << piano_assist::describe_sheet_issue(issue.kind) << '\n';
+            ++problems;
+        }
+    }
+    for (const piano_assist::DuplicateSongId& duplicate : piano_assist::find_duplicate_ids(reports)) {
+        std::cout << "duplicate id " << duplicate.id << ':';
+        for (const std::filesystem::path& path : duplicate.paths) {
+            std::cout << ' ' << path.string();
+        }
+        std::cout << '\n';
+        ++problems;
+    }
+
+    std::cerr << "verified " << reports.size() << " songs, " << problems << " problems\n";
+    return problems == 0 ? 0 : 1;
+}
+
+int run_convert(const Options& options) {
+    if (options.folders.size() < 2) {
+        return usage();
+    }
+    const piano_assist::ConvertedLibrary converted =
+        piano_assist::convert_library(options.folders[0], options.folders[1], options.jobs);
+    std::cerr << "converted " << converted.converted << " songs into " << options.folders[1].string() << ", "
+              << converted.failed << " failed\n";
+    return converted.failed == 0 ? 0 : 1;
+}
+
+int run_stats(const Options& options) {
+    const std::vector<piano_assist::SheetReport> reports = piano_assist::scan_library(options.folders.front(), options.jobs);
+    const piano_assist::LibraryStats stats = piano_assist::summarize_library(reports);
+
+    if (!options.json_path.empty()) {
+        std::ostringstream json;
+        json << "{\n  \"songs\": " << stats.songs << ",\n  \"legacy_songs\": " << stats.legacy_songs
+             << ",\n  \"note_groups\": " << stats.note_groups << ",\n  \"keys\": " << stats.keys
+             << ",\n  \"songs_with_issues\": " << stats.songs_with_issues << ",\n  \"chord_sizes\": [";
+        for (std::size_t size = 0; size < stats.chord_sizes.size(); ++size) {
+            json << (size == 0 ? "" : ", ") << stats.chord_sizes[size];
+        }
+        json << "]\n}\n";
+        if (!write_output(options.json_path, json.str())) {
+            std::cerr << "error: unable to write " << options.json_path << '\n';
+            return 1;
+        }
+        return 0;
+    }
+
+    std::cout << "songs: " << stats.songs << " (" << stats.legacy_songs << " legacy, " << stats.songs_with_issues
+              << " with bracket issues)\n"
+              << "note groups: " << stats.note_groups << "\nkeys: " << stats.keys << "\nchord sizes:\n";
+    for (std::size_t size = 1; size < stats.chord_sizes.size(); ++size) {
+        if (stats.chord_sizes[size] > 0) {
+            std::cout << "  " << size << ": " << stats.chord_sizes[size] << '\n';
+        }
+    }
+    return 0;
+}
+
+int run_bench(const Options& options) {
+    const std::filesystem::path& folder = options.folders.front();
+    const piano_assist::SongRepository repository(folder);
+    const std::vector<piano_assist::Song> songs = repository.list_songs();
+    std::vector<std::string> bodies;
+    for (const piano_assist::Song& song : songs) {
+        bodies.push_back(repository.load_raw_sheet_text(song) + " ");
+    }
+    const std::size_t note_groups = piano_assist::summarize_library(piano_assist::scan_library(folder)).note_groups;
+
+    piano_assist::bench::BenchRunner runner(options.min_time, options.max_iterations, options.filter);
+    runner.run("catalog.list_songs", songs.size(), [&repository] {
+        piano_assist::bench::keep(repository.list_songs().size());
+    });
+    runner.run("catalog.scan_serial", songs.size(), [&folder] {
+        piano_assist::bench::keep(piano_assist::scan_library(folder, 1).size());
+    });
+    runner.run("catalog.scan_parallel", songs.size(), [&folder] {
+        piano_assist::bench::keep(piano_assist::scan_library(folder).size());
+    });
+    runner.run("sheets.parse_compile", note_groups, [&songs, &bodies] {
+        std::size_t total = 0;
+        for (std::size_t index = 0; index < songs.size(); ++index) {
+            const piano_assist::Song& song = songs[index];
+            total += piano_assist::compile_sheet(
+                         piano_assist::parse_sheet(bodies[index], song.open_brace, song.close_brace, song.sustain_indicator)
+            )
+                         .size();
+        }
+        piano_assist::bench::keep(total);
+    });
+
+    piano_assist::bench::write_text(std::cerr, runner.results());
+    if (!options.json_path.empty()) {
+        std::ostringstream json;
+        piano_assist::bench::write_json(json, "sheetmaster-cli bench", runner.results());
+        if (!write_output(options.json_path, json.str())) {
+            std::cerr << "error: unable to write " << options.json_path << '\n';
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int run_command(const std::string_view command, const Options& options) {
+    try {
+        if (command == "index") {
+            return run_index(options);
+        }
+        if (command == "verify") {
+            return run_verify(options);
+        }
+        if (command == "convert") {
+            return run_convert(options);
+        }
+        if (command == "stats") {
+            return run_stats(options);
+        }
+        if (command == "bench") {
+            return run_bench(options);
+        }
+    } catch (const std::exception& exception) {
+        std::cerr << "error: " << exception.what() << '\n';
+        return 1;
+    }
+    return usage();
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options{};
+    if (argc < 3 || !parse_options(argc, argv, options) || options.folders.empty()) {
+        return usage();
+    }
+
+    // Chrome trace_event output for Perfetto; tracing stays off without it.
+    const std::optional trace_path = piano_assist::trace_output_path(argc, argv);
+    if (trace_path) {
+        piano_assist::tracer().enable(*trace_path);
+        piano_assist::tracer().set_thread_name("main");
+    }
+
+    const int exit_code = run_command(argv[1], options);
+    if (trace_path && !piano_assist::tracer().write()) {
+        std::cerr << "error: unable to write " << trace_path->string() << '\n';
+        return 1;
+    }
+    return exit_code;
+}
@@ -0,0 +1,57 @@
+#include <exception>
+#include <filesystem>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "piano_assist/compiled_sheet.hpp"
+#include "piano_assist/input_trace.hpp"
+#include "piano_assist/song_repository.hpp"
+
+namespace {
+
+void print_result(const std::string& label, const piano_assist::ReplayResult& result, const std::size_t total) {
+    std::cout << label << ": cursor " << result.final_cursor << '/' << total << ", advances " << result.advances
+              << ", resyncs " << result.resyncs << ", missed " << result.missed_groups << ", polls " << result.polls
+              << (result.completed ? ", completed" : "") << '\n';
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0] << " <trace.PATRACE> [sheet-folder]\n";
+        return 2;
+    }
+
+    try {
+        const piano_assist::InputTrace trace = piano_assist::read_input_trace(argv[1]);
+        const piano_assist::SongRepository repository(argc > 2 ? std::filesystem::path(argv[2]) : "sheets");
+
+        std::optional<piano_assist::Song> song;
+        for (const piano_assist::Song& candidate : repository.list_songs()) {
+            if (candidate.id == trace.song_id) {
+                song = candidate;
+                break;
+            }
+        }
+        if (!song.has_value()) {
+            std::cerr << "song '" << trace.song_id << "' not found\n";
+            return 1;
+        }
+
+        const piano_assist::CompiledSheet sheet = piano_assist::compile_sheet(repository.load_sheet(*song));
+        std::cout << "song: " << song->name << " (" << song->id << "), " << trace.records.size() << " records\n";
+
+        piano_assist::PlaybackOptions options{};
+        options.strict_mode = true;
+        print_result("strict", piano_assist::replay_input_trace(trace, sheet, options), sheet.size());
+        options.strict_mode = false;
+        print_result("non-strict", piano_assist::replay_input_trace(trace, sheet, options), sheet.size());
+    } catch (const std::exception& exception) {
+        std::cerr << "error: " << exception.what() << '\n';
+        return 1;
+    }
+    return 0;
+}